@@ -12,6 +12,8 @@
 #include "gs_ui_system.h"
 #include "gs_config.h"
 #include "gs_clubs.h"
+#include "Infrastructure/ImageProcessing/LensUndistortion.h"
+#include "Infrastructure/ImageProcessing/ScopedBallSearchSettings.h"
 
 #include "libcamera_interface.h"
 
@@ -48,6 +50,15 @@ double GolfSimCamera::kMaxDistanceFromTrajectory = 20.;
 
 int GolfSimCamera::kClosestBallPairEdgeBackoffPixels = 200;
 
+bool GolfSimCamera::kUseStrobedBallRoiTracking = false;
+double GolfSimCamera::kStrobedBallTrackingSeedScale = 0.5;
+double GolfSimCamera::kStrobedBallTrackingRoiMarginRatio = 1.5;
+int GolfSimCamera::kStrobedBallTrackingMinBalls = 3;
+
+bool GolfSimCamera::kUseMultiPairSpinFusion = false;
+double GolfSimCamera::kMultiPairSpinMaxRpmDeviation = 1500.0;
+int GolfSimCamera::kMultiPairSpinMinConsistentPairs = 2;
+
 double GolfSimCamera::kMaxIntermediateBallRadiusChangePercent = 10.0;
 double GolfSimCamera::kMaxPuttingIntermediateBallRadiusChangePercent = 10.0;
 double GolfSimCamera::kMaxOverlappedBallRadiusChangeRatio = 1.3;
@@ -197,6 +208,27 @@ GolfSimCamera::GolfSimCamera()
     GolfSimConfiguration::SetConstant(
         "gs_config.ball_exposure_selection.kClosestBallPairEdgeBackoffPixels",
         kClosestBallPairEdgeBackoffPixels);
+
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_exposure_selection.kUseStrobedBallRoiTracking",
+        kUseStrobedBallRoiTracking);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_exposure_selection.kStrobedBallTrackingSeedScale",
+        kStrobedBallTrackingSeedScale);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_exposure_selection.kStrobedBallTrackingRoiMarginRatio",
+        kStrobedBallTrackingRoiMarginRatio);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_exposure_selection.kStrobedBallTrackingMinBalls",
+        kStrobedBallTrackingMinBalls);
+
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kUseMultiPairSpinFusion",
+                                      kUseMultiPairSpinFusion);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kMultiPairSpinMaxRpmDeviation",
+                                      kMultiPairSpinMaxRpmDeviation);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.spin_analysis.kMultiPairSpinMinConsistentPairs",
+        kMultiPairSpinMinConsistentPairs);
     GolfSimConfiguration::SetConstant("gs_config.ball_exposure_selection.kMaxBallsToRetain",
                                       kMaxBallsToRetain);
 
@@ -495,7 +527,8 @@ bool GolfSimCamera::GetCalibratedBall(const GolfSimCamera &camera,
                                       const cv::Mat &rgbImg,
                                       GolfBall &b,
                                       const cv::Vec2i &expectedBallCenter,
-                                      const bool expectBall)
+                                      const bool expectBall,
+                                      const bool image_is_distorted)
 {
     GS_LOG_TRACE_MSG(trace, "GetCalibratedBall");
 
@@ -708,6 +741,28 @@ bool GolfSimCamera::GetCalibratedBall(const GolfSimCamera &camera,
     // We were able to discern a circle that the system thinks is a ball -
     // return the ball with the information corresponding to it inside
 
+    if (image_is_distorted)
+    {
+        cv::Vec3f undistorted_circle;
+
+        if (!LensUndistortion::UndistortCircle(b.ball_circle_,
+                                               camera.camera_hardware_.calibrationMatrix_,
+                                               camera.camera_hardware_.cameraDistortionVector_,
+                                               undistorted_circle))
+        {
+            GS_LOG_MSG(error, "GetCalibratedBall could not undistort the ball's circle.");
+            return false;
+        }
+
+        GS_LOG_TRACE_MSG(trace,
+                         "GetCalibratedBall undistorted ball circle (x, y, r) = " +
+                         std::to_string(undistorted_circle[0]) + ", " +
+                         std::to_string(undistorted_circle[1]) + ", " +
+                         std::to_string(undistorted_circle[2]));
+
+        b.set_circle(undistorted_circle);
+    }
+
     // Setup a ball to return with all the pertinent information
     b.measured_radius_pixels_ = b.ball_circle_[2];
 
@@ -2855,6 +2910,354 @@ void GolfSimCamera::ReportBallSearchError(const int number_balls_found)
     GS_LOG_MSG(error, root_cause_str);
 }
 
+bool GolfSimCamera::FindStrobedBallsInRoi(const cv::Mat &strobed_balls_color_image,
+                                          const GolfBall &search_ball,
+                                          const cv::Rect &roi,
+                                          double scale,
+                                          double min_radius,
+                                          double max_radius,
+                                          std::vector<GolfBall> &balls)
+{
+    balls.clear();
+
+    cv::Rect search_roi = roi & cv::Rect(0, 0, strobed_balls_color_image.cols,
+                                         strobed_balls_color_image.rows);
+
+    if (search_roi.width < 4 || search_roi.height < 4 || scale <= 0.0)
+    {
+        return false;
+    }
+
+    cv::Mat search_image;
+
+    if (scale != 1.0)
+    {
+        cv::resize(strobed_balls_color_image(search_roi),
+                   search_image,
+                   cv::Size(),
+                   scale,
+                   scale,
+                   cv::INTER_AREA);
+    }
+    else
+    {
+        search_image = strobed_balls_color_image(search_roi);
+    }
+
+    BallImageProc *ip = get_image_processor();
+    bool result = false;
+
+    {
+        // The image processor's own settings are put back after the search
+        ScopedBallSearchSettings search_settings(ip->color_mask_image_,
+                                                 ip->min_ball_radius_,
+                                                 ip->max_ball_radius_,
+                                                 (int)(min_radius * scale),
+                                                 (int)std::ceil(max_radius * scale));
+
+        cv::Rect no_roi;
+        result = ip->GetBall(search_image,
+                             search_ball,
+                             balls,
+                             no_roi,
+                             BallImageProc::BallSearchMode::kStrobed,
+                             false,
+                             false);
+    }
+
+    for (GolfBall &b : balls)
+    {
+        const cv::Vec3f &c = b.ball_circle_;
+        b.set_circle(cv::Vec3f((float)(c[0] / scale + search_roi.x),
+                               (float)(c[1] / scale + search_roi.y),
+                               (float)(c[2] / scale)));
+    }
+
+    return result && !balls.empty();
+}
+
+bool GolfSimCamera::TrackStrobedBalls(const cv::Mat &strobed_balls_color_image,
+                                      const GolfBall &search_ball,
+                                      std::vector<GolfBall> &tracked_balls)
+{
+    tracked_balls.clear();
+
+    BallImageProc *ip = get_image_processor();
+    const cv::Rect full_image(0, 0, strobed_balls_color_image.cols,
+                              strobed_balls_color_image.rows);
+
+    // Only the seed pair needs a search of the whole image, and it does not
+    // need to be precise, so do it on a smaller image
+    std::vector<GolfBall> seed_balls;
+
+    if (!FindStrobedBallsInRoi(strobed_balls_color_image,
+                               search_ball,
+                               full_image,
+                               kStrobedBallTrackingSeedScale,
+                               ip->min_ball_radius_,
+                               ip->max_ball_radius_,
+                               seed_balls) || seed_balls.size() < 2)
+    {
+        GS_LOG_TRACE_MSG(trace, "TrackStrobedBalls - could not find a seed pair of balls.");
+        return false;
+    }
+
+    // The seed pair is the best ball and the nearest of the next-best balls
+    // that could be another image of the same ball.  GetBall returns the
+    // balls sorted by quality.
+    const int kMaxSeedPairCandidates = 6;
+    const GolfBall &first_seed = seed_balls[0];
+    int second_seed_index = -1;
+    double second_seed_distance = 0.0;
+
+    for (int i = 1; i < std::min((int)seed_balls.size(), kMaxSeedPairCandidates); i++)
+    {
+        const GolfBall &b = seed_balls[i];
+        double radius_ratio = b.measured_radius_pixels_ / first_seed.measured_radius_pixels_;
+        double distance = cv::norm(b.center() - first_seed.center());
+
+        if (radius_ratio > kMaxOverlappedBallRadiusChangeRatio ||
+            radius_ratio < 1.0 / kMaxOverlappedBallRadiusChangeRatio ||
+            distance < 0.5 * (b.measured_radius_pixels_ + first_seed.measured_radius_pixels_))
+        {
+            continue;
+        }
+
+        if (second_seed_index < 0 || distance < second_seed_distance)
+        {
+            second_seed_index = i;
+            second_seed_distance = distance;
+        }
+    }
+
+    if (second_seed_index < 0)
+    {
+        GS_LOG_TRACE_MSG(trace, "TrackStrobedBalls - no usable second seed ball.");
+        return false;
+    }
+
+    // Re-find each seed ball at full resolution, keeping the reduced-size
+    // result if that fails
+    std::vector<GolfBall> track = { first_seed, seed_balls[second_seed_index] };
+
+    for (GolfBall &seed : track)
+    {
+        double r = seed.measured_radius_pixels_;
+        double half_size = r * (1.0 + kStrobedBallTrackingRoiMarginRatio);
+        cv::Rect seed_roi((int)(seed.x() - half_size), (int)(seed.y() - half_size),
+                          (int)(2 * half_size), (int)(2 * half_size));
+        std::vector<GolfBall> found_balls;
+
+        if (!FindStrobedBallsInRoi(strobed_balls_color_image,
+                                   search_ball,
+                                   seed_roi,
+                                   1.0,
+                                   r / kMaxOverlappedBallRadiusChangeRatio,
+                                   r * kMaxOverlappedBallRadiusChangeRatio,
+                                   found_balls))
+        {
+            continue;
+        }
+
+        auto closest = std::min_element(found_balls.begin(),
+                                        found_balls.end(),
+                                        [&](const GolfBall &a, const GolfBall &b)
+            {
+                return cv::norm(a.center() - seed.center()) < cv::norm(b.center() - seed.center());
+            });
+
+        if (cv::norm(closest->center() - seed.center()) < 0.5 * r)
+        {
+            seed = *closest;
+        }
+    }
+
+    // We don't yet know which pulse interval separates any two balls (that
+    // is worked out later from the ball spacing).  But the next spacing can
+    // only differ from the last one by one of the ratios of adjacent pulse
+    // intervals.
+    std::vector<float> pulse_intervals = PulseStrobe::GetPulseIntervals();
+    pulse_intervals.erase(std::remove_if(pulse_intervals.begin(),
+                                         pulse_intervals.end(),
+                                         [](float interval)
+        {
+            return interval <= 0.0001f;
+        }),
+                          pulse_intervals.end());
+
+    double min_step_ratio = 1.0;
+    double max_step_ratio = 1.0;
+
+    for (size_t i = 1; i < pulse_intervals.size(); i++)
+    {
+        double ratio = pulse_intervals[i] / pulse_intervals[i - 1];
+        min_step_ratio = std::min({ min_step_ratio, ratio, 1.0 / ratio });
+        max_step_ratio = std::max({ max_step_ratio, ratio, 1.0 / ratio });
+    }
+
+    // There cannot be more balls than there were pulses
+    size_t max_balls = pulse_intervals.empty() ? (size_t)kMaxBallsToRetain :
+                       pulse_intervals.size() + 1;
+
+    // Where the seed pair is in the track
+    size_t seeds_index = 0;
+
+    // Extends the track by one ball at its front or back.  Returns false if
+    // no ball was found where the next one should be.
+    auto extendTrack = [&](bool at_back)
+                       {
+                           const GolfBall &last = at_back ? track[track.size() - 1] : track[0];
+                           const GolfBall &prior = at_back ? track[track.size() - 2] : track[1];
+
+                           cv::Point2f step_vector = last.center() - prior.center();
+                           double step = cv::norm(step_vector);
+
+                           if (step < 1.0)
+                           {
+                               return false;
+                           }
+
+                           // Constant velocity along the best-fit line through
+                           // all the balls so far
+                           std::vector<cv::Point2f> centers;
+
+                           for (const GolfBall &b : track)
+                           {
+                               centers.push_back(b.center());
+                           }
+
+                           cv::Vec4f line;
+                           cv::fitLine(centers, line, cv::DIST_L2, 0, 0.01, 0.01);
+                           cv::Point2f direction(line[0], line[1]);
+
+                           if (direction.dot(step_vector) < 0.0f)
+                           {
+                               direction = -direction;
+                           }
+
+                           // The radius is assumed to keep changing at the
+                           // same rate
+                           double predicted_radius = std::clamp(
+                               2.0 * last.measured_radius_pixels_ - prior.measured_radius_pixels_,
+                               (double)ip->min_ball_radius_,
+                               (double)ip->max_ball_radius_);
+                           double margin = predicted_radius * kStrobedBallTrackingRoiMarginRatio;
+
+                           cv::Point2f nearest = last.center() +
+                                                 direction * (float)(step * min_step_ratio);
+                           cv::Point2f furthest = last.center() +
+                                                  direction * (float)(step * max_step_ratio);
+
+                           cv::Rect segment_box((cv::Point)nearest, (cv::Point)furthest);
+                           cv::Rect search_roi = cv::Rect(segment_box.x - (int)margin,
+                                                          segment_box.y - (int)margin,
+                                                          segment_box.width + 2 * (int)margin,
+                                                          segment_box.height + 2 * (int)margin) &
+                                                 full_image;
+
+                           if (search_roi.area() == 0)
+                           {
+                               // The next ball would be outside the image
+                               return false;
+                           }
+
+                           std::vector<GolfBall> found_balls;
+
+                           if (!FindStrobedBallsInRoi(strobed_balls_color_image,
+                                                      search_ball,
+                                                      search_roi,
+                                                      1.0,
+                                                      predicted_radius /
+                                                      kMaxOverlappedBallRadiusChangeRatio,
+                                                      predicted_radius *
+                                                      kMaxOverlappedBallRadiusChangeRatio,
+                                                      found_balls))
+                           {
+                               return false;
+                           }
+
+                           // The next ball is the closest one that is on the
+                           // line and no closer than the shortest possible step
+                           int next_index = -1;
+                           double next_along = 0.0;
+
+                           for (size_t i = 0; i < found_balls.size(); i++)
+                           {
+                               cv::Point2f offset = found_balls[i].center() - last.center();
+                               double along = offset.dot(direction);
+                               double across = std::abs(offset.x * direction.y -
+                                                        offset.y * direction.x);
+
+                               if (across > kMaxDistanceFromTrajectory ||
+                                   along < std::max(step * min_step_ratio - margin,
+                                                    0.5 * predicted_radius) ||
+                                   along > step * max_step_ratio + margin)
+                               {
+                                   continue;
+                               }
+
+                               if (next_index < 0 || along < next_along)
+                               {
+                                   next_index = (int)i;
+                                   next_along = along;
+                               }
+                           }
+
+                           if (next_index < 0)
+                           {
+                               return false;
+                           }
+
+                           if (at_back)
+                           {
+                               track.push_back(found_balls[next_index]);
+                           }
+                           else
+                           {
+                               track.insert(track.begin(), found_balls[next_index]);
+                               seeds_index++;
+                           }
+
+                           return true;
+                       };
+
+    while (track.size() < max_balls && extendTrack(true))
+    {
+    }
+
+    while (track.size() < max_balls && extendTrack(false))
+    {
+    }
+
+    GS_LOG_TRACE_MSG(trace,
+                     "TrackStrobedBalls tracked " + std::to_string(track.size()) + " balls.");
+
+    if ((int)track.size() < kStrobedBallTrackingMinBalls)
+    {
+        return false;
+    }
+
+    // The rest of the analysis expects the best balls first, and the seed
+    // pair is the best we have
+    tracked_balls.push_back(track[seeds_index]);
+    tracked_balls.push_back(track[seeds_index + 1]);
+
+    for (size_t i = 0; i < track.size(); i++)
+    {
+        if (i != seeds_index && i != seeds_index + 1)
+        {
+            tracked_balls.push_back(track[i]);
+        }
+    }
+
+    for (size_t i = 0; i < tracked_balls.size(); i++)
+    {
+        tracked_balls[i].quality_ranking = (uint)i;
+    }
+
+    return true;
+}
+
 bool GolfSimCamera::AnalyzeStrobedBalls( const cv::Mat &strobed_balls_color_image,
                                          const cv::Mat &strobed_balls_gray_image,
                                          const GolfBall &calibrated_ball,
@@ -2961,13 +3364,43 @@ bool GolfSimCamera::AnalyzeStrobedBalls( const cv::Mat &strobed_balls_color_imag
     GolfBall non_const_ball = calibrated_ball;
     non_const_ball.average_color_ = cv::Scalar(0, 0, 0);
 
-    bool result = ip->GetBall(strobed_balls_color_image,
-                              non_const_ball,
-                              initial_balls,
-                              roi,
-                              processing_mode,
-                              useLargestFoundBall,
-                              dontReportErrors);
+    bool result = false;
+
+    if (kUseStrobedBallRoiTracking && processing_mode == BallImageProc::BallSearchMode::kStrobed)
+    {
+        result = TrackStrobedBalls(strobed_balls_color_image, non_const_ball, initial_balls);
+
+        if (!result)
+        {
+            GS_LOG_TRACE_MSG(trace,
+                             "Strobed ball tracking failed.  Falling back to a full-image search.");
+            initial_balls.clear();
+        }
+    }
+
+    if (!result && BallImageProc::kUseConcurrentHoughStrategies &&
+        processing_mode == BallImageProc::BallSearchMode::kStrobed)
+    {
+        // We need at least two balls
+        result = ip->GetBallWithConcurrentHoughStrategies(strobed_balls_color_image,
+                                                          non_const_ball,
+                                                          initial_balls,
+                                                          roi,
+                                                          processing_mode,
+                                                          useLargestFoundBall,
+                                                          dontReportErrors,
+                                                          2);
+    }
+    else if (!result)
+    {
+        result = ip->GetBall(strobed_balls_color_image,
+                             non_const_ball,
+                             initial_balls,
+                             roi,
+                             processing_mode,
+                             useLargestFoundBall,
+                             dontReportErrors);
+    }
 
     int number_of_initial_balls = (int)initial_balls.size();
 
@@ -4778,6 +5211,17 @@ bool GolfSimCamera::ProcessSpin(GolfSimCamera &camera,
                                 GolfBall &result_ball,
                                 cv::Vec3d &rotationResults)
 {
+    if (kUseMultiPairSpinFusion)
+    {
+        if (ProcessMultiPairSpin(camera, strobed_balls_gray_image,
+                                 non_overlapping_balls_and_timing, result_ball, rotationResults))
+        {
+            return true;
+        }
+
+        GS_LOG_TRACE_MSG(trace, "ProcessSpin - multi-pair spin failed.  Using best single pair.");
+    }
+
     GolfBall spin_ball1;
     GolfBall spin_ball2;
     double spin_timing_interval_uS = 0.0;
@@ -4843,6 +5287,152 @@ bool GolfSimCamera::ProcessSpin(GolfSimCamera &camera,
     return true;
 }
 
+bool GolfSimCamera::ProcessMultiPairSpin(GolfSimCamera &camera,
+                                         const cv::Mat &strobed_balls_gray_image,
+                                         const GsBallsAndTimingVector &non_overlapping_balls_and_timing,
+                                         GolfBall &result_ball,
+                                         cv::Vec3d &rotationResults)
+{
+    // The balls are in strobe order, and each element holds the interval
+    // from the previous ball, so only adjacent pairs have a known interval.
+    std::vector<GolfBall> pair_balls1;
+    std::vector<GolfBall> pair_balls2;
+    std::vector<double> pair_intervals_uS;
+
+    for (size_t i = 1; i < non_overlapping_balls_and_timing.size(); i++)
+    {
+        GolfBall ball1 = non_overlapping_balls_and_timing[i - 1].ball;
+        GolfBall ball2 = non_overlapping_balls_and_timing[i].ball;
+        double interval_uS = non_overlapping_balls_and_timing[i].time_interval_before_ball_us;
+
+        // Same overlap test as FindBestTwoSpinBalls - overlapping balls are
+        // too smudgy for a good spin calculation
+        double pair_proximity = (double)ball1.PixelDistanceFromBall(ball2);
+
+        if (interval_uS <= 0.0 ||
+            pair_proximity <
+            0.95 * (ball1.measured_radius_pixels_ + ball2.measured_radius_pixels_))
+        {
+            GS_LOG_TRACE_MSG(trace, "ProcessMultiPairSpin - skipping pair (" +
+                             std::to_string(i - 1) + ", " + std::to_string(i) + ")");
+            continue;
+        }
+
+        // GetBallRotation needs the per-ball angles to de-rotate for
+        // perspective
+        if (!camera.ComputeBallDeltas(ball1, ball2, camera, camera))
+        {
+            GS_LOG_TRACE_MSG(trace,
+                             "ProcessMultiPairSpin - failed to ComputeBallDeltas for pair (" +
+                             std::to_string(i - 1) + ", " + std::to_string(i) + ")");
+            continue;
+        }
+
+        pair_balls1.push_back(ball1);
+        pair_balls2.push_back(ball2);
+        pair_intervals_uS.push_back(interval_uS);
+    }
+
+    if ((int)pair_intervals_uS.size() < std::max(2, kMultiPairSpinMinConsistentPairs))
+    {
+        GS_LOG_TRACE_MSG(trace, "ProcessMultiPairSpin - only " +
+                         std::to_string(pair_intervals_uS.size()) + " usable pairs.");
+        return false;
+    }
+
+    std::vector<cv::Vec3d> pair_rotations(pair_intervals_uS.size());
+    std::vector<std::optional<cv::Vec3d> > pair_prior_rotations(pair_intervals_uS.size());
+
+    auto processPairs = [&](const cv::Range &range)
+                        {
+                            for (int p = range.start; p < range.end; p++)
+                            {
+                                pair_rotations[p] =
+                                    BallImageProc::GetBallRotation(strobed_balls_gray_image,
+                                                                   pair_balls1[p],
+                                                                   strobed_balls_gray_image,
+                                                                   pair_balls2[p],
+                                                                   p,
+                                                                   &pair_prior_rotations[p]);
+                            }
+                        };
+
+    // Each pair is independent, so run one per thread if GetBallRotation
+    // allows it.  Any parallel_for_ inside GetBallRotation then runs inline on
+    // the pair's thread.
+    if (BallImageProc::IsGetBallRotationReentrant())
+    {
+        cv::parallel_for_(cv::Range(0, (int)pair_intervals_uS.size()), processPairs);
+    }
+    else
+    {
+        GS_LOG_TRACE_MSG(trace, "ProcessMultiPairSpin - processing pairs one at a time, as "
+                         "GetBallRotation is not reentrant with the current settings.");
+        processPairs(cv::Range(0, (int)pair_intervals_uS.size()));
+    }
+
+    for (size_t p = 0; p < pair_rotations.size(); p++)
+    {
+        GS_LOG_TRACE_MSG(trace, "ProcessMultiPairSpin - pair " + std::to_string(p) +
+                         " rotation (X,Y,Z) = (" + std::to_string(pair_rotations[p][0]) + ", " +
+                         std::to_string(pair_rotations[p][1]) + ", " +
+                         std::to_string(pair_rotations[p][2]) + ") over " +
+                         std::to_string(pair_intervals_uS[p]) + " uS");
+    }
+
+    double fused_interval_uS = 0.0;
+
+    if (!BallImageProc::FuseSpinPairRotations(pair_rotations,
+                                              pair_intervals_uS,
+                                              kMultiPairSpinMaxRpmDeviation,
+                                              kMultiPairSpinMinConsistentPairs,
+                                              rotationResults,
+                                              fused_interval_uS))
+    {
+        return false;
+    }
+
+    // The pairs did not record themselves in the spin prior, so record one
+    // result for the shot here.  The prior works in the raw (search-space)
+    // angles, so those are fused separately, from the pairs that were clearly
+    // found.
+    if (BallImageProc::kUseSpinSearchPrior)
+    {
+        std::vector<cv::Vec3d> prior_rotations;
+        std::vector<double> prior_intervals_uS;
+
+        for (size_t p = 0; p < pair_prior_rotations.size(); p++)
+        {
+            if (pair_prior_rotations[p])
+            {
+                prior_rotations.push_back(*pair_prior_rotations[p]);
+                prior_intervals_uS.push_back(pair_intervals_uS[p]);
+            }
+        }
+
+        cv::Vec3d fused_prior_rotation;
+        double fused_prior_interval_uS = 0.0;
+
+        if (BallImageProc::FuseSpinPairRotations(prior_rotations,
+                                                 prior_intervals_uS,
+                                                 kMultiPairSpinMaxRpmDeviation,
+                                                 kMultiPairSpinMinConsistentPairs,
+                                                 fused_prior_rotation,
+                                                 fused_prior_interval_uS))
+        {
+            BallImageProc::RecordSpinPriorResult(GolfSimClubs::GetCurrentClubType(),
+                                                 fused_prior_rotation);
+        }
+    }
+
+    camera.CalculateBallSpinRates(result_ball, rotationResults,
+                                  (long)std::round(fused_interval_uS));
+
+    result_ball.time_between_angle_measures_for_rpm_uS_ = (long)std::round(fused_interval_uS);
+
+    return true;
+}
+
 bool GolfSimCamera::FindClosestTwoBalls(const cv::Mat &img,
                                         const GsBallsAndTimingVector &balls,
                                         const bool use_edge_backoffs,
@@ -141,6 +141,30 @@ class GolfSimCamera
 
     static int kClosestBallPairEdgeBackoffPixels;
 
+    // If set, AnalyzeStrobedBalls first finds two balls with a reduced-size
+    // search of the whole image, and then looks for the rest only in small
+    // regions along the line of flight.  A full-image search is still done if
+    // the tracking does not find enough balls.
+    static bool kUseStrobedBallRoiTracking;
+    // Scale of the image used for the initial (seed) search
+    static double kStrobedBallTrackingSeedScale;
+    // How far (in ball radii) each search region extends past the predicted
+    // ball positions
+    static double kStrobedBallTrackingRoiMarginRatio;
+    // If fewer balls than this are tracked, fall back to the full search
+    static int kStrobedBallTrackingMinBalls;
+
+    // If set, ProcessSpin estimates the rotation of every usable adjacent
+    // pair of strobed balls concurrently and fuses the results instead of
+    // using only the single best pair.
+    static bool kUseMultiPairSpinFusion;
+    // A pair whose spin rate differs from the per-axis median of all pairs
+    // by more than this (on any axis) is dropped before fusing
+    static double kMultiPairSpinMaxRpmDeviation;
+    // If fewer consistent pairs than this remain, fall back to the best
+    // single pair
+    static int kMultiPairSpinMinConsistentPairs;
+
     static double kMaxIntermediateBallRadiusChangePercent;
     static double kMaxPuttingIntermediateBallRadiusChangePercent;
     static double kMaxOverlappedBallRadiusChangeRatio;
@@ -233,12 +257,15 @@ class GolfSimCamera
     // Requires the ball be placed in the center of the screen, at a certain
     // distance from the camera.  The expectedBallCenter can be used to specify
     // a different expected ball position.
+    // If image_is_distorted is set, rgbImg is a raw camera image, and the
+    // ball's circle is undistorted before anything is computed from it.
     // Returns true iff the input ball was successfully calibrated
     bool GetCalibratedBall(const GolfSimCamera &camera,
                            const cv::Mat &rgbImg,
                            GolfBall &b,
                            const cv::Vec2i &expectedBallCenter = cv::Vec2i(0, 0),
-                           const bool expectBall = true);
+                           const bool expectBall = true,
+                           const bool image_is_distorted = false);
 
     // Currently returns a single ball
     // TBD - Should return a vector of golf ball objects with each ball's
@@ -290,6 +317,26 @@ class GolfSimCamera
                              GolfBall &ball2,
                              long &time_between_ball_images_ms);
 
+    // Finds the strobed balls by tracking them along their line of flight
+    // from an initial pair of balls.  Each next ball is searched for only in
+    // the region where the current line, ball spacing and strobe pulse
+    // ratios say it could be.  The balls are returned with the initial pair
+    // first.  Returns false if fewer than kStrobedBallTrackingMinBalls were
+    // found.
+    static bool TrackStrobedBalls(const cv::Mat &strobed_balls_color_image,
+                                  const GolfBall &search_ball,
+                                  std::vector<GolfBall> &tracked_balls);
+
+    // Runs a strobed-mode GetBall on just the roi of the image, after
+    // scaling it by scale.  The returned balls are in full-image coordinates.
+    static bool FindStrobedBallsInRoi(const cv::Mat &strobed_balls_color_image,
+                                      const GolfBall &search_ball,
+                                      const cv::Rect &roi,
+                                      double scale,
+                                      double min_radius,
+                                      double max_radius,
+                                      std::vector<GolfBall> &balls);
+
     // Sets up the LoggingTool root cause and prints out an error if there are
     // less than two strobed balls found
     static void ReportBallSearchError(const int number_balls_found);
@@ -584,6 +631,16 @@ class GolfSimCamera
                             GolfBall &result_ball,
                             cv::Vec3d &rotationResults);
 
+    // Runs GetBallRotation on each usable adjacent pair of balls in parallel
+    // and fuses the per-pair spin rates.  Returns false if there were not
+    // enough consistent pairs, in which case the caller should fall back to
+    // the single-pair analysis.
+    static bool ProcessMultiPairSpin(GolfSimCamera &camera,
+                                     const cv::Mat &strobed_balls_gray_image,
+                                     const GsBallsAndTimingVector &non_overlapping_balls_and_timing,
+                                     GolfBall &result_ball,
+                                     cv::Vec3d &rotationResults);
+
     static void DrawFilterLines(const std::vector<cv::Vec4i> &lines,
                                 cv::Mat &image,
                                 const cv::Scalar &color,
@@ -221,6 +221,14 @@ bool GolfSimConfiguration::ReadValues()
                 LibCameraInterface::kCamera2StillShutterTimeuS);
     SetConstant("gs_config.cameras.kCameraMotionDetectSettings",
                 LibCameraInterface::kCameraMotionDetectSettings);
+    SetConstant("gs_config.cameras.kUndistortionMapDirectory",
+                LibCameraInterface::kUndistortionMapDirectory);
+    LibCameraInterface::undistortion_map_cache_.SetPersistenceDirectory(
+        LibCameraInterface::kUndistortionMapDirectory);
+    SetConstant("gs_config.cameras.kUsePointSpaceUndistortion",
+                LibCameraInterface::kUsePointSpaceUndistortion);
+    SetConstant("gs_config.cameras.kUseWarmStillCapture",
+                LibCameraInterface::kUseWarmStillCapture);
 
     // The web server share directory isn't really a value we want to use from
     // the .json configuration
@@ -0,0 +1,330 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <bit>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__AVX2__) || defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+#include "Infrastructure/ImageProcessing/BitplaneImage.h"
+
+namespace PiTrac
+{
+// Counts the matching and examined bits for num_words words starting at
+// word_offset.  The vectorized versions below fall back to this for any
+// words left over after the last full vector.
+static void CountWordsScalar(const BitplaneImage &img1,
+                             const BitplaneImage &img2,
+                             size_t word_offset,
+                             size_t num_words,
+                             uint64_t &matching,
+                             uint64_t &examined)
+{
+    const uint64_t *on1 = img1.on_plane.data();
+    const uint64_t *valid1 = img1.valid_plane.data();
+    const uint64_t *on2 = img2.on_plane.data();
+    const uint64_t *valid2 = img2.valid_plane.data();
+
+    for (size_t i = word_offset; i < word_offset + num_words; i++)
+    {
+        uint64_t both_valid = valid1[i] & valid2[i];
+        matching += std::popcount(both_valid & ~(on1[i] ^ on2[i]));
+        examined += std::popcount(both_valid);
+    }
+}
+
+#if defined(__ARM_NEON)
+
+static void CountWordsVector(const BitplaneImage &img1,
+                             const BitplaneImage &img2,
+                             size_t word_offset,
+                             size_t num_words,
+                             uint64_t &matching,
+                             uint64_t &examined)
+{
+    const uint64_t *on1 = img1.on_plane.data() + word_offset;
+    const uint64_t *valid1 = img1.valid_plane.data() + word_offset;
+    const uint64_t *on2 = img2.on_plane.data() + word_offset;
+    const uint64_t *valid2 = img2.valid_plane.data() + word_offset;
+
+    uint64x2_t matching_acc = vdupq_n_u64(0);
+    uint64x2_t examined_acc = vdupq_n_u64(0);
+
+    size_t i = 0;
+    for (; i + 2 <= num_words; i += 2)
+    {
+        uint64x2_t both_valid = vandq_u64(vld1q_u64(valid1 + i), vld1q_u64(valid2 + i));
+        uint64x2_t different = veorq_u64(vld1q_u64(on1 + i), vld1q_u64(on2 + i));
+        uint64x2_t same = vbicq_u64(both_valid, different);
+
+        // Per-byte counts, widened and accumulated into the two 64-bit lanes
+        uint8x16_t same_count = vcntq_u8(vreinterpretq_u8_u64(same));
+        uint8x16_t valid_count = vcntq_u8(vreinterpretq_u8_u64(both_valid));
+        matching_acc = vpadalq_u32(matching_acc, vpaddlq_u16(vpaddlq_u8(same_count)));
+        examined_acc = vpadalq_u32(examined_acc, vpaddlq_u16(vpaddlq_u8(valid_count)));
+    }
+
+    matching += vgetq_lane_u64(matching_acc, 0) + vgetq_lane_u64(matching_acc, 1);
+    examined += vgetq_lane_u64(examined_acc, 0) + vgetq_lane_u64(examined_acc, 1);
+
+    CountWordsScalar(img1, img2, word_offset + i, num_words - i, matching, examined);
+}
+
+#elif defined(__AVX2__)
+
+// Nibble-lookup population count.  Returns the counts summed into the four
+// 64-bit lanes.
+static inline __m256i PopCount256(__m256i v)
+{
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                            0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_mask = _mm256_set1_epi8(0x0f);
+
+    __m256i low = _mm256_and_si256(v, low_mask);
+    __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask);
+    __m256i counts = _mm256_add_epi8(_mm256_shuffle_epi8(lookup, low),
+                                     _mm256_shuffle_epi8(lookup, high));
+
+    return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+static void CountWordsVector(const BitplaneImage &img1,
+                             const BitplaneImage &img2,
+                             size_t word_offset,
+                             size_t num_words,
+                             uint64_t &matching,
+                             uint64_t &examined)
+{
+    const uint64_t *on1 = img1.on_plane.data() + word_offset;
+    const uint64_t *valid1 = img1.valid_plane.data() + word_offset;
+    const uint64_t *on2 = img2.on_plane.data() + word_offset;
+    const uint64_t *valid2 = img2.valid_plane.data() + word_offset;
+
+    __m256i matching_acc = _mm256_setzero_si256();
+    __m256i examined_acc = _mm256_setzero_si256();
+
+    size_t i = 0;
+    for (; i + 4 <= num_words; i += 4)
+    {
+        __m256i both_valid =
+            _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(valid1 + i)),
+                             _mm256_loadu_si256((const __m256i *)(valid2 + i)));
+        __m256i different =
+            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(on1 + i)),
+                             _mm256_loadu_si256((const __m256i *)(on2 + i)));
+        __m256i same = _mm256_andnot_si256(different, both_valid);
+
+        matching_acc = _mm256_add_epi64(matching_acc, PopCount256(same));
+        examined_acc = _mm256_add_epi64(examined_acc, PopCount256(both_valid));
+    }
+
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256((__m256i *)lanes, matching_acc);
+    matching += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_store_si256((__m256i *)lanes, examined_acc);
+    examined += lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    CountWordsScalar(img1, img2, word_offset + i, num_words - i, matching, examined);
+}
+
+#elif defined(__SSSE3__)
+
+// Nibble-lookup population count.  Returns the counts summed into the two
+// 64-bit lanes.
+static inline __m128i PopCount128(__m128i v)
+{
+    const __m128i lookup = _mm_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m128i low_mask = _mm_set1_epi8(0x0f);
+
+    __m128i low = _mm_and_si128(v, low_mask);
+    __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), low_mask);
+    __m128i counts = _mm_add_epi8(_mm_shuffle_epi8(lookup, low), _mm_shuffle_epi8(lookup, high));
+
+    return _mm_sad_epu8(counts, _mm_setzero_si128());
+}
+
+static void CountWordsVector(const BitplaneImage &img1,
+                             const BitplaneImage &img2,
+                             size_t word_offset,
+                             size_t num_words,
+                             uint64_t &matching,
+                             uint64_t &examined)
+{
+    const uint64_t *on1 = img1.on_plane.data() + word_offset;
+    const uint64_t *valid1 = img1.valid_plane.data() + word_offset;
+    const uint64_t *on2 = img2.on_plane.data() + word_offset;
+    const uint64_t *valid2 = img2.valid_plane.data() + word_offset;
+
+    __m128i matching_acc = _mm_setzero_si128();
+    __m128i examined_acc = _mm_setzero_si128();
+
+    size_t i = 0;
+    for (; i + 2 <= num_words; i += 2)
+    {
+        __m128i both_valid = _mm_and_si128(_mm_loadu_si128((const __m128i *)(valid1 + i)),
+                                           _mm_loadu_si128((const __m128i *)(valid2 + i)));
+        __m128i different = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(on1 + i)),
+                                          _mm_loadu_si128((const __m128i *)(on2 + i)));
+        __m128i same = _mm_andnot_si128(different, both_valid);
+
+        matching_acc = _mm_add_epi64(matching_acc, PopCount128(same));
+        examined_acc = _mm_add_epi64(examined_acc, PopCount128(both_valid));
+    }
+
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128((__m128i *)lanes, matching_acc);
+    matching += lanes[0] + lanes[1];
+    _mm_store_si128((__m128i *)lanes, examined_acc);
+    examined += lanes[0] + lanes[1];
+
+    CountWordsScalar(img1, img2, word_offset + i, num_words - i, matching, examined);
+}
+
+#else
+
+static void CountWordsVector(const BitplaneImage &img1,
+                             const BitplaneImage &img2,
+                             size_t word_offset,
+                             size_t num_words,
+                             uint64_t &matching,
+                             uint64_t &examined)
+{
+    CountWordsScalar(img1, img2, word_offset, num_words, matching, examined);
+}
+
+#endif
+
+void BitplaneImage::Reset(int image_rows, int image_cols)
+{
+    rows = image_rows;
+    cols = image_cols;
+    words_per_row = (image_cols + 63) / 64;
+
+    size_t num_words = (size_t)rows * (size_t)words_per_row;
+    on_plane.assign(num_words, 0);
+    valid_plane.assign(num_words, 0);
+}
+
+void BitplaneImage::Pack(const cv::Mat &img, uchar ignore_value, BitplaneImage &packed)
+{
+    CV_Assert((img.type() == CV_8UC1 || img.type() == CV_32SC2));
+
+    packed.Reset(img.rows, img.cols);
+
+    for (int row = 0; row < img.rows; row++)
+    {
+        uint64_t *on_words = packed.on_plane.data() + (size_t)row * packed.words_per_row;
+        uint64_t *valid_words = packed.valid_plane.data() + (size_t)row * packed.words_per_row;
+
+        if (img.type() == CV_8UC1)
+        {
+            const uchar *pixels = img.ptr<uchar>(row);
+
+            for (int col = 0; col < img.cols; col++)
+            {
+                uchar p = pixels[col];
+                uint64_t bit = (uint64_t)1 << (col & 63);
+
+                if (p != ignore_value)
+                {
+                    valid_words[col >> 6] |= bit;
+                    if (p != 0)
+                    {
+                        on_words[col >> 6] |= bit;
+                    }
+                }
+            }
+        }
+        else
+        {
+            const cv::Vec2i *pixels = img.ptr<cv::Vec2i>(row);
+
+            for (int col = 0; col < img.cols; col++)
+            {
+                uchar p = (uchar)pixels[col][1];
+                uint64_t bit = (uint64_t)1 << (col & 63);
+
+                if (p != ignore_value)
+                {
+                    valid_words[col >> 6] |= bit;
+                    if (p != 0)
+                    {
+                        on_words[col >> 6] |= bit;
+                    }
+                }
+            }
+        }
+    }
+}
+
+cv::Vec2i BitplaneImage::Compare(const BitplaneImage &img1, const BitplaneImage &img2)
+{
+    CV_Assert((img1.rows == img2.rows && img1.words_per_row == img2.words_per_row));
+
+    uint64_t matching = 0;
+    uint64_t examined = 0;
+    CountWordsVector(img1, img2, 0, img1.valid_plane.size(), matching, examined);
+
+    return cv::Vec2i((int)matching, (int)examined);
+}
+
+cv::Vec2i BitplaneImage::CompareScalar(const BitplaneImage &img1, const BitplaneImage &img2)
+{
+    CV_Assert((img1.rows == img2.rows && img1.words_per_row == img2.words_per_row));
+
+    uint64_t matching = 0;
+    uint64_t examined = 0;
+    CountWordsScalar(img1, img2, 0, img1.valid_plane.size(), matching, examined);
+
+    return cv::Vec2i((int)matching, (int)examined);
+}
+
+cv::Vec2i BitplaneImage::Compare(const BitplaneImage &img1,
+                                 const BitplaneImage &img2,
+                                 int start_row,
+                                 int end_row)
+{
+    CV_Assert((img1.rows == img2.rows && img1.words_per_row == img2.words_per_row));
+    CV_Assert((start_row >= 0 && start_row <= end_row && end_row <= img1.rows));
+
+    uint64_t matching = 0;
+    uint64_t examined = 0;
+    CountWordsVector(img1,
+                     img2,
+                     (size_t)start_row * (size_t)img1.words_per_row,
+                     (size_t)(end_row - start_row) * (size_t)img1.words_per_row,
+                     matching,
+                     examined);
+
+    return cv::Vec2i((int)matching, (int)examined);
+}
+
+int BitplaneImage::CountExamined(const BitplaneImage &img1, const BitplaneImage &img2)
+{
+    CV_Assert((img1.rows == img2.rows && img1.words_per_row == img2.words_per_row));
+
+    uint64_t examined = 0;
+    for (size_t i = 0; i < img1.valid_plane.size(); i++)
+    {
+        examined += std::popcount(img1.valid_plane[i] & img2.valid_plane[i]);
+    }
+
+    return (int)examined;
+}
+
+int BitplaneImage::CountValid() const
+{
+    uint64_t valid = 0;
+    for (uint64_t word : valid_plane)
+    {
+        valid += std::popcount(word);
+    }
+
+    return (int)valid;
+}
+}
@@ -0,0 +1,90 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// A packed representation of the Gabor-filtered dimple images that are
+// compared during spin analysis.  Those images are effectively binary (0 or
+// 255) plus a special "ignore" value, so each pixel is stored as two bits -
+// one in an "on" plane and one in a "valid" plane.  Comparing two images then
+// reduces to AND/XOR and a population count over 64-bit words.
+
+#ifndef PI_TRAC_BITPLANE_IMAGE_H
+#define PI_TRAC_BITPLANE_IMAGE_H
+
+#include <cstdint>
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+namespace PiTrac
+{
+class BitplaneImage
+{
+  public:
+
+    int rows = 0;
+    int cols = 0;
+
+    // Each row of each plane is padded out to a whole number of 64-bit words.
+    // The padding bits are never valid, and so never get counted.
+    int words_per_row = 0;
+
+    // Bit is set if the pixel is on (non-zero)
+    std::vector<uint64_t> on_plane;
+
+    // Bit is set if the pixel is not the ignore value
+    std::vector<uint64_t> valid_plane;
+
+    bool empty() const
+    {
+        return valid_plane.empty();
+    }
+
+    // Sizes the planes for a rows x cols image and marks every pixel as not
+    // valid.  Any existing plane storage is re-used.
+    void Reset(int image_rows, int image_cols);
+
+    // Sets the pixel at (row, col).  A pixel that is not valid is never on.
+    inline void SetPixel(int row, int col, bool valid, bool on)
+    {
+        size_t word = (size_t)row * (size_t)words_per_row + (size_t)(col >> 6);
+        uint64_t bit = (uint64_t)1 << (col & 63);
+
+        valid_plane[word] = valid ? (valid_plane[word] | bit) : (valid_plane[word] & ~bit);
+        on_plane[word] = (valid && on) ? (on_plane[word] | bit) : (on_plane[word] & ~bit);
+    }
+
+    // Packs either a CV_8UC1 image or the pixel-value channel (channel 1) of
+    // a CV_32SC2 image produced by Project2dImageTo3dBall.  Pixels equal to
+    // ignore_value are marked as not valid.  Any existing plane storage is
+    // re-used if it is already large enough.
+    static void Pack(const cv::Mat &img, uchar ignore_value, BitplaneImage &packed);
+
+    // Returns (number of pixels matching, number of pixels examined), where a
+    // pixel is only examined if it is valid in both images.  This is the same
+    // result as BallImageProc::CompareRotationImage.
+    // Uses NEON or SSE/AVX2 if available.
+    static cv::Vec2i Compare(const BitplaneImage &img1, const BitplaneImage &img2);
+
+    // Portable version of Compare, kept for verification of the vectorized
+    // paths.
+    static cv::Vec2i CompareScalar(const BitplaneImage &img1, const BitplaneImage &img2);
+
+    // Same as Compare, but only for rows [start_row, end_row)
+    static cv::Vec2i Compare(const BitplaneImage &img1,
+                             const BitplaneImage &img2,
+                             int start_row,
+                             int end_row);
+
+    // Returns just the number of pixels that Compare would examine, which
+    // only needs the valid planes
+    static int CountExamined(const BitplaneImage &img1, const BitplaneImage &img2);
+
+    // Returns the number of valid pixels
+    int CountValid() const;
+};
+}
+
+#endif // PI_TRAC_BITPLANE_IMAGE_H
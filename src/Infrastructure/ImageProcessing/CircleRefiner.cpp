@@ -0,0 +1,392 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include "Infrastructure/ImageProcessing/CircleRefiner.h"
+
+namespace PiTrac
+{
+// Need at least this many edge points (and inliers) to trust a fit
+static const int kMinimumEdgePoints = 12;
+
+// Ignore rays whose strongest edge is weaker than this (in gray levels per
+// pixel), as they probably do not cross the ball's edge at all
+static const float kMinimumEdgeStrength = 4.0f;
+
+static const int kRansacIterations = 64;
+static const int kGeometricFitIterations = 10;
+
+// Bilinear interpolation of image (CV_8UC1) at (x, y), which must be at least
+// one pixel inside the image
+static inline float Sample(const cv::Mat &image, float x, float y)
+{
+    int x0 = (int)x;
+    int y0 = (int)y;
+    float fx = x - x0;
+    float fy = y - y0;
+
+    const uchar *row0 = image.ptr<uchar>(y0) + x0;
+    const uchar *row1 = image.ptr<uchar>(y0 + 1) + x0;
+
+    float top = row0[0] + fx * (row0[1] - row0[0]);
+    float bottom = row1[0] + fx * (row1[1] - row1[0]);
+
+    return top + fy * (bottom - top);
+}
+
+void CircleRefiner::FindRadialEdgePoints(const cv::Mat &gray_image,
+                                         const cv::Vec3f &initial_circle,
+                                         int number_of_rays,
+                                         double search_band_ratio,
+                                         std::vector<cv::Point2f> &edge_points)
+{
+    edge_points.clear();
+
+    CV_Assert(gray_image.type() == CV_8UC1);
+
+    const float cx = initial_circle[0];
+    const float cy = initial_circle[1];
+    const float radius = initial_circle[2];
+
+    if (radius <= 0.0f || number_of_rays <= 0)
+    {
+        return;
+    }
+
+    const float inner_radius = std::max(1.0f, (float)(radius * (1.0 - search_band_ratio)));
+    const float outer_radius = (float)(radius * (1.0 + search_band_ratio));
+
+    // Only the area around the circle is smoothed, to keep noise from looking
+    // like the edge
+    int margin = (int)std::ceil(outer_radius) + 4;
+    cv::Rect roi = cv::Rect((int)cx - margin, (int)cy - margin, 2 * margin, 2 * margin) &
+                   cv::Rect(0, 0, gray_image.cols, gray_image.rows);
+
+    if (roi.width < 4 || roi.height < 4)
+    {
+        return;
+    }
+
+    cv::Mat smoothed;
+    cv::GaussianBlur(gray_image(roi), smoothed, cv::Size(5, 5), 0);
+
+    const float local_cx = cx - roi.x;
+    const float local_cy = cy - roi.y;
+    const float max_x = (float)smoothed.cols - 2.0f;
+    const float max_y = (float)smoothed.rows - 2.0f;
+
+    // One sample per pixel along the ray, plus one on each end for the
+    // derivative
+    const int number_of_samples = (int)std::ceil(outer_radius - inner_radius) + 3;
+    std::vector<float> samples(number_of_samples);
+
+    edge_points.reserve(number_of_rays);
+
+    for (int ray = 0; ray < number_of_rays; ray++)
+    {
+        double angle = 2.0 * CV_PI * ray / number_of_rays;
+        float dx = (float)std::cos(angle);
+        float dy = (float)std::sin(angle);
+
+        float first_x = local_cx + dx * (inner_radius - 1.0f);
+        float first_y = local_cy + dy * (inner_radius - 1.0f);
+        float last_x = first_x + dx * (number_of_samples - 1);
+        float last_y = first_y + dy * (number_of_samples - 1);
+
+        if (std::min(first_x, last_x) < 0.0f || std::max(first_x, last_x) > max_x ||
+            std::min(first_y, last_y) < 0.0f || std::max(first_y, last_y) > max_y)
+        {
+            continue;
+        }
+
+        for (int s = 0; s < number_of_samples; s++)
+        {
+            samples[s] = Sample(smoothed, first_x + dx * s, first_y + dy * s);
+        }
+
+        // Strongest central difference, whichever way the intensity changes
+        int best = -1;
+        float best_strength = kMinimumEdgeStrength;
+
+        for (int s = 1; s < number_of_samples - 1; s++)
+        {
+            float strength = std::abs(samples[s + 1] - samples[s - 1]) * 0.5f;
+
+            if (strength > best_strength)
+            {
+                best_strength = strength;
+                best = s;
+            }
+        }
+
+        if (best < 0)
+        {
+            continue;
+        }
+
+        // Sub-pixel peak of the derivative, from a parabola through it and
+        // its neighbors
+        float offset = 0.0f;
+
+        if (best > 1 && best < number_of_samples - 2)
+        {
+            float before = std::abs(samples[best] - samples[best - 2]) * 0.5f;
+            float after = std::abs(samples[best + 2] - samples[best]) * 0.5f;
+            float denominator = before - 2.0f * best_strength + after;
+
+            if (denominator < 0.0f)
+            {
+                offset = std::clamp(0.5f * (before - after) / denominator, -0.5f, 0.5f);
+            }
+        }
+
+        float distance = best + offset;
+        edge_points.emplace_back(first_x + dx * distance + roi.x,
+                                 first_y + dy * distance + roi.y);
+    }
+}
+
+bool CircleRefiner::FitCircleAlgebraic(const std::vector<cv::Point2f> &points,
+                                       cv::Vec3f &circle)
+{
+    if (points.size() < 3)
+    {
+        return false;
+    }
+
+    // Work relative to the centroid to keep the sums well conditioned
+    double mean_x = 0.0;
+    double mean_y = 0.0;
+
+    for (const cv::Point2f &p : points)
+    {
+        mean_x += p.x;
+        mean_y += p.y;
+    }
+
+    mean_x /= points.size();
+    mean_y /= points.size();
+
+    // Solve for (a, b, c) in x^2 + y^2 = 2ax + 2by + c, in the least squares
+    // sense.  The center is (a, b) and the radius is sqrt(c + a^2 + b^2).
+    double suu = 0.0;
+    double suv = 0.0;
+    double svv = 0.0;
+    double su = 0.0;
+    double sv = 0.0;
+    double suz = 0.0;
+    double svz = 0.0;
+    double sz = 0.0;
+
+    for (const cv::Point2f &p : points)
+    {
+        double u = p.x - mean_x;
+        double v = p.y - mean_y;
+        double z = u * u + v * v;
+
+        suu += u * u;
+        suv += u * v;
+        svv += v * v;
+        su += u;
+        sv += v;
+        suz += u * z;
+        svz += v * z;
+        sz += z;
+    }
+
+    double n = (double)points.size();
+    cv::Matx33d normal(2.0 * suu, 2.0 * suv, su,
+                       2.0 * suv, 2.0 * svv, sv,
+                       2.0 * su, 2.0 * sv, n);
+    cv::Vec3d rhs(suz, svz, sz);
+    cv::Vec3d solution;
+
+    if (!cv::solve(normal, rhs, solution, cv::DECOMP_LU))
+    {
+        return false;
+    }
+
+    double radius_squared = solution[2] + solution[0] * solution[0] + solution[1] * solution[1];
+
+    if (radius_squared <= 0.0)
+    {
+        return false;
+    }
+
+    circle = cv::Vec3f((float)(solution[0] + mean_x),
+                       (float)(solution[1] + mean_y),
+                       (float)std::sqrt(radius_squared));
+    return true;
+}
+
+void CircleRefiner::FitCircleGeometric(const std::vector<cv::Point2f> &points,
+                                       double huber_threshold,
+                                       cv::Vec3f &circle)
+{
+    double cx = circle[0];
+    double cy = circle[1];
+    double r = circle[2];
+
+    for (int iteration = 0; iteration < kGeometricFitIterations; iteration++)
+    {
+        // Normal equations for the change in (cx, cy, r).  The residual of a
+        // point is its distance from the center minus the radius.
+        cv::Matx33d jtj = cv::Matx33d::zeros();
+        cv::Vec3d jtr(0.0, 0.0, 0.0);
+
+        for (const cv::Point2f &p : points)
+        {
+            double dx = p.x - cx;
+            double dy = p.y - cy;
+            double distance = std::sqrt(dx * dx + dy * dy);
+
+            if (distance < 1e-6)
+            {
+                continue;
+            }
+
+            double residual = distance - r;
+            double weight = (std::abs(residual) <= huber_threshold) ? 1.0 :
+                            huber_threshold / std::abs(residual);
+
+            cv::Vec3d jacobian(-dx / distance, -dy / distance, -1.0);
+
+            for (int i = 0; i < 3; i++)
+            {
+                for (int j = 0; j < 3; j++)
+                {
+                    jtj(i, j) += weight * jacobian[i] * jacobian[j];
+                }
+
+                jtr[i] += weight * jacobian[i] * residual;
+            }
+        }
+
+        cv::Vec3d step;
+
+        if (!cv::solve(jtj, -jtr, step, cv::DECOMP_CHOLESKY))
+        {
+            break;
+        }
+
+        cx += step[0];
+        cy += step[1];
+        r += step[2];
+
+        if (std::abs(step[0]) + std::abs(step[1]) + std::abs(step[2]) < 1e-4)
+        {
+            break;
+        }
+    }
+
+    if (r > 0.0)
+    {
+        circle = cv::Vec3f((float)cx, (float)cy, (float)r);
+    }
+}
+
+bool CircleRefiner::FitCircleRobust(const std::vector<cv::Point2f> &points,
+                                    double inlier_distance,
+                                    cv::Vec3f &circle)
+{
+    const int number_of_points = (int)points.size();
+
+    if (number_of_points < kMinimumEdgePoints)
+    {
+        return false;
+    }
+
+    cv::RNG rng(0x5eed);
+    cv::Vec3f best_circle;
+    int best_inliers = 0;
+
+    for (int iteration = 0; iteration < kRansacIterations; iteration++)
+    {
+        int a = rng.uniform(0, number_of_points);
+        int b = rng.uniform(0, number_of_points);
+        int c = rng.uniform(0, number_of_points);
+
+        if (a == b || b == c || a == c)
+        {
+            continue;
+        }
+
+        std::vector<cv::Point2f> sample = { points[a], points[b], points[c] };
+        cv::Vec3f candidate;
+
+        if (!FitCircleAlgebraic(sample, candidate))
+        {
+            continue;
+        }
+
+        int inliers = 0;
+
+        for (const cv::Point2f &p : points)
+        {
+            double distance = std::hypot(p.x - candidate[0], p.y - candidate[1]);
+
+            if (std::abs(distance - candidate[2]) <= inlier_distance)
+            {
+                inliers++;
+            }
+        }
+
+        if (inliers > best_inliers)
+        {
+            best_inliers = inliers;
+            best_circle = candidate;
+        }
+    }
+
+    if (best_inliers < kMinimumEdgePoints)
+    {
+        return false;
+    }
+
+    std::vector<cv::Point2f> inlier_points;
+    inlier_points.reserve(best_inliers);
+
+    for (const cv::Point2f &p : points)
+    {
+        double distance = std::hypot(p.x - best_circle[0], p.y - best_circle[1]);
+
+        if (std::abs(distance - best_circle[2]) <= inlier_distance)
+        {
+            inlier_points.push_back(p);
+        }
+    }
+
+    if (!FitCircleAlgebraic(inlier_points, circle))
+    {
+        return false;
+    }
+
+    // The Huber threshold is well inside the inlier band, so that the points
+    // near its edge count for less
+    FitCircleGeometric(inlier_points, inlier_distance / 2.0, circle);
+
+    return true;
+}
+
+bool CircleRefiner::Refine(const cv::Mat &gray_image,
+                           const cv::Vec3f &initial_circle,
+                           cv::Vec3f &refined_circle,
+                           int number_of_rays,
+                           double search_band_ratio)
+{
+    std::vector<cv::Point2f> edge_points;
+    FindRadialEdgePoints(gray_image, initial_circle, number_of_rays, search_band_ratio,
+                         edge_points);
+
+    // A few percent of the radius, but at least a pixel and a half
+    double inlier_distance = std::max(1.5, 0.03 * initial_circle[2]);
+
+    return FitCircleRobust(edge_points, inlier_distance, refined_circle);
+}
+}
@@ -0,0 +1,69 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// Refines a circle that is already close to a ball's edge, without another
+// Hough transform.  The edge is found to sub-pixel precision along rays from
+// the circle's center, and a circle is then fit to those points.  RANSAC
+// throws out points that are on something other than the ball (another ball,
+// a shadow, the tee), and a Huber-weighted geometric least-squares fit of the
+// rest gives the final center and radius.
+
+#ifndef PI_TRAC_CIRCLE_REFINER_H
+#define PI_TRAC_CIRCLE_REFINER_H
+
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+namespace PiTrac
+{
+class CircleRefiner
+{
+  public:
+
+    // Sets refined_circle (x, y, radius) from the ball edge in gray_image
+    // (CV_8UC1) near initial_circle.  The edge is looked for along
+    // number_of_rays rays, from (1 - search_band_ratio) to
+    // (1 + search_band_ratio) times the initial radius.
+    // Returns false if too few edge points were found or no circle fit them.
+    static bool Refine(const cv::Mat &gray_image,
+                       const cv::Vec3f &initial_circle,
+                       cv::Vec3f &refined_circle,
+                       int number_of_rays = 90,
+                       double search_band_ratio = 0.25);
+
+    // Sets edge_points to the strongest (sub-pixel) intensity edge along each
+    // ray, skipping rays that leave the image or have no real edge
+    static void FindRadialEdgePoints(const cv::Mat &gray_image,
+                                     const cv::Vec3f &initial_circle,
+                                     int number_of_rays,
+                                     double search_band_ratio,
+                                     std::vector<cv::Point2f> &edge_points);
+
+    // Algebraic (Kasa) least-squares circle through points.  Fast, and good
+    // enough to start the geometric fit from.
+    static bool FitCircleAlgebraic(const std::vector<cv::Point2f> &points,
+                                   cv::Vec3f &circle);
+
+    // Robust fit: RANSAC over three-point circles to find the inliers (points
+    // within inlier_distance pixels of the circle), then a geometric fit of
+    // the inliers with Huber weights.  The RANSAC sampling uses a fixed seed,
+    // so the result is repeatable.
+    static bool FitCircleRobust(const std::vector<cv::Point2f> &points,
+                                double inlier_distance,
+                                cv::Vec3f &circle);
+
+  private:
+
+    // Gauss-Newton (iteratively reweighted) fit of the distances from the
+    // points to the circle, starting from circle
+    static void FitCircleGeometric(const std::vector<cv::Point2f> &points,
+                                   double huber_threshold,
+                                   cv::Vec3f &circle);
+};
+}
+
+#endif // PI_TRAC_CIRCLE_REFINER_H
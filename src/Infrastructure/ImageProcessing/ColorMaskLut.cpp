@@ -0,0 +1,94 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include "Infrastructure/ImageProcessing/ColorMaskLut.h"
+
+namespace PiTrac
+{
+static const int kBinsPerChannel = 1 << ColorMaskLut::kBitsPerChannel;
+static const int kBinShift = 8 - ColorMaskLut::kBitsPerChannel;
+
+static inline int BinIndex(uchar b, uchar g, uchar r)
+{
+    return ((b >> kBinShift) << (2 * ColorMaskLut::kBitsPerChannel)) |
+           ((g >> kBinShift) << ColorMaskLut::kBitsPerChannel) |
+           (r >> kBinShift);
+}
+
+void ColorMaskLut::Build(const cv::Scalar &lower_hsv,
+                         const cv::Scalar &upper_hsv,
+                         const HsvMaskFunction &hsv_mask_function)
+{
+    const int number_of_bins = kBinsPerChannel * kBinsPerChannel * kBinsPerChannel;
+    const int bin_center = (1 << kBinShift) / 2;
+
+    // One pixel for the center color of each bin, in table order
+    cv::Mat bin_colors(1, number_of_bins, CV_8UC3);
+
+    for (int b = 0; b < kBinsPerChannel; b++)
+    {
+        for (int g = 0; g < kBinsPerChannel; g++)
+        {
+            for (int r = 0; r < kBinsPerChannel; r++)
+            {
+                cv::Vec3b color((uchar)((b << kBinShift) + bin_center),
+                                (uchar)((g << kBinShift) + bin_center),
+                                (uchar)((r << kBinShift) + bin_center));
+                bin_colors.at<cv::Vec3b>(0, BinIndex(color[0], color[1], color[2])) = color;
+            }
+        }
+    }
+
+    cv::Mat bin_hsv;
+    cv::cvtColor(bin_colors, bin_hsv, cv::COLOR_BGR2HSV);
+
+    cv::Mat bin_mask = hsv_mask_function(bin_hsv);
+
+    table_.assign(number_of_bins, 0);
+
+    if (bin_mask.type() == CV_8UC1 && bin_mask.total() == (size_t)number_of_bins)
+    {
+        bin_mask = bin_mask.reshape(1, 1);
+
+        for (int i = 0; i < number_of_bins; i++)
+        {
+            table_[i] = bin_mask.at<uchar>(0, i);
+        }
+    }
+
+    lower_hsv_ = lower_hsv;
+    upper_hsv_ = upper_hsv;
+}
+
+bool ColorMaskLut::IsBuiltFor(const cv::Scalar &lower_hsv, const cv::Scalar &upper_hsv) const
+{
+    return !table_.empty() && lower_hsv == lower_hsv_ && upper_hsv == upper_hsv_;
+}
+
+void ColorMaskLut::Apply(const cv::Mat &bgr_image, cv::Mat &mask) const
+{
+    CV_Assert(bgr_image.type() == CV_8UC3 && !table_.empty());
+
+    mask.create(bgr_image.size(), CV_8UC1);
+
+    const uchar *table = table_.data();
+
+    cv::parallel_for_(cv::Range(0, bgr_image.rows), [&](const cv::Range &range)
+        {
+            for (int y = range.start; y < range.end; y++)
+            {
+                const uchar *bgr = bgr_image.ptr<uchar>(y);
+                uchar *mask_row = mask.ptr<uchar>(y);
+
+                for (int x = 0; x < bgr_image.cols; x++, bgr += 3)
+                {
+                    mask_row[x] = table[BinIndex(bgr[0], bgr[1], bgr[2])];
+                }
+            }
+        });
+}
+}
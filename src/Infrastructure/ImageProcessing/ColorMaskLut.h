@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// A lookup table from (quantized) BGR colors to a ball color mask.  Masking an
+// image by HSV range otherwise means converting every pixel of the image to
+// HSV first.  Here, the HSV masking is done once for the center color of each
+// BGR bin, and masking an image is then one table lookup per pixel.
+// The table only needs to be rebuilt when the HSV range changes.
+
+#ifndef PI_TRAC_COLOR_MASK_LUT_H
+#define PI_TRAC_COLOR_MASK_LUT_H
+
+#include <functional>
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+namespace PiTrac
+{
+class ColorMaskLut
+{
+  public:
+
+    // Number of high-order bits of each of B, G and R that select a bin
+    static const int kBitsPerChannel = 5;
+
+    // Makes a mask (CV_8UC1) from an HSV image, such as
+    // BallImageProc::GetColorMaskImage does
+    using HsvMaskFunction = std::function<cv::Mat(const cv::Mat &hsv_image)>;
+
+    // Builds the table for the given HSV range.  hsv_mask_function is run on
+    // the HSV version of the center color of each bin, so the table gives the
+    // same result as that function for any of those colors.
+    void Build(const cv::Scalar &lower_hsv,
+               const cv::Scalar &upper_hsv,
+               const HsvMaskFunction &hsv_mask_function);
+
+    // True if the table was last built for this HSV range
+    bool IsBuiltFor(const cv::Scalar &lower_hsv, const cv::Scalar &upper_hsv) const;
+
+    // Sets mask (CV_8UC1) to the table value for each pixel of bgr_image
+    // (CV_8UC3)
+    void Apply(const cv::Mat &bgr_image, cv::Mat &mask) const;
+
+  private:
+
+    std::vector<uchar> table_;
+    cv::Scalar lower_hsv_;
+    cv::Scalar upper_hsv_;
+};
+}
+
+#endif // PI_TRAC_COLOR_MASK_LUT_H
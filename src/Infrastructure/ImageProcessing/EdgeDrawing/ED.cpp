@@ -1,6 +1,12 @@
 #include "Infrastructure/ImageProcessing/EdgeDrawing/ED.h"
 #include <fstream>
 
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 using namespace cv;
 using namespace std;
 
@@ -11,7 +17,8 @@ ED::ED(Mat _srcImage,
        int _scanInterval,
        int _minPathLen,
        double _sigma,
-       bool _sumFlag)
+       bool _sumFlag,
+       EDWorkspace *workspace)
 {
     // Check parameters for sanity
     if (_gradThresh < 1)
@@ -70,7 +77,11 @@ ED::ED(Mat _srcImage,
     gradImg = (short *)gradImage.data;
     edgeImg = edgeImage.data;
 
-    dirImg = new unsigned char[width * height];
+    // Use a scratch workspace for this object only if none was given
+    EDWorkspace localWorkspace;
+    EDWorkspace &scratch = (workspace != nullptr) ? *workspace : localWorkspace;
+
+    dirImg = EDWorkspace::Get(scratch.dirImg, width * height);
 
     /*------------ COMPUTE GRADIENT & EDGE DIRECTION MAPS -------------------*/
     ComputeGradient();
@@ -79,9 +90,9 @@ ED::ED(Mat _srcImage,
     ComputeAnchorPoints();
 
     /*------------ JOIN ANCHORS -------------------*/
-    JoinAnchorPointsUsingSortedAnchors();
+    JoinAnchorPointsUsingSortedAnchors(scratch);
 
-    delete[] dirImg;
+    dirImg = NULL; // belongs to the workspace
 }
 
 // This constructor for use of EDLines and EDCircle with ED given as constructor
@@ -126,7 +137,8 @@ ED::ED(short *_gradImg,
        int _anchorThresh,
        int _scanInterval,
        int _minPathLen,
-       bool selectStableAnchors)
+       bool selectStableAnchors,
+       EDWorkspace *workspace)
 {
     height = _height;
     width = _width;
@@ -248,7 +260,8 @@ ED::ED(short *_gradImg,
     segmentPoints.push_back(vector<Point>()); // create empty vector of points
                                               // for segments
 
-    JoinAnchorPointsUsingSortedAnchors();
+    EDWorkspace localWorkspace;
+    JoinAnchorPointsUsingSortedAnchors((workspace != nullptr) ? *workspace : localWorkspace);
 }
 
 ED::ED(EDColor &obj)
@@ -346,128 +359,323 @@ Mat ED::drawParticularSegments(std::vector<int> list)
     return segmentsImage;
 }
 
-void ED::ComputeGradient()
+// Prewitt Operator in horizontal and vertical direction
+// A B C
+// D x E
+// F G H
+// gx = (C-A) + (E-D) + (H-F)
+// gy = (F-A) + (G-B) + (H-C)
+//
+// To make this faster:
+// com1 = (H-A)
+// com2 = (C-F)
+//
+// For Prewitt
+// Then: gx = com1 + com2 + (E-D) = (H-A) + (C-F) + (E-D) = (C-A) +
+// (E-D) + (H-F)
+//       gy = com1 - com2 + (G-B) = (H-A) - (C-F) + (G-B) = (F-A) +
+// (G-B) + (H-C)
+//
+// For Sobel
+// Then: gx = com1 + com2 + 2*(E-D) = (H-A) + (C-F) + 2*(E-D) =
+// (C-A) + 2*(E-D) + (H-F)
+//       gy = com1 - com2 + 2*(G-B) = (H-A) - (C-F) + 2*(G-B) =
+// (F-A) + 2*(G-B) + (H-C)
+//
+// For Scharr
+// Then: gx = 3*(com1 + com2) + 10*(E-D) = 3*(H-A) + 3*(C-F) +
+// 10*(E-D) = 3*(C-A) + 10*(E-D) + 3*(H-F)
+//       gy = 3*(com1 - com2) + 10*(G-B) = 3*(H-A) - 3*(C-F) +
+// 10*(G-B) = 3*(F-A) + 10*(G-B) + 3*(H-C)
+//
+// For LSD
+// A B
+// C D
+// gx = (B-A) + (D-C)
+// gy = (C-A) + (D-B)
+//
+// To make this faster:
+// com1 = (D-A)
+// com2 = (B-C)
+// Then: gx = com1 + com2 = (D-A) + (B-C) = (B-A) + (D-C)
+//       gy = com1 - com2 = (D-A) - (B-C) = (C-A) + (D-B)
+//
+// Each operator has its own kernel, picked by the template parameter, so
+// there is no switch in the per-pixel loop.  The Scharr case has always
+// fallen through to the LSD kernel, which overwrote its result, so Scharr
+// uses the LSD kernel here too and the output does not change.
+
+struct GradientImages
 {
-    // Initialize gradient image for row = 0, row = height-1, column=0,
-    // column=width-1
-    for (int j = 0; j < width; j++)
+    const uchar *smoothImg;
+    short *gradImg;
+    uchar *dirImg;
+    int width;
+    int gradThresh;
+    bool sumFlag;
+};
+
+template <GradientOperator Op>
+static inline void ComputeGradientPixel(const GradientImages &images, int i, int j)
+{
+    const uchar *smoothImg = images.smoothImg;
+    const int width = images.width;
+
+    int gx;
+    int gy;
+
+    if constexpr (Op == LSD_OPERATOR)
     {
-        gradImg[j] = gradImg[(height - 1) * width + j] = gradThresh - 1;
+        int com1 = smoothImg[(i + 1) * width + j + 1] - smoothImg[i * width + j];
+        int com2 = smoothImg[i * width + j + 1] - smoothImg[(i + 1) * width + j];
+
+        gx = abs(com1 + com2);
+        gy = abs(com1 - com2);
     }
-    for (int i = 1; i < height - 1; i++)
+    else
     {
-        gradImg[i * width] = gradImg[(i + 1) * width - 1] = gradThresh - 1;
+        const int centerWeight = (Op == SOBEL_OPERATOR) ? 2 : 1;
+
+        int com1 = smoothImg[(i + 1) * width + j + 1] - smoothImg[(i - 1) * width + j - 1];
+        int com2 = smoothImg[(i - 1) * width + j + 1] - smoothImg[(i + 1) * width + j - 1];
+
+        gx = abs(com1 + com2 + centerWeight *
+                 (smoothImg[i * width + j + 1] - smoothImg[i * width + j - 1]));
+        gy = abs(com1 - com2 + centerWeight *
+                 (smoothImg[(i + 1) * width + j] - smoothImg[(i - 1) * width + j]));
     }
 
-    for (int i = 1; i < height - 1; i++)
+    int sum;
+
+    if (images.sumFlag)
     {
-        for (int j = 1; j < width - 1; j++)
+        sum = gx + gy;
+    }
+    else
+    {
+        sum = (int)sqrt((double)gx * gx + gy * gy);
+    }
+
+    int index = i * width + j;
+    images.gradImg[index] = sum;
+
+    if (sum >= images.gradThresh)
+    {
+        if (gx >= gy)
         {
-            // Prewitt Operator in horizontal and vertical direction
-            // A B C
-            // D x E
-            // F G H
-            // gx = (C-A) + (E-D) + (H-F)
-            // gy = (F-A) + (G-B) + (H-C)
-            //
-            // To make this faster:
-            // com1 = (H-A)
-            // com2 = (C-F)
-            //
-            // For Prewitt
-            // Then: gx = com1 + com2 + (E-D) = (H-A) + (C-F) + (E-D) = (C-A) +
-            // (E-D) + (H-F)
-            //       gy = com1 - com2 + (G-B) = (H-A) - (C-F) + (G-B) = (F-A) +
-            // (G-B) + (H-C)
-            //
-            // For Sobel
-            // Then: gx = com1 + com2 + 2*(E-D) = (H-A) + (C-F) + 2*(E-D) =
-            // (C-A) + 2*(E-D) + (H-F)
-            //       gy = com1 - com2 + 2*(G-B) = (H-A) - (C-F) + 2*(G-B) =
-            // (F-A) + 2*(G-B) + (H-C)
-            //
-            // For Scharr
-            // Then: gx = 3*(com1 + com2) + 10*(E-D) = 3*(H-A) + 3*(C-F) +
-            // 10*(E-D) = 3*(C-A) + 10*(E-D) + 3*(H-F)
-            //       gy = 3*(com1 - com2) + 10*(G-B) = 3*(H-A) - 3*(C-F) +
-            // 10*(G-B) = 3*(F-A) + 10*(G-B) + 3*(H-C)
-            //
-            // For LSD
-            // A B
-            // C D
-            // gx = (B-A) + (D-C)
-            // gy = (C-A) + (D-B)
-            //
-            // To make this faster:
-            // com1 = (D-A)
-            // com2 = (B-C)
-            // Then: gx = com1 + com2 = (D-A) + (B-C) = (B-A) + (D-C)
-            //       gy = com1 - com2 = (D-A) - (B-C) = (C-A) + (D-B)
-
-            int com1 = smoothImg[(i + 1) * width + j + 1] - smoothImg[(i - 1) * width + j - 1];
-            int com2 = smoothImg[(i - 1) * width + j + 1] - smoothImg[(i + 1) * width + j - 1];
-
-            int gx;
-            int gy;
-
-            switch (op)
-            {
-                case PREWITT_OPERATOR:
-                    gx = abs(com1 + com2 +
-                             (smoothImg[i * width + j + 1] - smoothImg[i * width + j - 1]));
-                    gy = abs(com1 - com2 +
-                             (smoothImg[(i + 1) * width + j] - smoothImg[(i - 1) * width + j]));
-                    break;
-                case SOBEL_OPERATOR:
-                    gx = abs(com1 + com2 + 2 *
-                             (smoothImg[i * width + j + 1] - smoothImg[i * width + j - 1]));
-                    gy = abs(com1 - com2 + 2 *
-                             (smoothImg[(i + 1) * width + j] - smoothImg[(i - 1) * width + j]));
-                    break;
-                case SCHARR_OPERATOR:
-                    gx = abs(3 * (com1 + com2) + 10 *
-                             (smoothImg[i * width + j + 1] - smoothImg[i * width + j - 1]));
-                    gy = abs(3 * (com1 - com2) + 10 *
-                             (smoothImg[(i + 1) * width + j] - smoothImg[(i - 1) * width + j]));
-                    [[fallthrough]];
-
-                case LSD_OPERATOR:
-                    // com1 and com2 differs from previous operators, because
-                    // LSD has 2x2 kernel
-                    int com1 = smoothImg[(i + 1) * width + j + 1] - smoothImg[i * width + j];
-                    int com2 = smoothImg[i * width + j + 1] - smoothImg[(i + 1) * width + j];
-
-                    gx = abs(com1 + com2);
-                    gy = abs(com1 - com2);
-            }
+            images.dirImg[index] = EDGE_VERTICAL;
+        }
+        else
+        {
+            images.dirImg[index] = EDGE_HORIZONTAL;
+        }
+    } //end-if
+}
 
-            int sum;
+// Number of pixels done at once by ComputeGradientRowVector
+#define GRADIENT_VECTOR_PIXELS 8
 
-            if (sumFlag)
-            {
-                sum = gx + gy;
-            }
-            else
+#if defined(__ARM_NEON)
+
+static inline int16x8_t LoadPixels(const uchar *p)
+{
+    return vreinterpretq_s16_u16(vmovl_u8(vld1_u8(p)));
+}
+
+// Does row i (sum of |gx| and |gy| only) from column 1, 8 pixels at a time,
+// and returns the first column that is left for the scalar kernel.  All the
+// values fit in 16 bits: the largest is 2 * 4 * 255 for Sobel.
+template <GradientOperator Op>
+static int ComputeGradientRowVector(const GradientImages &images, int i)
+{
+    const int width = images.width;
+    const uchar *prev = images.smoothImg + (i - 1) * width;
+    const uchar *cur = images.smoothImg + i * width;
+    const uchar *next = images.smoothImg + (i + 1) * width;
+    short *grad = images.gradImg + i * width;
+    uchar *dir = images.dirImg + i * width;
+
+    const int16x8_t threshold = vdupq_n_s16((short)images.gradThresh);
+    const uint16x8_t vertical = vdupq_n_u16(EDGE_VERTICAL);
+    const uint16x8_t horizontal = vdupq_n_u16(EDGE_HORIZONTAL);
+
+    int j = 1;
+    for (; j + GRADIENT_VECTOR_PIXELS < width - 1; j += GRADIENT_VECTOR_PIXELS)
+    {
+        int16x8_t gx;
+        int16x8_t gy;
+
+        if constexpr (Op == LSD_OPERATOR)
+        {
+            int16x8_t com1 = vsubq_s16(LoadPixels(next + j + 1), LoadPixels(cur + j));
+            int16x8_t com2 = vsubq_s16(LoadPixels(cur + j + 1), LoadPixels(next + j));
+
+            gx = vabsq_s16(vaddq_s16(com1, com2));
+            gy = vabsq_s16(vsubq_s16(com1, com2));
+        }
+        else
+        {
+            const int16_t centerWeight = (Op == SOBEL_OPERATOR) ? 2 : 1;
+
+            int16x8_t com1 = vsubq_s16(LoadPixels(next + j + 1), LoadPixels(prev + j - 1));
+            int16x8_t com2 = vsubq_s16(LoadPixels(prev + j + 1), LoadPixels(next + j - 1));
+            int16x8_t horizontalDiff = vsubq_s16(LoadPixels(cur + j + 1), LoadPixels(cur + j - 1));
+            int16x8_t verticalDiff = vsubq_s16(LoadPixels(next + j), LoadPixels(prev + j));
+
+            gx = vabsq_s16(vmlaq_n_s16(vaddq_s16(com1, com2), horizontalDiff, centerWeight));
+            gy = vabsq_s16(vmlaq_n_s16(vsubq_s16(com1, com2), verticalDiff, centerWeight));
+        }
+
+        int16x8_t sum = vaddq_s16(gx, gy);
+        vst1q_s16(grad + j, sum);
+
+        // Only the pixels over the threshold get a direction
+        uint8x8_t isEdge = vmovn_u16(vcgeq_s16(sum, threshold));
+        uint8x8_t direction = vmovn_u16(vbslq_u16(vcgeq_s16(gx, gy), vertical, horizontal));
+        vst1_u8(dir + j, vbsl_u8(isEdge, direction, vld1_u8(dir + j)));
+    }
+
+    return j;
+}
+
+#elif defined(__SSE2__)
+
+static inline __m128i LoadPixels(const uchar *p)
+{
+    return _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)p), _mm_setzero_si128());
+}
+
+static inline __m128i Abs16(__m128i v)
+{
+    return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+}
+
+// Does row i (sum of |gx| and |gy| only) from column 1, 8 pixels at a time,
+// and returns the first column that is left for the scalar kernel.  All the
+// values fit in 16 bits: the largest is 2 * 4 * 255 for Sobel.
+template <GradientOperator Op>
+static int ComputeGradientRowVector(const GradientImages &images, int i)
+{
+    const int width = images.width;
+    const uchar *prev = images.smoothImg + (i - 1) * width;
+    const uchar *cur = images.smoothImg + i * width;
+    const uchar *next = images.smoothImg + (i + 1) * width;
+    short *grad = images.gradImg + i * width;
+    uchar *dir = images.dirImg + i * width;
+
+    // sum >= gradThresh is done as sum > gradThresh - 1
+    const __m128i belowThreshold = _mm_set1_epi16((short)(images.gradThresh - 1));
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i vertical = _mm_set1_epi16(EDGE_VERTICAL);
+
+    int j = 1;
+    for (; j + GRADIENT_VECTOR_PIXELS < width - 1; j += GRADIENT_VECTOR_PIXELS)
+    {
+        __m128i gx;
+        __m128i gy;
+
+        if constexpr (Op == LSD_OPERATOR)
+        {
+            __m128i com1 = _mm_sub_epi16(LoadPixels(next + j + 1), LoadPixels(cur + j));
+            __m128i com2 = _mm_sub_epi16(LoadPixels(cur + j + 1), LoadPixels(next + j));
+
+            gx = Abs16(_mm_add_epi16(com1, com2));
+            gy = Abs16(_mm_sub_epi16(com1, com2));
+        }
+        else
+        {
+            __m128i com1 = _mm_sub_epi16(LoadPixels(next + j + 1), LoadPixels(prev + j - 1));
+            __m128i com2 = _mm_sub_epi16(LoadPixels(prev + j + 1), LoadPixels(next + j - 1));
+            __m128i horizontalDiff = _mm_sub_epi16(LoadPixels(cur + j + 1),
+                                                   LoadPixels(cur + j - 1));
+            __m128i verticalDiff = _mm_sub_epi16(LoadPixels(next + j), LoadPixels(prev + j));
+
+            if constexpr (Op == SOBEL_OPERATOR)
             {
-                sum = (int)sqrt((double)gx * gx + gy * gy);
+                horizontalDiff = _mm_add_epi16(horizontalDiff, horizontalDiff);
+                verticalDiff = _mm_add_epi16(verticalDiff, verticalDiff);
             }
 
-            int index = i * width + j;
-            gradImg[index] = sum;
+            gx = Abs16(_mm_add_epi16(_mm_add_epi16(com1, com2), horizontalDiff));
+            gy = Abs16(_mm_add_epi16(_mm_sub_epi16(com1, com2), verticalDiff));
+        }
+
+        __m128i sum = _mm_add_epi16(gx, gy);
+        _mm_storeu_si128((__m128i *)(grad + j), sum);
+
+        // EDGE_VERTICAL if gx >= gy, else EDGE_HORIZONTAL (one more).  Only
+        // the pixels over the threshold get a direction.
+        __m128i direction = _mm_add_epi16(vertical, _mm_and_si128(_mm_cmpgt_epi16(gy, gx), one));
+        __m128i isEdge = _mm_cmpgt_epi16(sum, belowThreshold);
+
+        __m128i oldDirection = _mm_loadl_epi64((const __m128i *)(dir + j));
+        __m128i isEdge8 = _mm_packs_epi16(isEdge, isEdge);
+        __m128i direction8 = _mm_packus_epi16(direction, direction);
+        __m128i newDirection = _mm_or_si128(_mm_and_si128(isEdge8, direction8),
+                                            _mm_andnot_si128(isEdge8, oldDirection));
+        _mm_storel_epi64((__m128i *)(dir + j), newDirection);
+    }
+
+    return j;
+}
+
+#else
+
+template <GradientOperator Op>
+static int ComputeGradientRowVector(const GradientImages &, int)
+{
+    return 1;
+}
+
+#endif
 
-            if (sum >= gradThresh)
+// Rows are done in bands across the cores
+template <GradientOperator Op>
+static void ComputeGradientForOperator(const GradientImages &images, int height)
+{
+    parallel_for_(Range(1, height - 1), [&](const Range &rows)
+        {
+            for (int i = rows.start; i < rows.end; i++)
             {
-                if (gx >= gy)
-                {
-                    dirImg[index] = EDGE_VERTICAL;
-                }
-                else
+                // The vector kernel only does the (default) sum of |gx| and |gy|
+                int j = images.sumFlag ? ComputeGradientRowVector<Op>(images, i) : 1;
+
+                for (; j < images.width - 1; j++)
                 {
-                    dirImg[index] = EDGE_HORIZONTAL;
+                    ComputeGradientPixel<Op>(images, i, j);
                 }
-            } //end-if
-        } // end-for
-    } // end-for
+            }
+        });
+}
+
+void ED::ComputeGradient()
+{
+    // Initialize gradient image for row = 0, row = height-1, column=0,
+    // column=width-1
+    for (int j = 0; j < width; j++)
+    {
+        gradImg[j] = gradImg[(height - 1) * width + j] = gradThresh - 1;
+    }
+    for (int i = 1; i < height - 1; i++)
+    {
+        gradImg[i * width] = gradImg[(i + 1) * width - 1] = gradThresh - 1;
+    }
+
+    GradientImages images = { smoothImg, gradImg, dirImg, width, gradThresh, sumFlag };
+
+    switch (op)
+    {
+        case PREWITT_OPERATOR:
+            ComputeGradientForOperator<PREWITT_OPERATOR>(images, height);
+            break;
+        case SOBEL_OPERATOR:
+            ComputeGradientForOperator<SOBEL_OPERATOR>(images, height);
+            break;
+        case SCHARR_OPERATOR:
+        case LSD_OPERATOR:
+            ComputeGradientForOperator<LSD_OPERATOR>(images, height);
+            break;
+    }
 }
 
 void ED::ComputeAnchorPoints()
@@ -518,16 +726,16 @@ void ED::ComputeAnchorPoints()
                                           // points
 }
 
-void ED::JoinAnchorPointsUsingSortedAnchors()
+void ED::JoinAnchorPointsUsingSortedAnchors(EDWorkspace &workspace)
 {
-    int *chainNos = new int[(width + height) * 8];
+    int *chainNos = EDWorkspace::Get(workspace.chainNos, (width + height) * 8);
 
-    Point *pixels = new Point[width * height];
-    StackNode *stack = new StackNode[width * height];
-    Chain *chains = new Chain[width * height];
+    Point *pixels = EDWorkspace::Get(workspace.pixels, width * height);
+    StackNode *stack = EDWorkspace::Get(workspace.stack, width * height);
+    Chain *chains = EDWorkspace::Get(workspace.chains, width * height);
 
     // sort the anchor points by their gradient value in decreasing order
-    int *A = sortAnchorsByGradValue1();
+    int *A = sortAnchorsByGradValue1(workspace);
 
     // Now join the anchors starting with the anchor having the greatest
     // gradient value
@@ -1237,12 +1445,7 @@ StartOfWhile:
     // because of one preallocation in the beginning, it will always empty
     segmentPoints.pop_back();
 
-    // Clean up
-    delete[] A;
-    delete[] chains;
-    delete[] stack;
-    delete[] chainNos;
-    delete[] pixels;
+    // The work buffers belong to the workspace, so there is nothing to free
 }
 
 void ED::sortAnchorsByGradValue()
@@ -1281,10 +1484,10 @@ void ED::sortAnchorsByGradValue()
      */
 }
 
-int * ED::sortAnchorsByGradValue1()
+int * ED::sortAnchorsByGradValue1(EDWorkspace &workspace)
 {
     int SIZE = 128 * 256;
-    int *C = new int[SIZE];
+    int *C = EDWorkspace::Get(workspace.gradCounts, SIZE);
     memset(C, 0, sizeof(int) * SIZE);
 
     // Count the number of grad values
@@ -1309,7 +1512,7 @@ int * ED::sortAnchorsByGradValue1()
     }
 
     int noAnchors = C[SIZE - 1];
-    int *A = new int[noAnchors];
+    int *A = EDWorkspace::Get(workspace.sortedAnchors, noAnchors);
     memset(A, 0, sizeof(int) * noAnchors);
 
     for (int i = 1; i < height - 1; i++)
@@ -1327,8 +1530,6 @@ int * ED::sortAnchorsByGradValue1()
         } //end-for
     } //end-for
 
-    delete[] C;
-
     /*
      * ofstream myFile;
      * myFile.open("aNew.txt");
@@ -36,6 +36,7 @@
 
 #include <opencv4/opencv2/opencv.hpp>
 #include "Infrastructure/ImageProcessing/EdgeDrawing/EDColor.h"
+#include "Infrastructure/ImageProcessing/EdgeDrawing/EDWorkspace.h"
 
 /// Special defines
 #define EDGE_VERTICAL   1
@@ -52,23 +53,6 @@
 enum GradientOperator { PREWITT_OPERATOR = 101, SOBEL_OPERATOR = 102, SCHARR_OPERATOR = 103,
                         LSD_OPERATOR = 104 };
 
-struct StackNode
-{
-    int r, c;   // starting pixel
-    int parent; // parent chain (-1 if no parent)
-    int dir;    // direction where you are supposed to go
-};
-
-// Used during Edge Linking
-struct Chain
-{
-    int dir;                   // Direction of the chain
-    int len;                   // # of pixels in the chain
-    int parent;                // Parent of this node (-1 if no parent)
-    int children[2];           // Children of this node (-1 if no children)
-    cv::Point *pixels;         // Pointer to the beginning of the pixels array
-};
-
 class ED
 {
   public:
@@ -79,7 +63,8 @@ class ED
        int _scanInterval = 1,
        int _minPathLen = 10,
        double _sigma = 1.0,
-       bool _sumFlag = true);
+       bool _sumFlag = true,
+       EDWorkspace *workspace = nullptr);
     ED(const ED &cpyObj);
     ED(short *gradImg,
        uchar *dirImg,
@@ -89,7 +74,8 @@ class ED
        int _anchorThresh,
        int _scanInterval = 1,
        int _minPathLen = 10,
-       bool selectStableAnchors = true);
+       bool selectStableAnchors = true,
+       EDWorkspace *workspace = nullptr);
     ED(EDColor &cpyObj);
     ED();
 
@@ -123,9 +109,9 @@ class ED
   private:
     void ComputeGradient();
     void ComputeAnchorPoints();
-    void JoinAnchorPointsUsingSortedAnchors();
+    void JoinAnchorPointsUsingSortedAnchors(EDWorkspace &workspace);
     void sortAnchorsByGradValue();
-    int * sortAnchorsByGradValue1();
+    int * sortAnchorsByGradValue1(EDWorkspace &workspace);
 
     static int LongestChain(Chain *chains, int root);
     static int RetrieveChainNos(Chain *chains, int root, int chainNos[]);
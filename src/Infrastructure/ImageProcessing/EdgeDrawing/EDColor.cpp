@@ -7,7 +7,8 @@ EDColor::EDColor(Mat srcImage,
                  int gradThresh,
                  int anchor_thresh,
                  double sigma,
-                 bool validateSegments)
+                 bool validateSegments,
+                 EDWorkspace *workspace)
 {
     inputImage = srcImage.clone();
 
@@ -41,27 +42,31 @@ EDColor::EDColor(Mat srcImage,
     height = srcImage.rows;
     width = srcImage.cols;
 
-    // Allocate space for L*a*b color space
-    L_Img = new uchar[width * height];
-    a_Img = new uchar[width * height];
-    b_Img = new uchar[width * height];
+    // Use a scratch workspace for this object only if none was given
+    EDWorkspace localWorkspace;
+    EDWorkspace &scratch = (workspace != nullptr) ? *workspace : localWorkspace;
+
+    // Space for L*a*b color space
+    L_Img = EDWorkspace::Get(scratch.L_Img, width * height);
+    a_Img = EDWorkspace::Get(scratch.a_Img, width * height);
+    b_Img = EDWorkspace::Get(scratch.b_Img, width * height);
 
     // Convert RGB2Lab
-    MyRGB2LabFast();
+    MyRGB2LabFast(scratch);
 
-    // Allocate space for smooth channels
-    smooth_L = new uchar[width * height];
-    smooth_a = new uchar[width * height];
-    smooth_b = new uchar[width * height];
+    // Space for smooth channels
+    smooth_L = EDWorkspace::Get(scratch.smooth_L, width * height);
+    smooth_a = EDWorkspace::Get(scratch.smooth_a, width * height);
+    smooth_b = EDWorkspace::Get(scratch.smooth_b, width * height);
 
     // Smooth Channels
     smoothChannel(L_Img, smooth_L, sigma);
     smoothChannel(a_Img, smooth_a, sigma);
     smoothChannel(b_Img, smooth_b, sigma);
 
-    // Allocate space for direction and gradient images
-    dirImg = new uchar[width * height];
-    gradImg = new short[width * height];
+    // Space for direction and gradient images
+    dirImg = EDWorkspace::Get(scratch.dirImg, width * height);
+    gradImg = EDWorkspace::Get(scratch.gradImg, width * height);
 
     // Compute Gradient & Edge Direction Maps
     ComputeGradientMapByDiZenzo();
@@ -71,7 +76,8 @@ EDColor::EDColor(Mat srcImage,
     if (validateSegments)
     {
         // Get Edge Image using ED
-        ED edgeObj = ED(gradImg, dirImg, width, height, gradThresh, anchor_thresh, 1, 10, false);
+        ED edgeObj = ED(gradImg, dirImg, width, height, gradThresh, anchor_thresh, 1, 10, false,
+                        &scratch);
         segments = edgeObj.getSegments();
         edgeImage = edgeObj.getEdgeImage();
 
@@ -82,7 +88,7 @@ EDColor::EDColor(Mat srcImage,
 
         edgeImg = edgeImage.data; // validation steps uses pointer to edgeImage
 
-        validateEdgeSegments();
+        validateEdgeSegments(scratch);
 
         // Extract the new edge segments after validation
         extractNewSegments();
@@ -90,7 +96,8 @@ EDColor::EDColor(Mat srcImage,
 
     else
     {
-        ED edgeObj = ED(gradImg, dirImg, width, height, gradThresh, anchor_thresh);
+        ED edgeObj = ED(gradImg, dirImg, width, height, gradThresh, anchor_thresh, 1, 10, true,
+                        &scratch);
         segments = edgeObj.getSegments();
         edgeImage = edgeObj.getEdgeImage();
         segmentNo = edgeObj.getSegmentNo();
@@ -99,17 +106,11 @@ EDColor::EDColor(Mat srcImage,
     // Fix 1 pixel errors in the edge map
     fixEdgeSegments(segments, 1);
 
-    // clean space
-    delete[] L_Img;
-    delete[] a_Img;
-    delete[] b_Img;
-
-    delete[] smooth_L;
-    delete[] smooth_a;
-    delete[] smooth_b;
-
-    delete[] gradImg;
-    delete[] dirImg;
+    // The channel, gradient and direction images belong to the workspace
+    L_Img = a_Img = b_Img = NULL;
+    smooth_L = smooth_a = smooth_b = NULL;
+    gradImg = NULL;
+    dirImg = NULL;
 }
 
 cv::Mat EDColor::getEdgeImage()
@@ -137,7 +138,7 @@ int EDColor::getHeight()
     return height;
 }
 
-void EDColor::MyRGB2LabFast()
+void EDColor::MyRGB2LabFast(EDWorkspace &workspace)
 {
     // Inialize LUTs if necessary
     if (!LUT_Initialized)
@@ -150,9 +151,9 @@ void EDColor::MyRGB2LabFast()
     double x, y, z;
 
     // Space for temp. allocation
-    double *L = new double[width * height];
-    double *a = new double[width * height];
-    double *b = new double[width * height];
+    double *L = EDWorkspace::Get(workspace.L, width * height);
+    double *a = EDWorkspace::Get(workspace.a, width * height);
+    double *b = EDWorkspace::Get(workspace.b, width * height);
 
     for (int i = 0; i < width * height; i++)
     {
@@ -253,11 +254,6 @@ void EDColor::MyRGB2LabFast()
     {
         b_Img[i] = (unsigned char)((b[i] - min) * scale);
     }
-
-    // clean space
-    delete[] L;
-    delete[] a;
-    delete[] b;
 }
 
 void EDColor::ComputeGradientMapByDiZenzo()
@@ -395,10 +391,10 @@ void EDColor::smoothChannel(uchar *src, uchar *smooth, double sigma)
 // Validate the edge segments using the Helmholtz principle (for color images)
 // channel1, channel2 and channel3 images
 //
-void EDColor::validateEdgeSegments()
+void EDColor::validateEdgeSegments(EDWorkspace &workspace)
 {
     int maxGradValue = MAX_GRAD_VALUE;
-    H = new double[maxGradValue];
+    H = EDWorkspace::Get(workspace.H, maxGradValue);
     memset(H, 0, sizeof(double) * maxGradValue);
 
     memset(edgeImg, 0, width * height); // clear edge image
@@ -407,7 +403,7 @@ void EDColor::validateEdgeSegments()
     memset(gradImg, 0, sizeof(short) * width * height); // reset gradient Image
                                                         // pixels to zero
 
-    int *grads = new int[maxGradValue];
+    int *grads = EDWorkspace::Get(workspace.gradCounts, maxGradValue);
     memset(grads, 0, sizeof(int) * maxGradValue);
 
     for (int i = 1; i < height - 1; i++)
@@ -483,9 +479,8 @@ void EDColor::validateEdgeSegments()
         testSegment(i, 0, (int)(segments[i].size() - 1));
     } //end-for
 
-    // clear space
-    delete[] H;
-    delete[] grads;
+    // H belongs to the workspace
+    H = NULL;
 }
 
 //----------------------------------------------------------------------------------
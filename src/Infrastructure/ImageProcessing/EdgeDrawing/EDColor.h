@@ -40,6 +40,7 @@
 #define _EDColor_
 
 #include <opencv4/opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/EdgeDrawing/EDWorkspace.h"
 
 // Look up table size for fast color space conversion
 #define LUT_SIZE (1024 * 4096)
@@ -62,7 +63,8 @@ class EDColor
             int gradThresh = 20,
             int anchor_thresh = 4,
             double sigma = 1.5,
-            bool validateSegments = false);
+            bool validateSegments = false,
+            EDWorkspace *workspace = nullptr);
     cv::Mat getEdgeImage();
     std::vector<std::vector<cv::Point> > getSegments();
     int getSegmentNo();
@@ -104,10 +106,10 @@ class EDColor
     static double LUT2[LUT_SIZE + 1];
     static bool LUT_Initialized;
 
-    void MyRGB2LabFast();
+    void MyRGB2LabFast(EDWorkspace &workspace);
     void ComputeGradientMapByDiZenzo();
     void smoothChannel(uchar *src, uchar *smooth, double sigma);
-    void validateEdgeSegments();
+    void validateEdgeSegments(EDWorkspace &workspace);
     void testSegment(int i, int index1, int index2);
     void extractNewSegments();
     double NFA(double prob, int len);
@@ -3,18 +3,18 @@
 using namespace cv;
 using namespace std;
 
-EDPF::EDPF(Mat srcImage)
-    : ED(srcImage, PREWITT_OPERATOR, 11, 3)
+EDPF::EDPF(Mat srcImage, EDWorkspace *workspace)
+    : ED(srcImage, PREWITT_OPERATOR, 11, 3, 1, 10, 1.0, true, workspace)
 {
     // Validate Edge Segments
     sigma /= 2.5;
     GaussianBlur(srcImage, smoothImage, Size(), sigma); // calculate kernel from
                                                         // sigma
 
-    validateEdgeSegments();
+    validateEdgeSegments(workspace);
 }
 
-EDPF::EDPF(ED obj)
+EDPF::EDPF(ED obj, EDWorkspace *workspace)
     : ED(obj)
 {
     // Validate Edge Segments
@@ -22,7 +22,7 @@ EDPF::EDPF(ED obj)
     GaussianBlur(srcImage, smoothImage, Size(), sigma); // calculate kernel from
                                                         // sigma
 
-    validateEdgeSegments();
+    validateEdgeSegments(workspace);
 }
 
 EDPF::EDPF(EDColor obj)
@@ -30,15 +30,19 @@ EDPF::EDPF(EDColor obj)
 {
 }
 
-void EDPF::validateEdgeSegments()
+void EDPF::validateEdgeSegments(EDWorkspace *workspace)
 {
+    // Use a scratch workspace for this object only if none was given
+    EDWorkspace localWorkspace;
+    EDWorkspace &scratch = (workspace != nullptr) ? *workspace : localWorkspace;
+
     divForTestSegment = 2.25; // Some magic number :-)
     memset(edgeImg, 0, width * height); // clear edge image
 
-    H = new double[MAX_GRAD_VALUE];
+    H = EDWorkspace::Get(scratch.H, MAX_GRAD_VALUE);
     memset(H, 0, sizeof(double) * MAX_GRAD_VALUE);
 
-    gradImg = ComputePrewitt3x3();
+    gradImg = ComputePrewitt3x3(scratch);
 
     // Compute np: # of segment pieces
 #if 1
@@ -70,17 +74,17 @@ void EDPF::validateEdgeSegments()
 
     ExtractNewSegments();
 
-    // clean space
-    delete[] H;
-    delete[] gradImg;
+    // H and gradImg belong to the workspace
+    H = NULL;
+    gradImg = NULL;
 }
 
-short * EDPF::ComputePrewitt3x3()
+short * EDPF::ComputePrewitt3x3(EDWorkspace &workspace)
 {
-    short *gradImg = new short[width * height];
+    short *gradImg = EDWorkspace::Get(workspace.gradImg, width * height);
     memset(gradImg, 0, sizeof(short) * width * height);
 
-    int *grads = new int[MAX_GRAD_VALUE];
+    int *grads = EDWorkspace::Get(workspace.gradCounts, MAX_GRAD_VALUE);
     memset(grads, 0, sizeof(int) * MAX_GRAD_VALUE);
 
     for (int i = 1; i < height - 1; i++)
@@ -128,7 +132,6 @@ short * EDPF::ComputePrewitt3x3()
         H[i] = (double)grads[i] / ((double)size);
     }
 
-    delete[] grads;
     return gradImg;
 }
 
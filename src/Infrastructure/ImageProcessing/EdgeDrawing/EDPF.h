@@ -42,8 +42,8 @@
 class EDPF : public ED
 {
   public:
-    EDPF(cv::Mat srcImage);
-    EDPF(ED obj);
+    EDPF(cv::Mat srcImage, EDWorkspace *workspace = nullptr);
+    EDPF(ED obj, EDWorkspace *workspace = nullptr);
     EDPF(EDColor obj);
   private:
     double divForTestSegment;
@@ -51,8 +51,8 @@ class EDPF : public ED
     int np;
     short *gradImg;
 
-    void validateEdgeSegments();
-    short * ComputePrewitt3x3(); // differs from base class's prewit function
+    void validateEdgeSegments(EDWorkspace *workspace);
+    short * ComputePrewitt3x3(EDWorkspace &workspace); // differs from base class's prewit function
                                  // (calculates H)
     void TestSegment(int i, int index1, int index2);
     void ExtractNewSegments();
@@ -0,0 +1,97 @@
+/**************************************************************************************************************
+* Edge Drawing (ED) and Edge Drawing Parameter Free (EDPF) source codes.
+* Copyright (C) 2016, Cuneyt Akinlar & Cihan Topal
+* E-mails of the authors: cuneytakinlar@gmail.com, cihant@anadolu.edu.tr
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*
+* By using this library you are implicitly assumed to have accepted all of the
+* above statements,
+* and accept to cite the following papers:
+*
+* [1] C. Topal and C. Akinlar, �Edge Drawing: A Combined Real-Time Edge and
+* Segment Detector,?*     Journal of Visual Communication and Image
+* Representation, 23(6), 862-872, DOI: 10.1016/j.jvcir.2012.05.004 (2012).
+*
+* [2] C. Akinlar and C. Topal, �EDPF: A Real-time Parameter-free Edge Segment
+* Detector with a False Detection Control,?*     International Journal of
+* Pattern
+* Recognition and Artificial Intelligence, 26(1), DOI: 10.1142/S0218001412550026
+*(2012).
+**************************************************************************************************************/
+
+#ifndef _EDWorkspace_
+#define _EDWorkspace_
+
+#include <vector>
+#include <opencv4/opencv2/opencv.hpp>
+
+struct StackNode
+{
+    int r, c;   // starting pixel
+    int parent; // parent chain (-1 if no parent)
+    int dir;    // direction where you are supposed to go
+};
+
+// Used during Edge Linking
+struct Chain
+{
+    int dir;                   // Direction of the chain
+    int len;                   // # of pixels in the chain
+    int parent;                // Parent of this node (-1 if no parent)
+    int children[2];           // Children of this node (-1 if no children)
+    cv::Point *pixels;         // Pointer to the beginning of the pixels array
+};
+
+// Scratch buffers for ED, EDPF and EDColor.  Several of them are the size of
+// the whole image, so allocating them for every detection is expensive.  A
+// caller that runs the detectors over and over can keep one of these and pass
+// it in, and the buffers are then only allocated when the image gets bigger.
+// A workspace must not be used by more than one detector at the same time.
+class EDWorkspace
+{
+  public:
+    // Returns the buffer, first growing it to at least size elements.  The
+    // contents are whatever was left by the previous user.
+    template <typename T>
+    static T * Get(std::vector<T> &buffer, size_t size)
+    {
+        if (buffer.size() < size)
+        {
+            buffer.resize(size);
+        }
+
+        return buffer.data();
+    }
+
+    // ED
+    std::vector<uchar> dirImg;
+    std::vector<int> chainNos;
+    std::vector<cv::Point> pixels;
+    std::vector<StackNode> stack;
+    std::vector<Chain> chains;
+    std::vector<int> gradCounts;
+    std::vector<int> sortedAnchors;
+
+    // EDPF and EDColor validation
+    std::vector<short> gradImg;
+    std::vector<double> H;
+
+    // EDColor
+    std::vector<uchar> L_Img, a_Img, b_Img;
+    std::vector<uchar> smooth_L, smooth_a, smooth_b;
+    std::vector<double> L, a, b;
+};
+
+#endif // ! _EDWorkspace_
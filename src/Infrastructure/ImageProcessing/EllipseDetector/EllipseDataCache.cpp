@@ -0,0 +1,130 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <algorithm>
+
+#include "Infrastructure/ImageProcessing/EllipseDetector/EllipseDataCache.h"
+
+namespace PiTrac
+{
+EllipseDataCache::EllipseDataCache()
+{
+    capacity_bits_ = kInitialCapacityBits;
+    size_t capacity = (size_t)1 << capacity_bits_;
+
+    keys_.resize(capacity);
+    stamps_.assign(capacity, 0);
+    values_.resize(capacity);
+}
+
+void EllipseDataCache::Reset()
+{
+    stamp_++;
+
+    // Only after ~4 billion resets, but old slots must not come back to life
+    if (stamp_ == 0)
+    {
+        std::fill(stamps_.begin(), stamps_.end(), 0);
+        stamp_ = 1;
+    }
+
+    size_ = 0;
+    slope_block_ = 0;
+    slope_offset_ = 0;
+}
+
+size_t EllipseDataCache::SlotFor(unsigned key) const
+{
+    // Fibonacci hashing.  The keys pack the pair type and the two arc indexes
+    // into different bit ranges, and the top bits of the product mix them all.
+    return (size_t)((key * 2654435769u) >> (32 - capacity_bits_));
+}
+
+const EllipseData *EllipseDataCache::Find(unsigned key) const
+{
+    const size_t mask = keys_.size() - 1;
+
+    for (size_t slot = SlotFor(key); stamps_[slot] == stamp_; slot = (slot + 1) & mask)
+    {
+        if (keys_[slot] == key)
+        {
+            return &values_[slot];
+        }
+    }
+
+    return nullptr;
+}
+
+void EllipseDataCache::Insert(unsigned key, const EllipseData &data)
+{
+    // Keep the table at most half full, so that probe runs stay short
+    if ((size_ + 1) * 2 > keys_.size())
+    {
+        Grow();
+    }
+
+    const size_t mask = keys_.size() - 1;
+    size_t slot = SlotFor(key);
+
+    while (stamps_[slot] == stamp_)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    keys_[slot] = key;
+    stamps_[slot] = stamp_;
+    values_[slot] = data;
+    size_++;
+}
+
+void EllipseDataCache::Grow()
+{
+    std::vector<unsigned> old_keys;
+    std::vector<unsigned> old_stamps;
+    std::vector<EllipseData> old_values;
+    old_keys.swap(keys_);
+    old_stamps.swap(stamps_);
+    old_values.swap(values_);
+
+    capacity_bits_++;
+    size_t capacity = (size_t)1 << capacity_bits_;
+
+    keys_.resize(capacity);
+    stamps_.assign(capacity, 0);
+    values_.resize(capacity);
+
+    unsigned current_stamp = stamp_;
+    stamp_ = 1;
+    size_ = 0;
+
+    for (size_t i = 0; i < old_keys.size(); i++)
+    {
+        if (old_stamps[i] == current_stamp)
+        {
+            Insert(old_keys[i], old_values[i]);
+        }
+    }
+}
+
+std::span<float> EllipseDataCache::AllocateSlopes(unsigned count)
+{
+    while (slope_block_ < slope_blocks_.size() &&
+           slope_offset_ + count > slope_blocks_[slope_block_].size())
+    {
+        slope_block_++;
+        slope_offset_ = 0;
+    }
+
+    if (slope_block_ == slope_blocks_.size())
+    {
+        slope_blocks_.emplace_back(std::max(kSlopeBlockSize, (size_t)count));
+    }
+
+    float *slopes = slope_blocks_[slope_block_].data() + slope_offset_;
+    slope_offset_ += count;
+
+    return std::span<float>(slopes, count);
+}
+}
@@ -0,0 +1,95 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// The cache of EllipseData that the Yaed ellipse detector keeps for each pair
+// of arcs while it looks for triplets.  It is an open-addressing hash table in
+// flat arrays, and the slope arrays of the EllipseData are carved out of large
+// blocks of floats.  Reset() empties the table and the slope storage without
+// freeing either, so a cache that is kept from frame to frame stops
+// allocating once it has grown to the size that the images need.
+
+#ifndef PI_TRAC_ELLIPSE_DATA_CACHE_H
+#define PI_TRAC_ELLIPSE_DATA_CACHE_H
+
+#include <span>
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+namespace PiTrac
+{
+// Data available after selection strategy.
+// They are kept in an associative array to:
+// 1) avoid recomputing data when starting from same arcs
+// 2) be reused in further proprecessing
+struct EllipseData
+{
+    bool isValid;
+    float ta;
+    float tb;
+    float ra;
+    float rb;
+    cv::Point2f Ma;
+    cv::Point2f Mb;
+    cv::Point2f Cab;
+
+    // Point into the slope storage of the EllipseDataCache that the data was
+    // made for, and are only valid until that cache is next reset
+    std::span<float> Sa;
+    std::span<float> Sb;
+};
+
+class EllipseDataCache
+{
+  public:
+
+    EllipseDataCache();
+
+    // Empties the table and the slope storage, keeping their memory
+    void Reset();
+
+    // Returns the data for key, or nullptr if there is none.  The pointer is
+    // only valid until the next Insert.
+    const EllipseData *Find(unsigned key) const;
+
+    // Adds the data for key, which must not already be in the table
+    void Insert(unsigned key, const EllipseData &data);
+
+    // Returns space for count slopes, which stays put until the next Reset
+    std::span<float> AllocateSlopes(unsigned count);
+
+    size_t Size() const
+    {
+        return size_;
+    }
+
+  private:
+
+    // Number of table slots to start with (a power of two)
+    static const int kInitialCapacityBits = 12;
+
+    // Number of floats in each block of slope storage
+    static const size_t kSlopeBlockSize = 16 * 1024;
+
+    size_t SlotFor(unsigned key) const;
+    void Grow();
+
+    // A slot is in use if its stamp is the current one, so emptying the
+    // table is just a change of the current stamp
+    std::vector<unsigned> keys_;
+    std::vector<unsigned> stamps_;
+    std::vector<EllipseData> values_;
+    unsigned stamp_ = 1;
+    int capacity_bits_ = 0;
+    size_t size_ = 0;
+
+    std::vector<std::vector<float> > slope_blocks_;
+    size_t slope_block_ = 0;
+    size_t slope_offset_ = 0;
+};
+}
+
+#endif // PI_TRAC_ELLIPSE_DATA_CACHE_H
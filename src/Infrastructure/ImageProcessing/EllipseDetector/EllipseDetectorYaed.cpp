@@ -32,6 +32,7 @@ CEllipseDetectorYaed::CEllipseDetectorYaed(void) : _times(6, 0.0), _timesHelper(
     _fMinScore = 0.4f;
     _fMinReliability = 0.4f;
     _uNs = 16;
+    _bParallelTriplets = false;
 
     srand(unsigned(time(nullptr)));
 }
@@ -110,11 +111,14 @@ int CEllipseDetectorYaed::FindMaxA(const int *v) const
 };
 
 
-float CEllipseDetectorYaed::GetMedianSlope(vector<Point2f> &med, Point2f &M, vector<float> &slopes)
+float CEllipseDetectorYaed::GetMedianSlope(vector<Point2f> &med,
+                                           Point2f &M,
+                                           span<float> &slopes,
+                                           EllipseDataCache &cache)
 {
     // med		: vector of points
     // M		: centroid of the points in med
-    // slopes	: vector of the slopes
+    // slopes	: set to the slopes, which are stored in cache
 
     unsigned iNofPoints = (unsigned)med.size();
     //CV_Assert(iNofPoints >= 2);
@@ -122,10 +126,11 @@ float CEllipseDetectorYaed::GetMedianSlope(vector<Point2f> &med, Point2f &M, vec
     unsigned halfSize = iNofPoints >> 1;
     unsigned quarterSize = halfSize >> 1;
 
-    vector<float> xx, yy;
-    slopes.reserve(halfSize);
-    xx.reserve(iNofPoints);
-    yy.reserve(iNofPoints);
+    vector<float> &xx = _xx;
+    vector<float> &yy = _yy;
+    xx.clear();
+    yy.clear();
+    slopes = cache.AllocateSlopes(halfSize);
 
     for (unsigned i = 0; i < halfSize; ++i)
     {
@@ -145,7 +150,7 @@ float CEllipseDetectorYaed::GetMedianSlope(vector<Point2f> &med, Point2f &M, vec
             den = 0.00001f;
         }
 
-        slopes.push_back(num / den);
+        slopes[i] = num / den;
     }
 
     nth_element(slopes.begin(), slopes.begin() + quarterSize, slopes.end());
@@ -160,7 +165,10 @@ float CEllipseDetectorYaed::GetMedianSlope(vector<Point2f> &med, Point2f &M, vec
 
 
 
-void CEllipseDetectorYaed::GetFastCenter(vector<Point> &e1, vector<Point> &e2, EllipseData &data)
+void CEllipseDetectorYaed::GetFastCenter(vector<Point> &e1,
+                                         vector<Point> &e2,
+                                         EllipseData &data,
+                                         EllipseDataCache &cache)
 {
     data.isValid = true;
 
@@ -193,12 +201,13 @@ void CEllipseDetectorYaed::GetFastCenter(vector<Point> &e1, vector<Point> &e2, E
         data.ra = m_ref;
 
         // Find points with same slope as reference
-        vector<Point2f> med;
-        med.reserve(hsize_2);
+        vector<Point2f> &med = _med;
+        med.clear();
 
         unsigned minPoints = (_uNs < hsize_2) ? _uNs : hsize_2;
 
-        vector<uint> indexes(minPoints);
+        vector<uint> &indexes = _indexes;
+        indexes.resize(minPoints);
         if (_uNs < hsize_2)
         {
             unsigned iSzBin = hsize_2 / unsigned(_uNs);
@@ -290,7 +299,7 @@ void CEllipseDetectorYaed::GetFastCenter(vector<Point> &e1, vector<Point> &e2, E
             return;
         }
 
-        q2 = GetMedianSlope(med, M12, data.Sa);
+        q2 = GetMedianSlope(med, M12, data.Sa, cache);
     }
 
     {
@@ -309,12 +318,13 @@ void CEllipseDetectorYaed::GetFastCenter(vector<Point> &e1, vector<Point> &e2, E
         data.rb = m_ref;
 
         // Find points with same slope as reference
-        vector<Point2f> med;
-        med.reserve(hsize_1);
+        vector<Point2f> &med = _med;
+        med.clear();
 
         uint minPoints = (_uNs < hsize_1) ? _uNs : hsize_1;
 
-        vector<uint> indexes(minPoints);
+        vector<uint> &indexes = _indexes;
+        indexes.resize(minPoints);
         if (_uNs < hsize_1)
         {
             unsigned iSzBin = hsize_1 / unsigned(_uNs);
@@ -405,7 +415,7 @@ void CEllipseDetectorYaed::GetFastCenter(vector<Point> &e1, vector<Point> &e2, E
             data.isValid = false;
             return;
         }
-        q4 = GetMedianSlope(med, M34, data.Sb);
+        q4 = GetMedianSlope(med, M34, data.Sb, cache);
     }
 
     if (q2 == q4)
@@ -1074,7 +1084,7 @@ Point2f CEllipseDetectorYaed::GetCenterCoordinates(EllipseData &data_ij, Ellipse
 void CEllipseDetectorYaed::Triplets124(VVP &pi,
                                        VVP &pj,
                                        VVP &pk,
-                                       unordered_map<uint, EllipseData> &data,
+                                       EllipseDataCache &data,
                                        vector<Ellipse> &ellipses
                                        )
 {
@@ -1141,35 +1151,37 @@ void CEllipseDetectorYaed::Triplets124(VVP &pi,
                 EllipseData data_ij, data_ik;
 
                 // If the data for the pair i-j have not been computed yet
-                if (data.count(key_ij) == 0)
+                const EllipseData *cached_ij = data.Find(key_ij);
+                if (cached_ij == nullptr)
                 {
                     //1,2 -> reverse 1, swap
 
                     // Compute data!
-                    GetFastCenter(edge_j, rev_i, data_ij);
+                    GetFastCenter(edge_j, rev_i, data_ij, data);
                     // Insert computed data in the hash table
-                    data.insert(pair<uint, EllipseData>(key_ij, data_ij));
+                    data.Insert(key_ij, data_ij);
                 }
                 else
                 {
                     // Otherwise, just lookup the data in the hash table
-                    data_ij = data.at(key_ij);
+                    data_ij = *cached_ij;
                 }
 
                 // If the data for the pair i-k have not been computed yet
-                if (data.count(key_ik) == 0)
+                const EllipseData *cached_ik = data.Find(key_ik);
+                if (cached_ik == nullptr)
                 {
                     //1,4 -> ok
 
                     // Compute data!
-                    GetFastCenter(edge_i, edge_k, data_ik);
+                    GetFastCenter(edge_i, edge_k, data_ik, data);
                     // Insert computed data in the hash table
-                    data.insert(pair<uint, EllipseData>(key_ik, data_ik));
+                    data.Insert(key_ik, data_ik);
                 }
                 else
                 {
                     // Otherwise, just lookup the data in the hash table
-                    data_ik = data.at(key_ik);
+                    data_ik = *cached_ik;
                 }
 
                 // INVALID CENTERS
@@ -1208,7 +1220,7 @@ void CEllipseDetectorYaed::Triplets124(VVP &pi,
 void CEllipseDetectorYaed::Triplets231(VVP &pi,
                                        VVP &pj,
                                        VVP &pk,
-                                       unordered_map<uint, EllipseData> &data,
+                                       EllipseDataCache &data,
                                        vector<Ellipse> &ellipses
                                        )
 {
@@ -1274,30 +1286,32 @@ void CEllipseDetectorYaed::Triplets231(VVP &pi,
 
                 EllipseData data_ij, data_ik;
 
-                if (data.count(key_ij) == 0)
+                const EllipseData *cached_ij = data.Find(key_ij);
+                if (cached_ij == nullptr)
                 {
                     // 2,3 -> reverse 2,3
 
-                    GetFastCenter(rev_i, rev_j, data_ij);
-                    data.insert(pair<uint, EllipseData>(key_ij, data_ij));
+                    GetFastCenter(rev_i, rev_j, data_ij, data);
+                    data.Insert(key_ij, data_ij);
                 }
                 else
                 {
-                    data_ij = data.at(key_ij);
+                    data_ij = *cached_ij;
                 }
 
-                if (data.count(key_ik) == 0)
+                const EllipseData *cached_ik = data.Find(key_ik);
+                if (cached_ik == nullptr)
                 {
                     // 2,1 -> reverse 1
                     VP rev_k(edge_k.size());
                     reverse_copy(edge_k.begin(), edge_k.end(), rev_k.begin());
 
-                    GetFastCenter(edge_i, rev_k, data_ik);
-                    data.insert(pair<uint, EllipseData>(key_ik, data_ik));
+                    GetFastCenter(edge_i, rev_k, data_ik, data);
+                    data.Insert(key_ik, data_ik);
                 }
                 else
                 {
-                    data_ik = data.at(key_ik);
+                    data_ik = *cached_ik;
                 }
 
                 // INVALID CENTERS
@@ -1327,7 +1341,7 @@ void CEllipseDetectorYaed::Triplets231(VVP &pi,
 void CEllipseDetectorYaed::Triplets342(VVP &pi,
                                        VVP &pj,
                                        VVP &pk,
-                                       unordered_map<uint, EllipseData> &data,
+                                       EllipseDataCache &data,
                                        vector<Ellipse> &ellipses
                                        )
 {
@@ -1393,32 +1407,34 @@ void CEllipseDetectorYaed::Triplets342(VVP &pi,
 
                 EllipseData data_ij, data_ik;
 
-                if (data.count(key_ij) == 0)
+                const EllipseData *cached_ij = data.Find(key_ij);
+                if (cached_ij == nullptr)
                 {
                     //3,4 -> reverse 4
 
-                    GetFastCenter(edge_i, rev_j, data_ij);
-                    data.insert(pair<uint, EllipseData>(key_ij, data_ij));
+                    GetFastCenter(edge_i, rev_j, data_ij, data);
+                    data.Insert(key_ij, data_ij);
                 }
                 else
                 {
-                    data_ij = data.at(key_ij);
+                    data_ij = *cached_ij;
                 }
 
-                if (data.count(key_ik) == 0)
+                const EllipseData *cached_ik = data.Find(key_ik);
+                if (cached_ik == nullptr)
                 {
                     //3,2 -> reverse 3,2
 
                     VP rev_k(edge_k.size());
                     reverse_copy(edge_k.begin(), edge_k.end(), rev_k.begin());
 
-                    GetFastCenter(rev_i, rev_k, data_ik);
+                    GetFastCenter(rev_i, rev_k, data_ik, data);
 
-                    data.insert(pair<uint, EllipseData>(key_ik, data_ik));
+                    data.Insert(key_ik, data_ik);
                 }
                 else
                 {
-                    data_ik = data.at(key_ik);
+                    data_ik = *cached_ik;
                 }
 
                 // INVALID CENTERS
@@ -1448,7 +1464,7 @@ void CEllipseDetectorYaed::Triplets342(VVP &pi,
 void CEllipseDetectorYaed::Triplets413(VVP &pi,
                                        VVP &pj,
                                        VVP &pk,
-                                       unordered_map<uint, EllipseData> &data,
+                                       EllipseDataCache &data,
                                        vector<Ellipse> &ellipses
                                        )
 {
@@ -1511,26 +1527,28 @@ void CEllipseDetectorYaed::Triplets413(VVP &pi,
 
                 EllipseData data_ij, data_ik;
 
-                if (data.count(key_ij) == 0)
+                const EllipseData *cached_ij = data.Find(key_ij);
+                if (cached_ij == nullptr)
                 {
                     // 4,1 -> OK
-                    GetFastCenter(edge_i, edge_j, data_ij);
-                    data.insert(pair<uint, EllipseData>(key_ij, data_ij));
+                    GetFastCenter(edge_i, edge_j, data_ij, data);
+                    data.Insert(key_ij, data_ij);
                 }
                 else
                 {
-                    data_ij = data.at(key_ij);
+                    data_ij = *cached_ij;
                 }
 
-                if (data.count(key_ik) == 0)
+                const EllipseData *cached_ik = data.Find(key_ik);
+                if (cached_ik == nullptr)
                 {
                     // 4,3 -> reverse 4
-                    GetFastCenter(rev_i, edge_k, data_ik);
-                    data.insert(pair<uint, EllipseData>(key_ik, data_ik));
+                    GetFastCenter(rev_i, edge_k, data_ik, data);
+                    data.Insert(key_ik, data_ik);
                 }
                 else
                 {
-                    data_ik = data.at(key_ik);
+                    data_ik = *cached_ik;
                 }
 
                 // INVALID CENTERS
@@ -1557,6 +1575,92 @@ void CEllipseDetectorYaed::Triplets413(VVP &pi,
 };
 
 
+// Runs the four triplet passes.  Done sequentially, the passes share one
+// cache of EllipseData.  Done in parallel, each pass runs on its own copy of
+// the detector, with its own accumulators and cache, and the detections are
+// then appended in the sequential pass order.  So the result does not depend
+// on how the threads happen to be scheduled.
+// The caches are kept for the life of the thread and reset for each image,
+// so they only allocate while they grow.
+void CEllipseDetectorYaed::FindTriplets(VVP &points_1,
+                                        VVP &points_2,
+                                        VVP &points_3,
+                                        VVP &points_4,
+                                        vector<Ellipse> &ellipses
+                                        )
+{
+    if (!_bParallelTriplets)
+    {
+        thread_local EllipseDataCache centers;      //hash table for reusing
+                                                    // already computed
+                                                    // EllipseData
+        centers.Reset();
+
+        Triplets124(points_1, points_2, points_4, centers, ellipses);
+        Triplets231(points_2, points_3, points_1, centers, ellipses);
+        Triplets342(points_3, points_4, points_2, centers, ellipses);
+        Triplets413(points_4, points_1, points_3, centers, ellipses);
+        return;
+    }
+
+    const int kNumberOfPasses = 4;
+
+    vector<CEllipseDetectorYaed> passDetectors(kNumberOfPasses, *this);
+    vector<vector<Ellipse> > passEllipses(kNumberOfPasses);
+
+    cv::parallel_for_(cv::Range(0, kNumberOfPasses), [&](const cv::Range &range)
+        {
+            for (int pass = range.start; pass < range.end; ++pass)
+            {
+                CEllipseDetectorYaed &detector = passDetectors[pass];
+
+                vector<int> passAccN(ACC_N_SIZE);
+                vector<int> passAccR(ACC_R_SIZE);
+                vector<int> passAccA(ACC_A_SIZE);
+                detector.accN = passAccN.data();
+                detector.accR = passAccR.data();
+                detector.accA = passAccA.data();
+
+                thread_local EllipseDataCache passCenters;
+                passCenters.Reset();
+
+                switch (pass)
+                {
+                    case 0:
+                        detector.Triplets124(points_1, points_2, points_4, passCenters,
+                                             passEllipses[pass]);
+                        break;
+                    case 1:
+                        detector.Triplets231(points_2, points_3, points_1, passCenters,
+                                             passEllipses[pass]);
+                        break;
+                    case 2:
+                        detector.Triplets342(points_3, points_4, points_2, passCenters,
+                                             passEllipses[pass]);
+                        break;
+                    default:
+                        detector.Triplets413(points_4, points_1, points_3, passCenters,
+                                             passEllipses[pass]);
+                        break;
+                }
+            }
+        }, kNumberOfPasses);
+
+    // Merge in pass order.  The estimation and validation times are the
+    // totals over all of the passes.
+    double estimationTime = _times[3];
+    double validationTime = _times[4];
+
+    for (int pass = 0; pass < kNumberOfPasses; ++pass)
+    {
+        ellipses.insert(ellipses.end(), passEllipses[pass].begin(), passEllipses[pass].end());
+
+        _times[3] += passDetectors[pass]._times[3] - estimationTime;
+        _times[4] += passDetectors[pass]._times[4] - validationTime;
+    }
+}
+
+
 void CEllipseDetectorYaed::RemoveShortEdges(cv::Mat &edges, cv::Mat &clean)
 {
     VVP contours;
@@ -1692,19 +1796,13 @@ void CEllipseDetectorYaed::DetectAfterPreProcessing(vector<Ellipse> &ellipses,
     // Other temporary
     VVP points_1, points_2, points_3, points_4;     //vector of points, one for
                                                     // each convexity class
-    unordered_map<uint, EllipseData> centers;       //hash map for reusing
-                                                    // already computed
-                                                    // EllipseData
 
     // Detect edges and find convexities
     DetectEdges13(DP, points_1, points_3);
     DetectEdges24(DN, points_2, points_4);
 
     // Find triplets
-    Triplets124(points_1, points_2, points_4, centers, ellipses);
-    Triplets231(points_2, points_3, points_1, centers, ellipses);
-    Triplets342(points_3, points_4, points_2, centers, ellipses);
-    Triplets413(points_4, points_1, points_3, centers, ellipses);
+    FindTriplets(points_1, points_2, points_3, points_4, ellipses);
 
     // Sort detected ellipses with respect to score
     sort(ellipses.begin(), ellipses.end());
@@ -1751,9 +1849,6 @@ void CEllipseDetectorYaed::Detect(cv::Mat &I, vector<Ellipse> &ellipses)
     // Other temporary
     VVP points_1, points_2, points_3, points_4;     //vector of points, one for
                                                     // each convexity class
-    unordered_map<uint, EllipseData> centers;       //hash map for reusing
-                                                    // already computed
-                                                    // EllipseData
 
     Toc(1); //prepare data structure
 
@@ -1818,10 +1913,7 @@ void CEllipseDetectorYaed::Detect(cv::Mat &I, vector<Ellipse> &ellipses)
 
     Tic(2); //grouping
     //find triplets
-    Triplets124(points_1, points_2, points_4, centers, ellipses);
-    Triplets231(points_2, points_3, points_1, centers, ellipses);
-    Triplets342(points_3, points_4, points_2, centers, ellipses);
-    Triplets413(points_4, points_1, points_3, centers, ellipses);
+    FindTriplets(points_1, points_2, points_3, points_4, ellipses);
     Toc(2); //grouping
     // time estimation, validation inside
     _times[2] -= (_times[3] + _times[4]);
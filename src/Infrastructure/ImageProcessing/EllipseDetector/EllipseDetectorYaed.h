@@ -31,10 +31,11 @@
 #include <stdio.h>
 #include <algorithm>
 #include <numeric>
-#include <unordered_map>
+#include <span>
 #include <vector>
 
 #include "Infrastructure/ImageProcessing/EllipseDetector/EllipseDetectorCommon.h"
+#include "Infrastructure/ImageProcessing/EllipseDetector/EllipseDataCache.h"
 #include <time.h>
 
 using namespace std;
@@ -48,25 +49,6 @@ namespace PiTrac
 //#define DISCARD_CONSTRAINT_CENTER
 
 
-// Data available after selection strategy.
-// They are kept in an associative array to:
-// 1) avoid recomputing data when starting from same arcs
-// 2) be reused in further proprecessing
-struct EllipseData
-{
-    bool isValid;
-    float ta;
-    float tb;
-    float ra;
-    float rb;
-    Point2f Ma;
-    Point2f Mb;
-    Point2f Cab;
-    vector<float> Sa;
-    vector<float> Sb;
-};
-
-
 class CEllipseDetectorYaed
 {
     // Parameters
@@ -138,6 +120,14 @@ class CEllipseDetectorYaed
     int *accR;              // pointer to accumulator R
     int *accA;              // pointer to accumulator A
 
+    bool _bParallelTriplets;    // run the four triplet passes concurrently
+
+    // Scratch space for GetFastCenter and GetMedianSlope, kept between calls
+    vector<Point2f> _med;
+    vector<uint> _indexes;
+    vector<float> _xx;
+    vector<float> _yy;
+
   public:
 
     //Constructor and Destructor
@@ -169,6 +159,15 @@ class CEllipseDetectorYaed
                             int iNs
                             );
 
+    // If set, the four triplet passes run concurrently, each with its own
+    // accumulators and EllipseData cache.  Arc pairs that the passes would
+    // otherwise share through the cache are computed by each pass that uses
+    // them, which can slightly change which ellipses are found.
+    void SetParallelTriplets(bool bParallelTriplets)
+    {
+        _bParallelTriplets = bParallelTriplets;
+    }
+
     // Return the execution time
     double GetExecTime()
     {
@@ -205,8 +204,14 @@ class CEllipseDetectorYaed
     int FindMaxN(const int *v) const;
     int FindMaxA(const int *v) const;
 
-    float GetMedianSlope(vector<Point2f> &med, Point2f &M, vector<float> &slopes);
-    void GetFastCenter  (vector<Point> &e1, vector<Point> &e2, EllipseData &data);
+    float GetMedianSlope(vector<Point2f> &med,
+                         Point2f &M,
+                         span<float> &slopes,
+                         EllipseDataCache &cache);
+    void GetFastCenter  (vector<Point> &e1,
+                         vector<Point> &e2,
+                         EllipseData &data,
+                         EllipseDataCache &cache);
 
 
     void DetectEdges13(cv::Mat &DP, VVP &points_1, VVP &points_3);
@@ -222,6 +227,13 @@ class CEllipseDetectorYaed
                             );
 
     Point2f GetCenterCoordinates(EllipseData &data_ij, EllipseData &data_ik);
+
+    void FindTriplets   (   VVP &points_1,
+                            VVP &points_2,
+                            VVP &points_3,
+                            VVP &points_4,
+                            vector<Ellipse> &ellipses
+                            );
     Point2f _GetCenterCoordinates(EllipseData &data_ij, EllipseData &data_ik);
 
 
@@ -229,28 +241,28 @@ class CEllipseDetectorYaed
     void Triplets124    (   VVP &pi,
                             VVP &pj,
                             VVP &pk,
-                            unordered_map<uint, EllipseData> &data,
+                            EllipseDataCache &data,
                             vector<Ellipse> &ellipses
                             );
 
     void Triplets231    (   VVP &pi,
                             VVP &pj,
                             VVP &pk,
-                            unordered_map<uint, EllipseData> &data,
+                            EllipseDataCache &data,
                             vector<Ellipse> &ellipses
                             );
 
     void Triplets342    (   VVP &pi,
                             VVP &pj,
                             VVP &pk,
-                            unordered_map<uint, EllipseData> &data,
+                            EllipseDataCache &data,
                             vector<Ellipse> &ellipses
                             );
 
     void Triplets413    (   VVP &pi,
                             VVP &pj,
                             VVP &pk,
-                            unordered_map<uint, EllipseData> &data,
+                            EllipseDataCache &data,
                             vector<Ellipse> &ellipses
                             );
 
@@ -0,0 +1,304 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "Infrastructure/ImageProcessing/HoughCircleAccumulator.h"
+
+namespace PiTrac
+{
+// A thin (Canny) circle of radius r has about 4 * sqrt(2) * r pixels
+static const double kEdgePixelsPerRadiusPixel = 4.0 * std::sqrt(2.0);
+
+void HoughCircleAccumulator::Detect(const cv::Mat &image,
+                                    cv::HoughModes method,
+                                    double dp,
+                                    double param1,
+                                    int min_radius,
+                                    int max_radius,
+                                    int min_center_votes,
+                                    std::vector<HoughCircleCandidate> &candidates)
+{
+    candidates.clear();
+
+    if (image.empty() || image.type() != CV_8UC1 || dp <= 0.0)
+    {
+        return;
+    }
+
+    min_radius = std::max(min_radius, 0);
+
+    if (max_radius <= 0)
+    {
+        max_radius = std::max(image.rows, image.cols);
+    }
+
+    if (max_radius < min_radius)
+    {
+        return;
+    }
+
+    // Same edge detection as cv::HoughCircles, which uses Scharr derivatives
+    // for the _ALT method
+    cv::Mat dx;
+    cv::Mat dy;
+
+    if (method == cv::HOUGH_GRADIENT_ALT)
+    {
+        cv::Scharr(image, dx, CV_16S, 1, 0);
+        cv::Scharr(image, dy, CV_16S, 0, 1);
+    }
+    else
+    {
+        cv::Sobel(image, dx, CV_16S, 1, 0, 3);
+        cv::Sobel(image, dy, CV_16S, 0, 1, 3);
+    }
+
+    double canny_upper = std::max(param1, 1.0);
+    cv::Mat edges;
+    cv::Canny(dx, dy, edges, std::max(canny_upper / 2.0, 1.0), canny_upper);
+
+    const double idp = 1.0 / dp;
+    const int accumulator_rows = (int)std::ceil(image.rows * idp) + 1;
+    const int accumulator_cols = (int)std::ceil(image.cols * idp) + 1;
+    cv::Mat accumulator = cv::Mat::zeros(accumulator_rows, accumulator_cols, CV_32SC1);
+
+    // The edge points are collected in row order, which later lets each
+    // center find the points near it with a binary search
+    std::vector<cv::Point> edge_points;
+
+    for (int y = 0; y < edges.rows; y++)
+    {
+        const uchar *edge_row = edges.ptr<uchar>(y);
+        const short *dx_row = dx.ptr<short>(y);
+        const short *dy_row = dy.ptr<short>(y);
+
+        for (int x = 0; x < edges.cols; x++)
+        {
+            if (edge_row[x] == 0)
+            {
+                continue;
+            }
+
+            float vx = (float)dx_row[x];
+            float vy = (float)dy_row[x];
+            float magnitude = std::sqrt(vx * vx + vy * vy);
+
+            if (magnitude < 1.0f)
+            {
+                continue;
+            }
+
+            edge_points.emplace_back(x, y);
+
+            // Vote along the gradient in both directions, one image pixel of
+            // radius at a time
+            float sx = vx / magnitude;
+            float sy = vy / magnitude;
+
+            for (int direction = 0; direction < 2; direction++)
+            {
+                for (int r = min_radius; r <= max_radius; r++)
+                {
+                    int ax = (int)std::lround((x + r * sx) * idp);
+                    int ay = (int)std::lround((y + r * sy) * idp);
+
+                    if (ax < 0 || ax >= accumulator_cols || ay < 0 || ay >= accumulator_rows)
+                    {
+                        break;
+                    }
+
+                    accumulator.at<int>(ay, ax)++;
+                }
+
+                sx = -sx;
+                sy = -sy;
+            }
+        }
+    }
+
+    // The centers are the local maxima of the accumulator
+    for (int y = 1; y < accumulator_rows - 1; y++)
+    {
+        const int *above = accumulator.ptr<int>(y - 1);
+        const int *row = accumulator.ptr<int>(y);
+        const int *below = accumulator.ptr<int>(y + 1);
+
+        for (int x = 1; x < accumulator_cols - 1; x++)
+        {
+            int votes = row[x];
+
+            if (votes > min_center_votes &&
+                votes > row[x - 1] && votes >= row[x + 1] &&
+                votes > above[x] && votes >= below[x])
+            {
+                HoughCircleCandidate candidate;
+                candidate.circle = cv::Vec3f((float)(x * dp), (float)(y * dp), 0.0f);
+                candidate.center_votes = votes;
+                candidates.push_back(candidate);
+            }
+        }
+    }
+
+    // For each center, pick the radius (a two pixel wide annulus) with the
+    // most edge points
+    auto findRadii = [&](const cv::Range &range)
+                     {
+                         std::vector<int> counts(max_radius + 2);
+                         std::vector<double> distance_sums(max_radius + 2);
+
+                         for (int i = range.start; i < range.end; i++)
+                         {
+                             HoughCircleCandidate &candidate = candidates[i];
+                             float cx = candidate.circle[0];
+                             float cy = candidate.circle[1];
+
+                             std::fill(counts.begin(), counts.end(), 0);
+                             std::fill(distance_sums.begin(), distance_sums.end(), 0.0);
+
+                             auto first = std::lower_bound(edge_points.begin(),
+                                                           edge_points.end(),
+                                                           (int)std::floor(cy - max_radius),
+                                                           [](const cv::Point &p, int y)
+                                 {
+                                     return p.y < y;
+                                 });
+
+                             for (auto p = first; p != edge_points.end(); ++p)
+                             {
+                                 float dy = (float)p->y - cy;
+
+                                 if (dy > max_radius)
+                                 {
+                                     break;
+                                 }
+
+                                 float dx = (float)p->x - cx;
+
+                                 if (std::abs(dx) > max_radius)
+                                 {
+                                     continue;
+                                 }
+
+                                 double distance = std::sqrt(dx * dx + dy * dy);
+
+                                 if (distance < min_radius || distance > max_radius)
+                                 {
+                                     continue;
+                                 }
+
+                                 counts[(int)distance]++;
+                                 distance_sums[(int)distance] += distance;
+                             }
+
+                             int best_count = 0;
+                             double best_radius = 0.0;
+
+                             for (int r = min_radius; r <= max_radius; r++)
+                             {
+                                 int count = counts[r] + counts[r + 1];
+
+                                 if (count > best_count)
+                                 {
+                                     best_count = count;
+                                     best_radius = (distance_sums[r] + distance_sums[r + 1]) /
+                                                   count;
+                                 }
+                             }
+
+                             candidate.circle[2] = (float)best_radius;
+                             candidate.radius_votes = best_count;
+                             candidate.coverage = (best_radius > 0.0) ?
+                                                  (float)std::min(1.0, best_count /
+                                                                  (kEdgePixelsPerRadiusPixel *
+                                                                   best_radius)) :
+                                                  0.0f;
+                         }
+                     };
+
+    cv::parallel_for_(cv::Range(0, (int)candidates.size()), findRadii);
+
+    candidates.erase(std::remove_if(candidates.begin(),
+                                    candidates.end(),
+                                    [](const HoughCircleCandidate &candidate)
+        {
+            return candidate.radius_votes == 0;
+        }),
+                     candidates.end());
+}
+
+void HoughCircleAccumulator::Select(const std::vector<HoughCircleCandidate> &candidates,
+                                    cv::HoughModes method,
+                                    double param2,
+                                    double min_dist,
+                                    std::vector<cv::Vec3f> &circles)
+{
+    circles.clear();
+
+    // A circle is only as strong as the weaker of its center and its radius
+    std::vector<double> strengths(candidates.size());
+    std::vector<int> passing;
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        const HoughCircleCandidate &candidate = candidates[i];
+
+        if (method == cv::HOUGH_GRADIENT_ALT)
+        {
+            strengths[i] = candidate.coverage;
+
+            if (strengths[i] >= param2)
+            {
+                passing.push_back((int)i);
+            }
+        }
+        else
+        {
+            strengths[i] = std::min(candidate.center_votes, candidate.radius_votes);
+
+            if (strengths[i] > param2)
+            {
+                passing.push_back((int)i);
+            }
+        }
+    }
+
+    std::stable_sort(passing.begin(),
+                     passing.end(),
+                     [&](int a, int b)
+        {
+            return strengths[a] > strengths[b];
+        });
+
+    // Each circle can only be suppressed by a stronger one, which would also
+    // have passed any tighter threshold.  So this gives the same result as
+    // thresholding before the transform.
+    double min_dist_squared = min_dist * min_dist;
+
+    for (int i : passing)
+    {
+        const cv::Vec3f &circle = candidates[i].circle;
+        bool too_close = false;
+
+        for (const cv::Vec3f &kept : circles)
+        {
+            double dx = circle[0] - kept[0];
+            double dy = circle[1] - kept[1];
+
+            if (dx * dx + dy * dy < min_dist_squared)
+            {
+                too_close = true;
+                break;
+            }
+        }
+
+        if (!too_close)
+        {
+            circles.push_back(circle);
+        }
+    }
+}
+}
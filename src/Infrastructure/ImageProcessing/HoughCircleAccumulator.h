@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// A gradient Hough circle transform that keeps the support (votes) of every
+// circle it finds.  cv::HoughCircles applies its param2 threshold inside the
+// transform, so finding the param2 that gives a reasonable number of circles
+// means running the whole transform again for each value that is tried.
+// Here the accumulator is built just once, at the loosest threshold of interest,
+// and each param2 is then only a (cheap) selection over the candidates.
+
+#ifndef PI_TRAC_HOUGH_CIRCLE_ACCUMULATOR_H
+#define PI_TRAC_HOUGH_CIRCLE_ACCUMULATOR_H
+
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+#include <opencv4/opencv2/imgproc.hpp>
+
+
+namespace PiTrac
+{
+// One potential circle and the support it had in the transform
+struct HoughCircleCandidate
+{
+    // x, y, radius - in the same coordinates as cv::HoughCircles returns
+    cv::Vec3f circle;
+
+    // Number of gradient lines that passed through the center
+    int center_votes = 0;
+
+    // Number of edge pixels at (about) the chosen radius
+    int radius_votes = 0;
+
+    // radius_votes as a fraction of the number of edge pixels a perfect
+    // (thin) circle of this radius would have.  Between 0 and 1.
+    float coverage = 0.0f;
+};
+
+class HoughCircleAccumulator
+{
+  public:
+
+    // Runs the transform over image (CV_8UC1).  method, dp and param1 mean the
+    // same as they do for cv::HoughCircles.  Every center with more than
+    // min_center_votes is returned, together with its best radius in
+    // [min_radius, max_radius].
+    static void Detect(const cv::Mat &image,
+                       cv::HoughModes method,
+                       double dp,
+                       double param1,
+                       int min_radius,
+                       int max_radius,
+                       int min_center_votes,
+                       std::vector<HoughCircleCandidate> &candidates);
+
+    // Returns the circles that pass param2, strongest first, with no two
+    // centers closer than min_dist.  For HOUGH_GRADIENT, param2 is a vote
+    // count that both the center and the radius must exceed.  For
+    // HOUGH_GRADIENT_ALT, it is the minimum coverage, which is close to (but
+    // not exactly) the circle "perfectness" that OpenCV uses.
+    // The result for any param2 is the same as running the transform with
+    // that threshold, as long as it is not looser than the one used by Detect.
+    static void Select(const std::vector<HoughCircleCandidate> &candidates,
+                       cv::HoughModes method,
+                       double param2,
+                       double min_dist,
+                       std::vector<cv::Vec3f> &circles);
+};
+}
+
+#endif // PI_TRAC_HOUGH_CIRCLE_ACCUMULATOR_H
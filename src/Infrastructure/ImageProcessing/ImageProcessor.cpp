@@ -12,8 +12,17 @@
 
 
 #include <ranges>
+#include <array>
+#include <atomic>
 #include <algorithm>
+#include <deque>
+#include <future>
 #include <vector>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <set>
+#include <tuple>
 
 #include <boost/timer/timer.hpp>
 #include <boost/math/special_functions/erf.hpp>
@@ -42,6 +51,11 @@
 #include "Infrastructure/ImageProcessing/EdgeDrawing/EDPF.h"
 #include "Infrastructure/ImageProcessing/EdgeDrawing/EDColor.h"
 
+// Hough circle detection
+#include "Infrastructure/ImageProcessing/HoughCircleAccumulator.h"
+#include "Infrastructure/ImageProcessing/CircleRefiner.h"
+#include "Infrastructure/ImageProcessing/SearchImagePreprocessor.h"
+
 namespace PiTrac
 {
 // Currently, equalizing the brightness of the input images appears to help the
@@ -157,6 +171,12 @@ int BallImageProc::kExternallyStrobedEnvNarrowingPreHoughBlurSize = 9;
 int BallImageProc::kExternallyStrobedEnvMinimumSearchRadius = 60;
 int BallImageProc::kExternallyStrobedEnvMaximumSearchRadius = 80;
 
+bool BallImageProc::kUseSinglePassHoughAccumulator = false;
+bool BallImageProc::kUseColorMaskLut = false;
+bool BallImageProc::kUseFusedSearchImagePreprocessing = false;
+bool BallImageProc::kUseConcurrentHoughStrategies = false;
+bool BallImageProc::kUseParallelEllipseTriplets = false;
+
 bool BallImageProc::kUseDynamicRadiiAdjustment = true;
 int BallImageProc::kNumberRadiiToAverageForDynamicAdjustment = 3;
 double BallImageProc::kStrobedNarrowingRadiiMinRatio = 0.8;
@@ -204,10 +224,55 @@ int BallImageProc::kExternallyStrobedCLAHETilesGridSize = 6;
 
 double BallImageProc::kBestCircleIdentificationMinRadiusRatio = 0.85;
 double BallImageProc::kBestCircleIdentificationMaxRadiusRatio = 1.10;
+bool BallImageProc::kUseLeastSquaresBestCircleRefinement = false;
 
 int BallImageProc::kGaborMaxWhitePercent = 44;     // Nominal 46;
 int BallImageProc::kGaborMinWhitePercent = 38;     // Nominal 40;
 
+bool BallImageProc::kUseSphereProjectionCache = true;
+bool BallImageProc::kUseBitplaneImageComparison = true;
+bool BallImageProc::kUseStreamingCandidateScoring = true;
+
+int BallImageProc::kSpinPyramidLevels = 1;
+int BallImageProc::kSpinPyramidTopK = 4;
+std::vector<float> BallImageProc::kSpinPyramidLevelXIncrementDegrees;
+std::vector<float> BallImageProc::kSpinPyramidLevelYIncrementDegrees;
+std::vector<float> BallImageProc::kSpinPyramidLevelZIncrementDegrees;
+
+bool BallImageProc::kUseSpinOptimizerForFineSearch = false;
+double BallImageProc::kSpinOptimizerToleranceDegrees = 0.25;
+int BallImageProc::kSpinOptimizerMaxEvaluations = 60;
+
+bool BallImageProc::kUseBranchAndBoundCandidateScoring = true;
+
+bool BallImageProc::kUseSpinSearchPrior = false;
+std::vector<float> BallImageProc::kSpinPriorDriverRange;
+std::vector<float> BallImageProc::kSpinPriorIronRange;
+int BallImageProc::kSpinPriorHistorySize = 8;
+int BallImageProc::kSpinPriorMinHistoryShots = 3;
+double BallImageProc::kSpinPriorHistoryWindowDegrees = 20.0;
+double BallImageProc::kSpinPriorMinScore = 0.6;
+
+// Recent raw spin results, by club type, for the spin search prior
+static std::mutex spin_prior_history_mutex;
+static std::map<int, std::deque<cv::Vec3d> > spin_prior_history;
+
+// Beyond this, the lowest-resolution images would be too small to hold any
+// dimple detail
+static const int kMaxSpinPyramidLevels = 3;
+
+// Pixel comparisons skipped by the candidate bound during the current
+// GetBallRotation call.  The candidate scoring is always called from the same
+// thread as GetBallRotation, so these are per-shot even if several ball pairs
+// are processed at once.
+static thread_local long spin_pixel_comparisons = 0;
+static thread_local long spin_pixel_comparisons_skipped = 0;
+
+// The projection tables are keyed by image size and ball geometry.  In
+// practice, there are only ever a handful of different ball radii in use, so
+// the cache is simply flushed if it ever grows beyond this size.
+static const size_t kMaxSphereProjectionTables = 16;
+
 BallImageProc::BallImageProc()
 {
     min_ball_radius_ = -1;
@@ -238,6 +303,50 @@ BallImageProc::BallImageProc()
                                       kGaborMinWhitePercent);
     GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kGaborMaxWhitePercent",
                                       kGaborMaxWhitePercent);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kUseSphereProjectionCache",
+                                      kUseSphereProjectionCache);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kUseBitplaneImageComparison",
+                                      kUseBitplaneImageComparison);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kUseStreamingCandidateScoring",
+                                      kUseStreamingCandidateScoring);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPyramidLevels",
+                                      kSpinPyramidLevels);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPyramidTopK",
+                                      kSpinPyramidTopK);
+    // The vector version of SetConstant appends
+    kSpinPyramidLevelXIncrementDegrees.clear();
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPyramidLevelXIncrementDegrees",
+                                      kSpinPyramidLevelXIncrementDegrees);
+    kSpinPyramidLevelYIncrementDegrees.clear();
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPyramidLevelYIncrementDegrees",
+                                      kSpinPyramidLevelYIncrementDegrees);
+    kSpinPyramidLevelZIncrementDegrees.clear();
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPyramidLevelZIncrementDegrees",
+                                      kSpinPyramidLevelZIncrementDegrees);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kUseSpinOptimizerForFineSearch",
+                                      kUseSpinOptimizerForFineSearch);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinOptimizerToleranceDegrees",
+                                      kSpinOptimizerToleranceDegrees);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinOptimizerMaxEvaluations",
+                                      kSpinOptimizerMaxEvaluations);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kUseBranchAndBoundCandidateScoring",
+                                      kUseBranchAndBoundCandidateScoring);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kUseSpinSearchPrior",
+                                      kUseSpinSearchPrior);
+    kSpinPriorDriverRange.clear();
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPriorDriverRange",
+                                      kSpinPriorDriverRange);
+    kSpinPriorIronRange.clear();
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPriorIronRange",
+                                      kSpinPriorIronRange);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPriorHistorySize",
+                                      kSpinPriorHistorySize);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPriorMinHistoryShots",
+                                      kSpinPriorMinHistoryShots);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPriorHistoryWindowDegrees",
+                                      kSpinPriorHistoryWindowDegrees);
+    GolfSimConfiguration::SetConstant("gs_config.spin_analysis.kSpinPriorMinScore",
+                                      kSpinPriorMinScore);
 
     GolfSimConfiguration::SetConstant("gs_config.ball_identification.kPlacedBallCannyLower",
                                       kPlacedBallCannyLower);
@@ -440,8 +549,26 @@ BallImageProc::BallImageProc()
     GolfSimConfiguration::SetConstant(
         "gs_config.ball_identification.kBestCircleIdentificationMaxRadiusRatio",
         kBestCircleIdentificationMaxRadiusRatio);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_identification.kUseLeastSquaresBestCircleRefinement",
+        kUseLeastSquaresBestCircleRefinement);
 
 
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_identification.kUseSinglePassHoughAccumulator",
+        kUseSinglePassHoughAccumulator);
+    GolfSimConfiguration::SetConstant("gs_config.ball_identification.kUseColorMaskLut",
+                                      kUseColorMaskLut);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_identification.kUseFusedSearchImagePreprocessing",
+        kUseFusedSearchImagePreprocessing);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_identification.kUseConcurrentHoughStrategies",
+        kUseConcurrentHoughStrategies);
+    GolfSimConfiguration::SetConstant(
+        "gs_config.ball_identification.kUseParallelEllipseTriplets",
+        kUseParallelEllipseTriplets);
+
     GolfSimConfiguration::SetConstant("gs_config.ball_identification.kUseDynamicRadiiAdjustment",
                                       kUseDynamicRadiiAdjustment);
     GolfSimConfiguration::SetConstant(
@@ -568,7 +695,7 @@ bool BallImageProc::PreProcessStrobedImage( cv::Mat &search_image,
 
     if (search_mode == kStrobed)
     {
-        if (kStrobedBallsUseAltHoughAlgorithm)
+        if (UseAltHoughAlgorithm())
         {
             canny_lower = kStrobedBallsAltCannyLower;
             canny_upper = kStrobedBallsAltCannyUpper;
@@ -702,77 +829,138 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
                      LoggingTools::FormatGsColorTriplet(baseBallWithSearchParams.average_color_));
     LoggingTools::DebugShowImage(image_name_ + "  rgbImg", rgbImg);
 
-    // Blur the image to reduce noise - TBD - Would medianBlur be better ?
-    // img_blur = cv::medianBlur(grayImage, 5)
-    // Blur the image before trying to identify circles (if desired)
-    cv::Mat blurImg = area_mask_image_.clone();
+    cv::Mat blurImg;
+    cv::Mat search_image;
+
+    // The fused preprocessing cannot AND with a color mask that was set up
+    // before the call
+    bool use_fused_preprocessing = kUseFusedSearchImagePreprocessing &&
+                                   rgbImg.type() == CV_8UC3 &&
+                                   (!IS_COLOR_MASKING || color_mask_image_.empty());
 
-    // This seems touchy, too.  Nominal is 7 right now.
-    if (PREBLUR_IMAGE)
+    if (use_fused_preprocessing)
     {
-        cv::GaussianBlur(rgbImg, blurImg, cv::Size(7, 7), 0);      // nominal
-                                                                   // was 11x11
-        LoggingTools::DebugShowImage(image_name_ + "  Pre-blurred image", blurImg);
+        // Blur, gray conversion and color masking in one pass over the image.
+        // The color mask is only made if it will be used, and in the same way
+        // as the whole-image path below would make it.
+        int blur_size = PREBLUR_IMAGE ? 7 : 0;
+
+        if (!IS_COLOR_MASKING)
+        {
+            SearchImagePreprocessor::Process(rgbImg,
+                                             blur_size,
+                                             nullptr,
+                                             search_image_buffer_,
+                                             color_mask_image_);
+        }
+        else if (kUseColorMaskLut)
+        {
+            SearchImagePreprocessor::Process(rgbImg,
+                                             blur_size,
+                                             &GetColorMaskLut(baseBallWithSearchParams),
+                                             search_image_buffer_,
+                                             color_mask_image_);
+        }
+        else
+        {
+            cv::Scalar lowerHsv = baseBallWithSearchParams.GetBallLowerHSV(
+                baseBallWithSearchParams.ball_color_);
+            cv::Scalar upperHsv = baseBallWithSearchParams.GetBallUpperHSV(
+                baseBallWithSearchParams.ball_color_);
+
+            SearchImagePreprocessor::ProcessWithHsvMask(rgbImg,
+                                                        blur_size,
+                                                        [&](const cv::Mat &hsvImage)
+                {
+                    return GetColorMaskImage(hsvImage, lowerHsv, upperHsv);
+                },
+                                                        search_image_buffer_,
+                                                        color_mask_image_);
+        }
+        search_image = search_image_buffer_;
+        blurImg = rgbImg;
     }
     else
     {
-        blurImg = rgbImg.clone();
-    }
+        // Blur the image to reduce noise - TBD - Would medianBlur be better ?
+        // img_blur = cv::medianBlur(grayImage, 5)
+        // Blur the image before trying to identify circles (if desired)
+        blurImg = area_mask_image_.clone();
 
-    // construct a colorMask for the expected ball color range
-    // Note - We want to UNDER-colorMask if anything.Just get rid of stuff that
-    // is
-    // pretty certainly NOT the golf ball
-    // Need an HSV image to work with the HSV-based masking function
-    int stype = blurImg.type();
+        // This seems touchy, too.  Nominal is 7 right now.
+        if (PREBLUR_IMAGE)
+        {
+            cv::GaussianBlur(rgbImg, blurImg, cv::Size(7, 7), 0);      // nominal
+                                                                       // was 11x11
+            LoggingTools::DebugShowImage(image_name_ + "  Pre-blurred image", blurImg);
+        }
+        else
+        {
+            blurImg = rgbImg.clone();
+        }
 
-    if (stype == CV_8U)
-    {
-        GS_LOG_MSG(error,
-                   "GetBall called with a 1-channel (grayscale?) image.  Expecting 3 channel RGB");
-        return false;
-    }
+        // construct a colorMask for the expected ball color range
+        // Note - We want to UNDER-colorMask if anything.Just get rid of stuff that
+        // is
+        // pretty certainly NOT the golf ball
+        // Need an HSV image to work with the HSV-based masking function
+        int stype = blurImg.type();
 
-    // We will create our own colorMask if we don't have one already
-    // We will not do anything with the areaMask(other than to apply it further
-    // below if it exists)
-    if (color_mask_image_.empty())
-    {
-        cv::Mat hsvImage;
-        cv::cvtColor(blurImg, hsvImage, cv::COLOR_BGR2HSV);
+        if (stype == CV_8U)
+        {
+            GS_LOG_MSG(error,
+                       "GetBall called with a 1-channel (grayscale?) image.  Expecting 3 channel RGB");
+            return false;
+        }
 
-        // Save the colorMask for later debugging as well as for use below
-        color_mask_image_ = GetColorMaskImage(hsvImage, baseBallWithSearchParams);
-    }
+        // We will create our own colorMask if we don't have one already
+        // We will not do anything with the areaMask(other than to apply it further
+        // below if it exists)
+        if (color_mask_image_.empty())
+        {
+            if (kUseColorMaskLut)
+            {
+                color_mask_image_ = GetColorMaskImageFromBgr(blurImg, baseBallWithSearchParams);
+            }
+            else
+            {
+                cv::Mat hsvImage;
+                cv::cvtColor(blurImg, hsvImage, cv::COLOR_BGR2HSV);
+
+                // Save the colorMask for later debugging as well as for use below
+                color_mask_image_ = GetColorMaskImage(hsvImage, baseBallWithSearchParams);
+            }
+        }
 
-    // LoggingTools::DebugShowImage(image_name_ + "  cv::GaussianBlur(...)
-    // hsvImage", hsvImage);
-    // LoggingTools::DebugShowImage(image_name_ + "  color_mask_image_",
-    // color_mask_image_);
+        // LoggingTools::DebugShowImage(image_name_ + "  cv::GaussianBlur(...)
+        // hsvImage", hsvImage);
+        // LoggingTools::DebugShowImage(image_name_ + "  color_mask_image_",
+        // color_mask_image_);
 
-    // Perform a Hough conversion to identify circles or near-circles
+        // Perform a Hough conversion to identify circles or near-circles
 
-    // Convert the blurred version of the original image to required gray-scale
-    // for Hough Transform circle detection
-    cv::Mat grayImage;
-    cv::cvtColor(blurImg, grayImage, cv::COLOR_BGR2GRAY);
+        // Convert the blurred version of the original image to required gray-scale
+        // for Hough Transform circle detection
+        cv::Mat grayImage;
+        cv::cvtColor(blurImg, grayImage, cv::COLOR_BGR2GRAY);
 
-    // LoggingTools::DebugShowImage(image_name_ + "  gray image (as well as the
-    // result if no colorMasking)", grayImage);
+        // LoggingTools::DebugShowImage(image_name_ + "  gray image (as well as the
+        // result if no colorMasking)", grayImage);
 
-    cv::Mat search_image = cv::Mat::zeros(grayImage.size(), grayImage.type());
+        search_image = cv::Mat::zeros(grayImage.size(), grayImage.type());
 
-    // Bitwise-AND the colorMask and original image
-    // NOTE - THIS COLOR MASKING MAY ACTUALLY BE HURTING US!!!
-    if (IS_COLOR_MASKING)
-    {
-        cv::bitwise_and(grayImage, color_mask_image_, search_image);
-        LoggingTools::DebugShowImage(image_name_ + "  colorMasked image (search_image)",
-                                     search_image);
-    }
-    else
-    {
-        search_image = grayImage;
+        // Bitwise-AND the colorMask and original image
+        // NOTE - THIS COLOR MASKING MAY ACTUALLY BE HURTING US!!!
+        if (IS_COLOR_MASKING)
+        {
+            cv::bitwise_and(grayImage, color_mask_image_, search_image);
+            LoggingTools::DebugShowImage(image_name_ + "  colorMasked image (search_image)",
+                                         search_image);
+        }
+        else
+        {
+            search_image = grayImage;
+        }
     }
 
     // Apply any area mask
@@ -784,6 +972,12 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
     LoggingTools::DebugShowImage(image_name_ + "  Final color AND area-masked image (search_image)",
                                  search_image);
 
+    if (SearchCancelled())
+    {
+        GS_LOG_TRACE_MSG(trace, "GetBall cancelled after preprocessing.");
+        return false;
+    }
+
     switch (search_mode)
     {
         case kFindPlacedBall: {
@@ -899,7 +1093,11 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
             LoggingTools::DebugShowImage(image_name_ + "  Putting Image - Ready for Edge Detection",
                                          search_image);
 
-            EDPF testEDPF = EDPF(search_image);
+            // The edge detector's image-sized work buffers are kept for the
+            // life of the thread, so they are only allocated once
+            thread_local EDWorkspace edpf_workspace;
+
+            EDPF testEDPF = EDPF(search_image, &edpf_workspace);
             Mat edgePFImage = testEDPF.getEdgeImage();
             edgePFImage = edgePFImage * -1 + 255;
             search_image = edgePFImage;
@@ -1032,7 +1230,7 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
         }
         case kStrobed:
         {
-            bool use_alt = kStrobedBallsUseAltHoughAlgorithm;
+            bool use_alt = UseAltHoughAlgorithm();
 
             starting_param2 =
                 use_alt ? kStrobedBallsAltStartingParam2 : kStrobedBallsStartingParam2;
@@ -1182,7 +1380,7 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
 
     if (search_mode != kFindPlacedBall)
     {
-        if (kStrobedBallsUseAltHoughAlgorithm)
+        if (UseAltHoughAlgorithm())
         {
             GS_LOG_TRACE_MSG(trace, "Using HOUGH_GRADIENT_ALT.");
             hough_mode = cv::HOUGH_GRADIENT_ALT;
@@ -1336,10 +1534,22 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
         }
     }
 
+    // With the single-pass accumulator, the transform is only run once, at
+    // the loosest param2 that the loop below can reach.  Each loop iteration
+    // then just selects the candidates that pass the current param2.
+    std::vector<HoughCircleCandidate> hough_candidates;
+    bool have_hough_candidates = false;
+
     // Adaptive algorithm to dynamically adjust the (very touchy) Hough circle
     // parameters depending on how things are going
     while (!done)
     {
+        if (SearchCancelled())
+        {
+            GS_LOG_TRACE_MSG(trace, "GetBall cancelled during the Hough search.");
+            return false;
+        }
+
         minimum_search_radius = CvUtils::RoundAndMakeEven(minimum_search_radius);
         maximum_search_radius = CvUtils::RoundAndMakeEven(maximum_search_radius);
 
@@ -1356,18 +1566,71 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
         // pictures ?
         // TBD - Need to set minDist to rows / 8, roughly ?
         std::vector<cv::Vec3f> test_circles;
-        cv::HoughCircles(final_search_image,
-                         test_circles,
-                         hough_mode,
-                         currentDp,
-                         /* minDist = */ minimum_distance, // Does this really
-                                                           // matter if we are
-                                                           // only looking for
-                                                           // one circle ?
-                         /* param1 = */ currentParam1,
-                         /* param2 = */ currentParam2,
-                         /* minRadius = */ (int)minimum_search_radius,
-                         /* maxRadius = */ (int)maximum_search_radius);
+
+        if (kUseSinglePassHoughAccumulator)
+        {
+            if (!have_hough_candidates)
+            {
+                // param2 never goes more than one increment below the lower of
+                // its starting and minimum values
+                double loosest_param2 = std::min(starting_param2, min_param2) - param2_increment;
+                int min_center_votes;
+
+                if (hough_mode == cv::HOUGH_GRADIENT_ALT)
+                {
+                    // param2 is a coverage here.  Keep any center with at least
+                    // about half of the votes that the smallest, loosest circle
+                    // would have.
+                    min_center_votes = (int)(std::max(loosest_param2, 0.0) * CV_PI *
+                                             minimum_search_radius / currentDp);
+                }
+                else
+                {
+                    min_center_votes = std::max(0, (int)std::floor(loosest_param2));
+                }
+
+                boost::timer::cpu_timer hough_timer;
+
+                HoughCircleAccumulator::Detect(final_search_image,
+                                               hough_mode,
+                                               currentDp,
+                                               currentParam1,
+                                               (int)minimum_search_radius,
+                                               (int)maximum_search_radius,
+                                               min_center_votes,
+                                               hough_candidates);
+                have_hough_candidates = true;
+
+                hough_timer.stop();
+                GS_LOG_TRACE_MSG(trace,
+                                 "HoughCircleAccumulator found " +
+                                 std::to_string(hough_candidates.size()) +
+                                 " candidate circles in " +
+                                 std::to_string(hough_timer.elapsed().wall / 1.0e9) + "s.");
+            }
+
+            HoughCircleAccumulator::Select(hough_candidates,
+                                           hough_mode,
+                                           currentParam2,
+                                           minimum_distance,
+                                           test_circles);
+        }
+        else
+        {
+            cv::HoughCircles(final_search_image,
+                             test_circles,
+                             hough_mode,
+                             currentDp,
+                             /* minDist = */ minimum_distance, // Does this
+                                                               // really matter
+                                                               // if we are only
+                                                               // looking for
+                                                               // one circle ?
+                             /* param1 = */ currentParam1,
+                             /* param2 = */ currentParam2,
+                             /* minRadius = */ (int)minimum_search_radius,
+                             /* maxRadius = */ (int)maximum_search_radius);
+        }
 
         // Save the prior number of circles if we need it later
         if (!circles.empty())
@@ -1555,6 +1818,12 @@ bool BallImageProc::GetBall(const cv::Mat &rgbImg,
         GS_LOG_TRACE_MSG(trace, "Found " + std::to_string(numCircles) + " circles.");
     }
 
+    if (SearchCancelled())
+    {
+        GS_LOG_TRACE_MSG(trace, "GetBall cancelled before evaluating the circles.");
+        return false;
+    }
+
     cv::Mat candidates_image_ = rgbImg.clone();
 
     // Create a list of the circles with their corresponding criteria for quick
@@ -1933,8 +2202,6 @@ bool BallImageProc::DetermineBestCircle(const cv::Mat &input_gray_image,
     //cv::equalizeHist(finalChoiceImg, finalChoiceImg);
 #endif
 
-    cv::Mat gray_image = input_gray_image.clone();
-
     // We are pretty sure we got the correct ball, or at least something really
     // close.
     // Now, try to find the best circle within the area around the candidate
@@ -1947,7 +2214,7 @@ bool BallImageProc::DetermineBestCircle(const cv::Mat &input_gray_image,
 
     const cv::Vec3f &reference_ball_circle = reference_ball.ball_circle_;
 
-    cv::Vec2i resolution = CvUtils::CvSize(gray_image);
+    cv::Vec2i resolution = CvUtils::CvSize(input_gray_image);
     cv::Vec2i xy = CvUtils::CircleXY(reference_ball_circle);
     int circleX = xy[0];
     int circleY = xy[1];
@@ -1959,6 +2226,33 @@ bool BallImageProc::DetermineBestCircle(const cv::Mat &input_gray_image,
                      ".  (X,Y) center = (" + std::to_string(circleX) + "," +
                      std::to_string(circleY) + ")");
 
+    if (kUseLeastSquaresBestCircleRefinement)
+    {
+        // Much cheaper than another Hough transform, and sub-pixel.  The
+        // result has to stay within the same radius range that the Hough
+        // search below would have used.
+        cv::Vec3f refined_circle;
+
+        if (CircleRefiner::Refine(input_gray_image, reference_ball_circle, refined_circle) &&
+            refined_circle[2] >= ballRadius * kBestCircleIdentificationMinRadiusRatio &&
+            refined_circle[2] <= ballRadius * kBestCircleIdentificationMaxRadiusRatio)
+        {
+            GS_LOG_TRACE_MSG(trace,
+                             "DetermineBestCircle least-squares refinement found radius = " +
+                             std::to_string(refined_circle[2]) + ".  (X,Y) center = (" +
+                             std::to_string(refined_circle[0]) + "," +
+                             std::to_string(refined_circle[1]) + ")");
+            final_circle = refined_circle;
+            return true;
+        }
+
+        GS_LOG_TRACE_MSG(trace,
+                         "DetermineBestCircle least-squares refinement failed.  Using Hough.");
+    }
+
+    // Only the Hough path below needs its own copy of the image
+    cv::Mat gray_image = input_gray_image.clone();
+
     // Hough is expensive - use it only in the region of interest
     const double kHoughBestCircleSubImageSizeMultiplier = 1.5;
     int expandedRadiusForHough = (int)(kHoughBestCircleSubImageSizeMultiplier * (double)ballRadius);
@@ -2364,6 +2658,7 @@ cv::RotatedRect BallImageProc::FindBestEllipseFornaciari(cv::Mat &img,
                            fMinReliability,
                            iNs
                            );
+    detector.SetParallelTriplets(kUseParallelEllipseTriplets);
 
     // Detect
     vector<Ellipse> ellipses;
@@ -2907,6 +3202,178 @@ cv::Mat BallImageProc::GetColorMaskImage(const cv::Mat &hsvImage,
     return BallImageProc::GetColorMaskImage(hsvImage, lowerHsv, upperHsv, widening_amount);
 }
 
+cv::Mat BallImageProc::GetColorMaskImageFromBgr(const cv::Mat &bgrImage, const GolfBall &ball)
+{
+    cv::Mat mask;
+    GetColorMaskLut(ball).Apply(bgrImage, mask);
+
+    return mask;
+}
+
+const ColorMaskLut &BallImageProc::GetColorMaskLut(const GolfBall &ball)
+{
+    cv::Scalar lowerHsv = ball.GetBallLowerHSV(ball.ball_color_);
+    cv::Scalar upperHsv = ball.GetBallUpperHSV(ball.ball_color_);
+
+    if (!color_mask_lut_.IsBuiltFor(lowerHsv, upperHsv))
+    {
+        GS_LOG_TRACE_MSG(trace, "Building color mask lookup table.");
+
+        color_mask_lut_.Build(lowerHsv,
+                              upperHsv,
+                              [&](const cv::Mat &hsvImage)
+            {
+                return GetColorMaskImage(hsvImage, lowerHsv, upperHsv);
+            });
+    }
+
+    return color_mask_lut_;
+}
+
+bool BallImageProc::UseAltHoughAlgorithm() const
+{
+    switch (hough_strategy_)
+    {
+        case kGradientHough:
+            return false;
+
+        case kGradientAltHough:
+            return true;
+
+        case kConfiguredHough:
+        default:
+            return kStrobedBallsUseAltHoughAlgorithm;
+    }
+}
+
+bool BallImageProc::SearchCancelled() const
+{
+    return search_cancelled_ != nullptr && search_cancelled_->load(std::memory_order_relaxed);
+}
+
+int BallImageProc::RunConcurrentStrategies(size_t number_of_strategies,
+                                           const ConcurrentStrategy &run_strategy)
+{
+    std::vector<std::atomic<bool> > cancelled(number_of_strategies);
+
+    // Declared after cancelled so that, if a strategy throws, the futures
+    // (which wait for their strategies) are destroyed first
+    std::vector<std::future<bool> > futures;
+    futures.reserve(number_of_strategies);
+
+    for (size_t i = 0; i < number_of_strategies; i++)
+    {
+        futures.push_back(std::async(std::launch::async, [&, i]()
+            {
+                bool passed = run_strategy(i, cancelled[i]);
+
+                if (passed)
+                {
+                    for (size_t j = i + 1; j < number_of_strategies; j++)
+                    {
+                        cancelled[j].store(true, std::memory_order_relaxed);
+                    }
+                }
+
+                return passed;
+            }));
+    }
+
+    int winner = -1;
+
+    // Wait for every strategy, even once the winner is known, as they all
+    // use state that belongs to the caller
+    for (size_t i = 0; i < number_of_strategies; i++)
+    {
+        if (futures[i].get() && winner < 0)
+        {
+            winner = (int)i;
+        }
+    }
+
+    return winner;
+}
+
+bool BallImageProc::GetBallWithConcurrentHoughStrategies(const cv::Mat &img,
+                                                         const GolfBall &baseBallWithSearchParams,
+                                                         std::vector<GolfBall> &return_balls,
+                                                         cv::Rect &expectedBallArea,
+                                                         BallSearchMode search_mode,
+                                                         bool chooseLargestFinalBall,
+                                                         bool report_find_failures,
+                                                         int min_balls)
+{
+    // The configured strategy comes first, which makes it the winner of any
+    // tie
+    const std::vector<HoughStrategy> strategies =
+        kStrobedBallsUseAltHoughAlgorithm ?
+        std::vector<HoughStrategy>{ kGradientAltHough, kGradientHough } :
+        std::vector<HoughStrategy>{ kGradientHough, kGradientAltHough };
+    const size_t number_of_strategies = strategies.size();
+
+    std::vector<std::unique_ptr<BallImageProc> > processors;
+    std::vector<std::vector<GolfBall> > strategy_balls(number_of_strategies);
+
+    // GetBall may correct the search area, so each strategy gets its own
+    std::vector<cv::Rect> strategy_areas(number_of_strategies, expectedBallArea);
+
+    for (size_t i = 0; i < number_of_strategies; i++)
+    {
+        auto processor = std::make_unique<BallImageProc>(*this);
+        processor->hough_strategy_ = strategies[i];
+
+        // Copying a cv::Mat does not copy its pixels, so each copy needs its
+        // own images to write to
+        processor->img_ = img_.clone();
+        processor->color_mask_image_ = color_mask_image_.clone();
+        processor->area_mask_image_ = area_mask_image_.clone();
+        processor->candidates_image_ = cv::Mat();
+        processor->final_result_image_ = cv::Mat();
+        processor->search_image_buffer_ = cv::Mat();
+        processors.push_back(std::move(processor));
+    }
+
+    boost::timer::cpu_timer timer;
+
+    int winner = RunConcurrentStrategies(number_of_strategies,
+                                         [&](size_t i, const std::atomic<bool> &cancelled)
+        {
+            processors[i]->search_cancelled_ = &cancelled;
+
+            bool result = processors[i]->GetBall(img,
+                                                 baseBallWithSearchParams,
+                                                 strategy_balls[i],
+                                                 strategy_areas[i],
+                                                 search_mode,
+                                                 chooseLargestFinalBall,
+                                                 report_find_failures);
+
+            return result && (int)strategy_balls[i].size() >= min_balls;
+        });
+
+    timer.stop();
+
+    if (winner < 0)
+    {
+        GS_LOG_TRACE_MSG(trace, "No Hough strategy found at least " + std::to_string(min_balls) +
+                         " balls.");
+        return_balls.clear();
+        return false;
+    }
+
+    GS_LOG_TRACE_MSG(trace,
+                     "Hough strategy " + std::to_string(strategies[winner]) + " won with " +
+                     std::to_string(strategy_balls[winner].size()) + " balls after " +
+                     std::to_string(timer.elapsed().wall / 1.0e9) + "s.");
+
+    return_balls = std::move(strategy_balls[winner]);
+    expectedBallArea = strategy_areas[winner];
+    final_result_image_ = processors[winner]->final_result_image_;
+    candidates_image_ = processors[winner]->candidates_image_;
+
+    return true;
+}
+
 bool BallImageProc::BallIsPresent(const cv::Mat &img)
 {
     GS_LOG_TRACE_MSG(trace, "BallIsPresent: image=" + LoggingTools::SummarizeImage(img));
@@ -3544,7 +4011,9 @@ cv::Mat BallImageProc::MaskAreaOutsideBall(cv::Mat &ball_image,
 cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
                                          const GolfBall &ball1,
                                          const cv::Mat &full_gray_image2,
-                                         const GolfBall &ball2)
+                                         const GolfBall &ball2,
+                                         int pair_index,
+                                         std::optional<cv::Vec3d> *prior_rotation)
 {
     // NOTE - This function (and downstream functions) assumes that ball1 is the
     // earlier-in-time ball
@@ -3570,6 +4039,13 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     GolfBall local_ball1 = ball1;
     GolfBall local_ball2 = ball2;
 
+    // Keeps the files of pairs that are analyzed at the same time apart
+    const std::string artifact_suffix = (pair_index >= 0) ?
+                                        "_pair" + std::to_string(pair_index) : "";
+
+    spin_pixel_comparisons = 0;
+    spin_pixel_comparisons_skipped = 0;
+
     // NOTE - The ball that is passed into the IsolateBall image will be
     // adjusted
     // to have the new x, y, and radius values relative to the smaller, isolated
@@ -3587,12 +4063,12 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
                                ball_image1,
                                std::vector < cv::Point >{},
                                true,
-                               "log_view_ISOLATED_full_gray_image1.png");
+                               "log_view_ISOLATED_full_gray_image1" + artifact_suffix + ".png");
         LoggingTools::LogImage("",
                                ball_image2,
                                std::vector < cv::Point >{},
                                true,
-                               "log_view_ISOLATED_full_gray_image2.png");
+                               "log_view_ISOLATED_full_gray_image2" + artifact_suffix + ".png");
     }
 
     // Just to test.  Ignore the 0 bin
@@ -3789,10 +4265,15 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     // Save the normalized ball images to the webserver shared directory so that
     // the user
     // can compare them to the final rotated image.
-    GsUISystem::SaveWebserverImage(GsUISystem::kWebServerResultSpinBall1Image,
-                                   normalizedOriginalBallImg1);
-    GsUISystem::SaveWebserverImage(GsUISystem::kWebServerResultSpinBall2Image,
-                                   normalizedOriginalBallImg2);
+    // Only one pair of a multi-pair shot writes them, so that they match the
+    // rotated-by-best-angles image below.
+    if (pair_index <= 0)
+    {
+        GsUISystem::SaveWebserverImage(GsUISystem::kWebServerResultSpinBall1Image,
+                                       normalizedOriginalBallImg1);
+        GsUISystem::SaveWebserverImage(GsUISystem::kWebServerResultSpinBall2Image,
+                                       normalizedOriginalBallImg2);
+    }
 #endif
 
     // Now compute all the possible rotations of the first image so we can
@@ -3810,25 +4291,48 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     initialSearchSpace.anglez_rotation_degrees_start = kCoarseZRotationDegreesStart;
     initialSearchSpace.anglez_rotation_degrees_end = kCoarseZRotationDegreesEnd;
 
-    cv::Mat outputCandidateElementsMat;
     std::vector< RotationCandidate> candidates;
-    cv::Vec3i output_candidate_elements_mat_size;
 
-    ComputeCandidateAngleImages(ball_image1DimpleEdges,
-                                initialSearchSpace,
-                                outputCandidateElementsMat,
-                                output_candidate_elements_mat_size,
-                                candidates,
-                                local_ball1);
+    // Narrow the coarse search to where this club's spin usually is, if we can
+    GolfSimClubs::GsClubType club_type = GolfSimClubs::GetCurrentClubType();
+    RotationSearchSpace fullSearchSpace = initialSearchSpace;
+    bool using_spin_prior = kUseSpinSearchPrior &&
+                            GetSpinPriorSearchSpace(fullSearchSpace, club_type, initialSearchSpace);
 
     // Compare the second (presumably rotated) ball image to different candidate
     // rotations of the first ball image to determine the angular change
     std::vector<std::string> comparison_csv_data;
-    int best_candidate_index = CompareCandidateAngleImages(&ball_image2DimpleEdges,
-                                                           &outputCandidateElementsMat,
-                                                           &output_candidate_elements_mat_size,
-                                                           &candidates,
-                                                           comparison_csv_data);
+
+    // The angular step of the coarse result, which determines how wide the
+    // fine search window needs to be
+    cv::Vec3i coarse_increments;
+
+    int best_candidate_index = FindBestCoarseRotationCandidate(ball_image1DimpleEdges,
+                                                               ball_image2DimpleEdges,
+                                                               initialSearchSpace,
+                                                               local_ball1,
+                                                               candidates,
+                                                               comparison_csv_data,
+                                                               coarse_increments);
+
+    if (using_spin_prior &&
+        (best_candidate_index < 0 ||
+         !IsSpinPriorResultAcceptable(candidates[best_candidate_index],
+                                      initialSearchSpace,
+                                      fullSearchSpace)))
+    {
+        GS_LOG_MSG(debug,
+                   "Spin search prior did not give a good result.  Searching the full range.");
+
+        initialSearchSpace = fullSearchSpace;
+        best_candidate_index = FindBestCoarseRotationCandidate(ball_image1DimpleEdges,
+                                                               ball_image2DimpleEdges,
+                                                               initialSearchSpace,
+                                                               local_ball1,
+                                                               candidates,
+                                                               comparison_csv_data,
+                                                               coarse_increments);
+    }
 
     cv::Vec3f rotationResult;
 
@@ -3846,7 +4350,7 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     if (write_spin_analysis_CSV_files)
     {
         // This data export can be used for, say, Excel analysis - CSV format
-        std::string csv_fname_coarse = "spin_analysis_coarse.csv";
+        std::string csv_fname_coarse = "spin_analysis_coarse" + artifact_suffix + ".csv";
         ofstream csv_file_coarse(csv_fname_coarse);
         GS_LOG_TRACE_MSG(trace, "Writing CSV spin data to: " + csv_fname_coarse);
         for (auto &element : comparison_csv_data)
@@ -3860,7 +4364,8 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
 
     // See which angle looked best and then iterate more closely near those
     // angles
-    RotationCandidate c = candidates[best_candidate_index];
+    const RotationCandidate &c = candidates[best_candidate_index];
+    double coarse_best_score = c.score;
 
     std::string s = "Best Coarse Initial Rotation Candidate was #" +
                     std::to_string(best_candidate_index) + " - Rot: (" +
@@ -3872,52 +4377,62 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     // Now iterate more closely in the area that looks best
     RotationSearchSpace finalSearchSpace;
 
-    int anglex_window_width =
-        (int)std::round(ceil(initialSearchSpace.anglex_rotation_degrees_increment / 2.));
-    int angley_window_width =
-        (int)std::round(ceil(initialSearchSpace.angley_rotation_degrees_increment / 2.));
-    int anglez_window_width =
-        (int)std::round(ceil(initialSearchSpace.anglez_rotation_degrees_increment / 2.));
+    int anglex_window_width = (int)std::round(ceil(coarse_increments[0] / 2.));
+    int angley_window_width = (int)std::round(ceil(coarse_increments[1] / 2.));
+    int anglez_window_width = (int)std::round(ceil(coarse_increments[2] / 2.));
 
     finalSearchSpace.anglex_rotation_degrees_increment = 1;
     finalSearchSpace.anglex_rotation_degrees_start = c.x_rotation_degrees - anglex_window_width;
     finalSearchSpace.anglex_rotation_degrees_end = c.x_rotation_degrees + anglex_window_width;
     // Probably not worth it to be too fine-grained on the Y axis.
     finalSearchSpace.angley_rotation_degrees_increment =
-        (int) std::round(kCoarseYRotationDegreesIncrement / 2.);
+        std::max(1, (int) std::round(coarse_increments[1] / 2.));
     finalSearchSpace.angley_rotation_degrees_start = c.y_rotation_degrees - angley_window_width;
     finalSearchSpace.angley_rotation_degrees_end = c.y_rotation_degrees + angley_window_width;
     finalSearchSpace.anglez_rotation_degrees_increment = 1;
     finalSearchSpace.anglez_rotation_degrees_start = c.z_rotation_degrees - anglez_window_width;
     finalSearchSpace.anglez_rotation_degrees_end = c.z_rotation_degrees + anglez_window_width;
 
-    cv::Mat finalOutputCandidateElementsMat;
-    cv::Vec3i finalOutputCandidateElementsMatSize;
     std::vector< RotationCandidate> finalCandidates;
+    cv::Vec3d optimized_rotation;
 
-    // After this, the finalOutputCandidateElementsMat will have X,Y,Z elements
-    // with an index into the finalCandidates vector.
-    // Each candidate in finalCandidates will have an image, associated X,Y,Z
-    // information and a place to put a score
-    ComputeCandidateAngleImages(ball_image1DimpleEdges,
-                                finalSearchSpace,
-                                finalOutputCandidateElementsMat,
-                                finalOutputCandidateElementsMatSize,
-                                finalCandidates,
-                                local_ball1);
-
-    // TBD - change CompareCandidateAngleImages to work directly with the "3D"
-    // images
-    best_candidate_index = CompareCandidateAngleImages(&ball_image2DimpleEdges,
-                                                       &finalOutputCandidateElementsMat,
-                                                       &finalOutputCandidateElementsMatSize,
-                                                       &finalCandidates,
-                                                       comparison_csv_data);
+    if (kUseSpinOptimizerForFineSearch)
+    {
+        // The optimizer's low-count penalty is relative to the best coverage
+        // seen during the coarse search
+        double reference_pixels_examined = 0.0;
+
+        for (const RotationCandidate &coarse_candidate : candidates)
+        {
+            reference_pixels_examined = std::max(reference_pixels_examined,
+                                                 (double)coarse_candidate.pixels_examined);
+        }
+
+        OptimizeRotation(ball_image1DimpleEdges,
+                         ball_image2DimpleEdges,
+                         local_ball1,
+                         cv::Vec3d(c.x_rotation_degrees, c.y_rotation_degrees,
+                                   c.z_rotation_degrees),
+                         cv::Vec3d(anglex_window_width, angley_window_width,
+                                   anglez_window_width),
+                         reference_pixels_examined,
+                         optimized_rotation,
+                         comparison_csv_data);
+    }
+    else
+    {
+        best_candidate_index = FindBestRotationCandidate(ball_image1DimpleEdges,
+                                                         ball_image2DimpleEdges,
+                                                         finalSearchSpace,
+                                                         local_ball1,
+                                                         finalCandidates,
+                                                         comparison_csv_data);
+    }
 
     // Save all the candidate scores to a CSV file if requested
     if (write_spin_analysis_CSV_files)
     {
-        std::string csv_fname_fine = "spin_analysis_fine.csv";
+        std::string csv_fname_fine = "spin_analysis_fine" + artifact_suffix + ".csv";
         ofstream csv_file_fine(csv_fname_fine);
         GS_LOG_TRACE_MSG(trace, "Writing CSV spin data to: " + csv_fname_fine);
         for (auto &element : comparison_csv_data)
@@ -3930,16 +4445,31 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     }
 
     // Analyze the fine-grained results
-    int best_rot_x = 0;
-    int best_rot_y = 0;
-    int best_rot_z = 0;
+    double best_rot_x = 0;
+    double best_rot_y = 0;
+    double best_rot_z = 0;
+    bool found_final_rotation = false;
+    cv::Mat bestImg3D;
+
+    if (kUseSpinOptimizerForFineSearch)
+    {
+        best_rot_x = optimized_rotation[0];
+        best_rot_y = optimized_rotation[1];
+        best_rot_z = optimized_rotation[2];
+        found_final_rotation = true;
 
-    if (best_candidate_index >= 0)
+        std::string s = "Best Raw Fine (and final) Rotation from the optimizer was Rot: (" +
+                        std::to_string(best_rot_x) + ", " + std::to_string(best_rot_y) + ", " +
+                        std::to_string(best_rot_z) + ") ";
+        GS_LOG_MSG(debug, s);
+    }
+    else if (best_candidate_index >= 0)
     {
-        RotationCandidate finalC = finalCandidates[best_candidate_index];
+        const RotationCandidate &finalC = finalCandidates[best_candidate_index];
         best_rot_x = finalC.x_rotation_degrees;
         best_rot_y = finalC.y_rotation_degrees;
         best_rot_z = finalC.z_rotation_degrees;
+        found_final_rotation = true;
 
         // TBD - Experiment - are Y and X reversed?  Try it here...
         // best_rot_x = finalC.y_rotation_degrees;
@@ -3947,12 +4477,51 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
 
         std::string s = "Best Raw Fine (and final) Rotation Candidate was #" +
                         std::to_string(best_candidate_index) + " - Rot: (" +
-                        std::to_string(best_rot_x) + ", " + std::to_string(best_rot_y) + ", " +
-                        std::to_string(best_rot_z) + ") ";
+                        std::to_string(finalC.x_rotation_degrees) + ", " +
+                        std::to_string(finalC.y_rotation_degrees) + ", " +
+                        std::to_string(finalC.z_rotation_degrees) + ") ";
         GS_LOG_MSG(debug, s);
 
+        bestImg3D = finalC.img;
+    }
+
+    // Only results that were clearly found help future shots.  The pairs of
+    // a multi-pair shot leave it to the caller to record one result for the
+    // shot.
+    if (prior_rotation != nullptr)
+    {
+        prior_rotation->reset();
+    }
+
+    if (kUseSpinSearchPrior && found_final_rotation && coarse_best_score >= kSpinPriorMinScore)
+    {
+        if (prior_rotation != nullptr)
+        {
+            *prior_rotation = cv::Vec3d(best_rot_x, best_rot_y, best_rot_z);
+        }
+
+        if (pair_index < 0)
+        {
+            RecordSpinPriorResult(club_type, cv::Vec3d(best_rot_x, best_rot_y, best_rot_z));
+        }
+    }
+
+    // The debug images can only be rotated by whole degrees
+    cv::Vec3i best_rot_rounded((int)std::round(best_rot_x),
+                               (int)std::round(best_rot_y),
+                               (int)std::round(best_rot_z));
+
+    if (found_final_rotation)
+    {
         /*** FOR DEBUG ***/
-        cv::Mat bestImg3D = finalCandidates[best_candidate_index].img;
+        // Neither the streaming search nor the optimizer keep the candidate
+        // images around, so just re-create the one we want to look at
+        if (bestImg3D.empty())
+        {
+            bestImg3D = Project2dImageTo3dBall(ball_image1DimpleEdges,
+                                               local_ball1,
+                                               best_rot_rounded);
+        }
         cv::Mat bestImg2D = cv::Mat::zeros(ball_image1DimpleEdges.rows,
                                            ball_image1DimpleEdges.cols,
                                            ball_image1DimpleEdges.type());
@@ -3993,22 +4562,51 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     double spin_offset_angle_radians_Z = CvUtils::DegreesToRadians(spin_offset_angle[2]);
 
     // Perform the normalization to the real-world axes
-    int normalized_rot_x = (int)round((double)best_rot_x * cos(spin_offset_angle_radians_Y) +
-                                      (double)best_rot_z * sin(spin_offset_angle_radians_Y));
-    int normalized_rot_y = (int)round((double)best_rot_y * cos(spin_offset_angle_radians_X) -
-                                      (double)best_rot_z * sin(spin_offset_angle_radians_X));
+    double normalized_rot_x = 0.0;
+    double normalized_rot_y = 0.0;
+    double normalized_rot_z = 0.0;
 
-    int normalized_rot_z = (int)round((double)best_rot_z * cos(spin_offset_angle_radians_X) *
-                                      cos(spin_offset_angle_radians_Y));
-    normalized_rot_z -= (int)round((double)best_rot_y * sin(spin_offset_angle_radians_X));
-    normalized_rot_z -= (int)round((double)best_rot_x * sin(spin_offset_angle_radians_Y));
+    if (kUseSpinOptimizerForFineSearch)
+    {
+        // Not rounded to whole degrees, so that the optimizer's fractional
+        // result is kept
+        normalized_rot_x = best_rot_x * cos(spin_offset_angle_radians_Y) +
+                           best_rot_z * sin(spin_offset_angle_radians_Y);
+        normalized_rot_y = best_rot_y * cos(spin_offset_angle_radians_X) -
+                           best_rot_z * sin(spin_offset_angle_radians_X);
+
+        normalized_rot_z = best_rot_z * cos(spin_offset_angle_radians_X) *
+                           cos(spin_offset_angle_radians_Y);
+        normalized_rot_z -= best_rot_y * sin(spin_offset_angle_radians_X);
+        normalized_rot_z -= best_rot_x * sin(spin_offset_angle_radians_Y);
+    }
+    else
+    {
+        // The grid search works in whole degrees, and its result is rounded
+        // term by term, as it always has been
+        normalized_rot_x = round(best_rot_x * cos(spin_offset_angle_radians_Y) +
+                                 best_rot_z * sin(spin_offset_angle_radians_Y));
+        normalized_rot_y = round(best_rot_y * cos(spin_offset_angle_radians_X) -
+                                 best_rot_z * sin(spin_offset_angle_radians_X));
+
+        normalized_rot_z = round(best_rot_z * cos(spin_offset_angle_radians_X) *
+                                 cos(spin_offset_angle_radians_Y));
+        normalized_rot_z -= round(best_rot_y * sin(spin_offset_angle_radians_X));
+        normalized_rot_z -= round(best_rot_x * sin(spin_offset_angle_radians_Y));
+    }
 
     rotationResult = cv::Vec3d(normalized_rot_x, normalized_rot_y, normalized_rot_z);
 
+    auto formatAngle = [](double degrees)
+                       {
+                           return kUseSpinOptimizerForFineSearch ?
+                                  std::to_string(degrees) : std::to_string((int)degrees);
+                       };
+
     GS_LOG_TRACE_MSG(trace,
-                     "Normalized spin angles (X,Y,Z) = (" + std::to_string(normalized_rot_x) +
-                     ", " + std::to_string(normalized_rot_y) + ", " +
-                     std::to_string(normalized_rot_z) + ").");
+                     "Normalized spin angles (X,Y,Z) = (" + formatAngle(normalized_rot_x) +
+                     ", " + formatAngle(normalized_rot_y) + ", " +
+                     formatAngle(normalized_rot_z) + ").");
 
     // TBD _ DEBUG
     // See how the original image would look if rotated as the GetBallRotation
@@ -4019,9 +4617,7 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
 
     cv::Mat resultBball2DImage;
 
-    GetRotatedImage(ball_image1DimpleEdges, local_ball1, cv::Vec3i(best_rot_x,
-                                                                   best_rot_y,
-                                                                   best_rot_z), resultBball2DImage);
+    GetRotatedImage(ball_image1DimpleEdges, local_ball1, best_rot_rounded, resultBball2DImage);
 
     if (GolfSimOptions::GetCommandLineOptions().artifact_save_level_ !=
         ArtifactSaveLevel::kNoArtifacts && kLogIntermediateSpinImagesToFile)
@@ -4030,15 +4626,12 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
                                resultBball2DImage,
                                std::vector < cv::Point >{},
                                true,
-                               "Filtered Ball1_Rotated_By_Best_Angles.png");
+                               "Filtered Ball1_Rotated_By_Best_Angles" + artifact_suffix + ".png");
     }
 
     // We want to show apples to apples, so show the normalized images
     cv::Mat test_ball1_image = normalizedOriginalBallImg1.clone();
-    GetRotatedImage(normalizedOriginalBallImg1, local_ball1, cv::Vec3i(best_rot_x,
-                                                                       best_rot_y,
-                                                                       best_rot_z),
-                    test_ball1_image);
+    GetRotatedImage(normalizedOriginalBallImg1, local_ball1, best_rot_rounded, test_ball1_image);
 
     // We'll draw a center-dot on the final image here, but we're not going to
     // re-use that image, so it's ok
@@ -4055,8 +4648,11 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     // Save the final, rotated, normalized ball result image to the webserver
     // shared directory so that the user
     // can compare them to the original normalized images.
-    GsUISystem::SaveWebserverImage(GsUISystem::kWebServerResultBallRotatedByBestAngles,
-                                   test_ball1_image);
+    if (pair_index <= 0)
+    {
+        GsUISystem::SaveWebserverImage(GsUISystem::kWebServerResultBallRotatedByBestAngles,
+                                       test_ball1_image);
+    }
 #endif
 
     // Looks like golf folks consider the X (side) spin to be positive if the
@@ -4064,96 +4660,300 @@ cv::Vec3d BallImageProc::GetBallRotation(const cv::Mat &full_gray_image1,
     // going from right to left.  So we negate it here.
     rotationResult[0] = -rotationResult[0];
 
+    if (kUseBranchAndBoundCandidateScoring)
+    {
+        GS_LOG_MSG(debug,
+                   "GetBallRotation skipped " + std::to_string(spin_pixel_comparisons_skipped) +
+                   " of " + std::to_string(spin_pixel_comparisons) + " pixel comparisons.");
+    }
+
     // Note that we return angles, not angular velocities.  The velocities will
     // be determined later based on the derived ball speed.
     return rotationResult;
 }
 
-// This structure is used as a callback for the OpenCV forEach() call.
-// After first being setup, the operator() will be called in parallel across
-// different processing cores.
-struct ImgComparisonOp
+bool BallImageProc::IsGetBallRotationReentrant()
 {
-    // Must be called prior to using the iteration() operator
-    static void setup(const cv::Mat *target_image,
-                      const cv::Mat *candidate_elements_mat,
-                      std::vector<RotationCandidate> *candidates,
-                      std::vector<std::string> *comparisonData )
+    return kUseStreamingCandidateScoring && kUseSphereProjectionCache;
+}
+
+// Candidates that examined relatively few pixels compared to the best-covered
+// candidate are penalized, because a far rotation with only a few pixels left
+// to compare can have a deceptively high correspondence.
+// pixel_count_scale converts the pixel counts back to full-resolution pixels
+// when the candidates were scored on a downsampled image.
+static const double kSpinLowCountPenaltyPower = 2.0;
+static const double kSpinLowCountPenaltyScalingFactor = 1000.0;
+static const double kSpinLowCountDifferenceWeightingFactor = 500.0;
+
+static double GetPenalizedCandidateScore(double score,
+                                         int pixels_examined,
+                                         double maxPixelsExamined,
+                                         double pixel_count_scale = 1.0)
+{
+    double low_count_penalty =
+        std::pow(pixel_count_scale * (maxPixelsExamined - (double)pixels_examined) /
+                 kSpinLowCountDifferenceWeightingFactor,
+                 kSpinLowCountPenaltyPower) / kSpinLowCountPenaltyScalingFactor;
+
+    return (score * 10.) - low_count_penalty;
+}
+
+// Tracks the best fully-scored candidate across the workers that score
+// candidates in parallel, so that a candidate can be abandoned part way through
+// its comparison once even a perfect match over the rest of its pixels could
+// not make it the best.
+// The low-count penalty depends on the largest number of pixels examined by
+// any candidate, which is not known until every candidate has been scored.
+// That maximum can only grow (up to the number of valid target pixels), and
+// the difference between two candidates' penalties changes monotonically as
+// it does, so a candidate is only abandoned if it loses at both the current
+// and the largest possible maximum.  The winner is therefore always the same
+// as with a full evaluation.
+class RotationCandidateBound
+{
+  public:
+
+    explicit RotationCandidateBound(const BitplaneImage &packed_target_image)
+        : packed_target_image_(packed_target_image),
+        max_possible_pixels_examined_((double)packed_target_image.CountValid())
     {
-        ImgComparisonOp::comparisonData_ = comparisonData;
-        ImgComparisonOp::target_image_ = target_image;
-        ImgComparisonOp::candidate_elements_mat_ = candidate_elements_mat;
-        ImgComparisonOp::candidates_ = candidates;
     }
 
-    void operator ()(ushort &unusedValue, const int *position) const
-    {
-        int x = position[0];
-        int y = position[1];
-        int z = position[2];
-
-        int elementIndex = (*candidate_elements_mat_).at<ushort>(x, y, z);
-        RotationCandidate &c = (*candidates_)[elementIndex];
-
-        // For DEBUG
-        // std::string s = "Idx: " + std::to_string(c.index) +
-        //   " Rot: (" + std::to_string(c.x_rotation_degrees) + ", " +
-        // std::to_string(c.y_rotation_degrees) + ", " +
-        // std::to_string(c.z_rotation_degrees) + ") ";
-        // GS_LOG_TRACE_MSG(trace, "Rotation Candidate: " + s);
-        // LoggingTools::DebugShowImage("Img #" + std::to_string(c.index),
-        // c.img);
-
-        // Compare the second ball image to each of the rotated versions of the
-        // first ball image to see which is closest
-        cv::Vec2i results = BallImageProc::CompareRotationImage(*target_image_, c.img, c.index);
-        double scaledScore = (double)results[0] / (double)results[1];
-
-        // Save the calculated score for later analysis
-        c.pixels_matching = results[0];
-        c.pixels_examined = results[1];
-        c.score = scaledScore;
-
-        // GS_LOG_TRACE_MSG(trace, "I=" + std::to_string(elementIndex) + ", Rot:
-        // (" + std::to_string(c.x_rotation_degrees) + ", " +
-        // std::to_string(c.y_rotation_degrees) + ", " +
-        // std::to_string(c.z_rotation_degrees) + ") " + ".Score : " +
-        // std::to_string(results[0]) + " out of " + std::to_string(results[1])
-        // +
-        //    ". Scaled = " + std::to_string(scaledScore);
-
-        // CSV (Excel) File format - Comma-Seperated-Values for Excel
-        // spreadsheet export
-        // Columns are Idx, Rotx, Roty, Rotz, Score, Out-of, ScaledScore
-        std::string s = std::to_string(c.index) + "\t" + std::to_string(c.x_rotation_degrees) +
-                        "\t" + std::to_string(c.y_rotation_degrees) + "\t" +
-                        std::to_string(c.z_rotation_degrees) + "\t" + std::to_string(results[0]) +
-                        "\t" + std::to_string(results[1]) +
-                        "\t" + std::to_string(scaledScore) + "\n";
+    // Scores candidate i of candidates against the target image.  If the
+    // candidate is abandoned, its pixels_matching and score are only upper
+    // bounds, which are still lower than the best candidate's.
+    void ScoreCandidate(const BitplaneImage &packed_candidate,
+                        RotationCandidateTable &candidates,
+                        size_t i);
 
-        // DEBUG - Save a CSV-compatible string for later analysis
-        (*comparisonData_)[c.index] = s;
-    }
+    std::atomic<long> pixel_comparisons_skipped_{ 0 };
+    std::atomic<long> candidates_abandoned_{ 0 };
 
-    static const cv::Mat *target_image_;
-    static const cv::Mat *candidate_elements_mat_;
-    static std::vector<std::string> *comparisonData_;
-    static std::vector<RotationCandidate> *candidates_;
+  private:
+
+    // Rows compared between checks of the bound
+    static const int kRowBlockSize = 16;
+
+    const BitplaneImage &packed_target_image_;
+    const double max_possible_pixels_examined_;
+
+    std::mutex mutex_;
+    double max_pixels_examined_ = 0.0;
+    bool have_best_ = false;
+    int best_pixels_examined_ = 0;
+    double best_score_ = 0.0;
 };
 
-// Complete storage for ImgComparisonOp struct
-// Create temporary nonce objects because C++ requires references to point to a
-// valid object.
-// the null/nonce references will go out of scope after setup() is called and
-// these references
-// are set to valid objects
-std::vector<std::string> *ImgComparisonOp::comparisonData_ = nullptr;
-const cv::Mat *ImgComparisonOp::target_image_ = nullptr;
-const cv::Mat *ImgComparisonOp::candidate_elements_mat_ = nullptr;
-std::vector<RotationCandidate> *ImgComparisonOp::candidates_ = nullptr;
+void RotationCandidateBound::ScoreCandidate(const BitplaneImage &packed_candidate,
+                                            RotationCandidateTable &candidates,
+                                            size_t i)
+{
+    int pixels_examined = BitplaneImage::CountExamined(packed_target_image_, packed_candidate);
 
+    bool have_best = false;
+    int best_pixels_examined = 0;
+    double best_score = 0.0;
+    double max_pixels_examined = 0.0;
 
-// Returns the index within candidates that has the best comparison.
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        max_pixels_examined_ = std::max(max_pixels_examined_, (double)pixels_examined);
+        max_pixels_examined = max_pixels_examined_;
+        have_best = have_best_;
+        best_pixels_examined = best_pixels_examined_;
+        best_score = best_score_;
+    }
+
+    candidates.pixels_examined[i] = pixels_examined;
+
+    int pixels_matching = 0;
+    int pixels_compared = 0;
+    bool abandoned = false;
+
+    for (int start_row = 0; start_row < packed_target_image_.rows; start_row += kRowBlockSize)
+    {
+        int end_row = std::min(start_row + kRowBlockSize, packed_target_image_.rows);
+
+        cv::Vec2i results = BitplaneImage::Compare(packed_target_image_,
+                                                   packed_candidate,
+                                                   start_row,
+                                                   end_row);
+        pixels_matching += results[0];
+        pixels_compared += results[1];
+
+        if (!have_best || pixels_compared == pixels_examined)
+        {
+            continue;
+        }
+
+        // The best this candidate could still do is to match every one of its
+        // remaining pixels
+        int upper_bound_matching = pixels_matching + (pixels_examined - pixels_compared);
+        double upper_bound_score = (double)upper_bound_matching / (double)pixels_examined;
+
+        candidates.pixels_matching[i] = upper_bound_matching;
+        candidates.score[i] = upper_bound_score;
+
+        if (GetPenalizedCandidateScore(upper_bound_score, pixels_examined,
+                                       max_pixels_examined) <
+            GetPenalizedCandidateScore(best_score, best_pixels_examined,
+                                       max_pixels_examined) &&
+            GetPenalizedCandidateScore(upper_bound_score, pixels_examined,
+                                       max_possible_pixels_examined_) <
+            GetPenalizedCandidateScore(best_score, best_pixels_examined,
+                                       max_possible_pixels_examined_))
+        {
+            abandoned = true;
+            break;
+        }
+    }
+
+    if (abandoned)
+    {
+        pixel_comparisons_skipped_ += pixels_examined - pixels_compared;
+        candidates_abandoned_++;
+        return;
+    }
+
+    double score = (pixels_examined > 0) ? (double)pixels_matching / (double)pixels_examined : 0.0;
+
+    candidates.pixels_matching[i] = pixels_matching;
+    candidates.score[i] = score;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    if (!have_best_ ||
+        GetPenalizedCandidateScore(score, pixels_examined, max_pixels_examined_) >
+        GetPenalizedCandidateScore(best_score_, best_pixels_examined_, max_pixels_examined_))
+    {
+        have_best_ = true;
+        best_pixels_examined_ = pixels_examined;
+        best_score_ = score;
+    }
+}
+
+static void RecordSkippedPixelComparisons(const RotationCandidateTable &candidates,
+                                          const RotationCandidateBound &bound)
+{
+    long pixel_comparisons = std::accumulate(candidates.pixels_examined.begin(),
+                                             candidates.pixels_examined.end(),
+                                             0L);
+
+    spin_pixel_comparisons += pixel_comparisons;
+    spin_pixel_comparisons_skipped += bound.pixel_comparisons_skipped_;
+
+    GS_LOG_TRACE_MSG(trace,
+                     "Abandoned " + std::to_string(bound.candidates_abandoned_) + " of " +
+                     std::to_string(candidates.size()) + " rotation candidates, skipping " +
+                     std::to_string(bound.pixel_comparisons_skipped_) + " of " +
+                     std::to_string(pixel_comparisons) + " pixel comparisons.");
+}
+
+// CSV (Excel) File format - Comma-Seperated-Values for Excel spreadsheet
+// export
+// Columns are Idx, Rotx, Roty, Rotz, Score, Out-of, ScaledScore
+static std::string FormatRotationCandidateCsv(const RotationCandidate &c)
+{
+    return std::to_string(c.index) + "\t" + std::to_string(c.x_rotation_degrees) +
+           "\t" + std::to_string(c.y_rotation_degrees) + "\t" +
+           std::to_string(c.z_rotation_degrees) + "\t" + std::to_string(c.pixels_matching) +
+           "\t" + std::to_string(c.pixels_examined) +
+           "\t" + std::to_string(c.score) + "\n";
+}
+
+static std::string FormatRotationCandidateCsv(const RotationCandidateTable &candidates, size_t i)
+{
+    return std::to_string(i) + "\t" + std::to_string(candidates.x_rotation_degrees[i]) +
+           "\t" + std::to_string(candidates.y_rotation_degrees[i]) + "\t" +
+           std::to_string(candidates.z_rotation_degrees[i]) + "\t" +
+           std::to_string(candidates.pixels_matching[i]) +
+           "\t" + std::to_string(candidates.pixels_examined[i]) +
+           "\t" + std::to_string(candidates.score[i]) + "\n";
+}
+
+// This structure is used as the body of the cv::parallel_for_() call over the
+// materialized candidates.
+// After first being setup, the operator() will be called in parallel across
+// different processing cores, each with its own range of candidates.
+struct ImgComparisonOp
+{
+    // Must be called prior to using the iteration() operator
+    static void setup(const cv::Mat *target_image,
+                      const BitplaneImage *packed_target_image,
+                      const std::vector<RotationCandidate> *candidates,
+                      RotationCandidateTable *scores,
+                      RotationCandidateBound *bound )
+    {
+        ImgComparisonOp::bound_ = bound;
+        ImgComparisonOp::target_image_ = target_image;
+        ImgComparisonOp::packed_target_image_ = packed_target_image;
+        ImgComparisonOp::candidates_ = candidates;
+        ImgComparisonOp::scores_ = scores;
+    }
+
+    void operator ()(const cv::Range &range) const
+    {
+        for (int i = range.start; i < range.end; i++)
+        {
+            const RotationCandidate &c = (*candidates_)[i];
+
+            // For DEBUG
+            // std::string s = "Idx: " + std::to_string(c.index) +
+            //   " Rot: (" + std::to_string(c.x_rotation_degrees) + ", " +
+            // std::to_string(c.y_rotation_degrees) + ", " +
+            // std::to_string(c.z_rotation_degrees) + ") ";
+            // GS_LOG_TRACE_MSG(trace, "Rotation Candidate: " + s);
+            // LoggingTools::DebugShowImage("Img #" + std::to_string(c.index),
+            // c.img);
+
+            // Compare the second ball image to each of the rotated versions of
+            // the first ball image to see which is closest
+            cv::Vec2i results;
+
+            if (packed_target_image_ != nullptr && !c.packed_img.empty())
+            {
+                if (bound_ != nullptr)
+                {
+                    bound_->ScoreCandidate(c.packed_img, *scores_, i);
+                    continue;
+                }
+
+                results = BitplaneImage::Compare(*packed_target_image_, c.packed_img);
+            }
+            else
+            {
+                results = BallImageProc::CompareRotationImage(*target_image_, c.img, c.index);
+            }
+
+            // Save the calculated score for later analysis
+            scores_->pixels_matching[i] = results[0];
+            scores_->pixels_examined[i] = results[1];
+            scores_->score[i] = (results[1] > 0) ? (double)results[0] / (double)results[1] : 0.0;
+        }
+    }
+
+    static const cv::Mat *target_image_;
+    static const BitplaneImage *packed_target_image_;
+    static const std::vector<RotationCandidate> *candidates_;
+    static RotationCandidateTable *scores_;
+    static RotationCandidateBound *bound_;
+};
+
+// Complete storage for ImgComparisonOp struct
+// Create temporary nonce objects because C++ requires references to point to a
+// valid object.
+// the null/nonce references will go out of scope after setup() is called and
+// these references
+// are set to valid objects
+const cv::Mat *ImgComparisonOp::target_image_ = nullptr;
+const BitplaneImage *ImgComparisonOp::packed_target_image_ = nullptr;
+const std::vector<RotationCandidate> *ImgComparisonOp::candidates_ = nullptr;
+RotationCandidateTable *ImgComparisonOp::scores_ = nullptr;
+RotationCandidateBound *ImgComparisonOp::bound_ = nullptr;
+
+
+// Returns the index within candidates that has the best comparison.
 // Returns -1 on failure.
 int BallImageProc::CompareCandidateAngleImages(const cv::Mat *target_image,
                                                const cv::Mat *candidate_elements_mat,
@@ -4164,137 +4964,1137 @@ int BallImageProc::CompareCandidateAngleImages(const cv::Mat *target_image,
     boost::timer::cpu_timer timer1;
 
     // Assume candidates is a vector that is already pre-sized and filled with
-    // candidate information
-    // and that the candidate_elements_mat has x, y, and z bounds that are
-    // commensurate with the candidates vector
+    // candidate information.  The candidates are in the same order as the
+    // candidate_elements_mat, so they are compared directly rather than by
+    // looking each one up through that matrix.
     int xSize = (*candidate_elements_mat_size)[0];
     int ySize = (*candidate_elements_mat_size)[1];
     int zSize = (*candidate_elements_mat_size)[2];
 
-    int numCandidates = xSize * ySize * zSize;
-    std::vector<std::string> comparisonData(numCandidates);
+    int numCandidates = (int)candidates->size();
+
+    if (xSize * ySize * zSize != numCandidates)
+    {
+        GS_LOG_MSG(warning, "CompareCandidateAngleImages - candidate_elements_mat does not match "
+                   "the number of candidates.");
+    }
+
+    // The scores are collected in a separate (flat) table and then copied back
+    // to the candidates
+    RotationCandidateTable scores;
+    scores.AppendCandidates(*candidates);
+
+    // The target image is packed just once and then compared against every
+    // (already-packed) candidate
+    BitplaneImage packed_target_image;
+    const BitplaneImage *packed_target_image_ptr = nullptr;
+    std::unique_ptr<RotationCandidateBound> bound;
+
+    if (kUseBitplaneImageComparison)
+    {
+        BitplaneImage::Pack(*target_image, kPixelIgnoreValue, packed_target_image);
+        packed_target_image_ptr = &packed_target_image;
+
+        if (kUseBranchAndBoundCandidateScoring)
+        {
+            bound = std::make_unique<RotationCandidateBound>(packed_target_image);
+        }
+    }
+
+    ImgComparisonOp::setup(target_image,
+                           packed_target_image_ptr,
+                           candidates,
+                           &scores,
+                           bound.get());
+
+    //  Serialized version for debugging
+    if (kSerializeOpsForDebug)
+    {
+        ImgComparisonOp()(cv::Range(0, numCandidates));
+    }
+    else
+    {
+        cv::parallel_for_(cv::Range(0, numCandidates), ImgComparisonOp());
+    }
+
+    if (bound)
+    {
+        RecordSkippedPixelComparisons(scores, *bound);
+    }
+
+    comparison_csv_data.clear();
+    comparison_csv_data.reserve(numCandidates);
+
+    for (int i = 0; i < numCandidates; i++)
+    {
+        RotationCandidate &c = (*candidates)[i];
+        c.pixels_matching = scores.pixels_matching[i];
+        c.pixels_examined = scores.pixels_examined[i];
+        c.score = scores.score[i];
+
+        // DEBUG - Save a CSV-compatible string for later analysis
+        comparison_csv_data.push_back(FormatRotationCandidateCsv(c));
+    }
+
+    int maxScaledScoreIndex = SelectBestRotationCandidate(scores);
+
+    timer1.stop();
+    boost::timer::cpu_times times = timer1.elapsed();
+    std::cout << "CompareCandidateAngleImages: ";
+    std::cout << std::fixed << std::setprecision(8)
+              << times.wall / 1.0e9 << "s wall, "
+              << times.user / 1.0e9 << "s user + "
+              << times.system / 1.0e9 << "s system.\n";
+
+    return maxScaledScoreIndex;
+}
+
+int BallImageProc::SelectBestRotationCandidate(const RotationCandidateTable &candidates)
+{
+    const size_t number_candidates = candidates.size();
+
+    if (number_candidates == 0)
+    {
+        return -1;
+    }
+
+    // Find the best candidate
+    // First, figure out what the largest number of pixels examined were.
+    // If we later get a good score, but the number of examined pixels were
+    // really low, then we might not want to pick that one.
+    // OR... just pick the highest number of matching pixels?  Probably not,
+    // as a far rotation that had few pixels to begin with, but very high
+    // correspondence might be the correct one
+
+    // Find the range of numbers of matching pixels and the total
+    // most-available pixels in order to insert that into the mix for
+    // a combined score.  Both are straight reductions over the count arrays.
+    double maxPixelsExamined = *std::max_element(candidates.pixels_examined.begin(),
+                                                 candidates.pixels_examined.end());
+    int maxPixelsMatchingIndex =
+        (int)(std::max_element(candidates.pixels_matching.begin(),
+                               candidates.pixels_matching.end()) -
+              candidates.pixels_matching.begin());
+
+    // Then penalize every candidate in one pass over the score and count
+    // arrays, and take the (first) largest result
+    std::vector<double> scaled_scores(number_candidates);
+    const double *score = candidates.score.data();
+    const int *pixels_examined = candidates.pixels_examined.data();
+
+    for (size_t i = 0; i < number_candidates; i++)
+    {
+        scaled_scores[i] = GetPenalizedCandidateScore(score[i],
+                                                      pixels_examined[i],
+                                                      maxPixelsExamined);
+    }
+
+    int bestIndex = (int)(std::max_element(scaled_scores.begin(), scaled_scores.end()) -
+                          scaled_scores.begin());
+
+    double maxScaledScore = -1.0;
+    int maxScaledScoreIndex = -1;
+
+    if (scaled_scores[bestIndex] > maxScaledScore)
+    {
+        maxScaledScore = scaled_scores[bestIndex];
+        maxScaledScoreIndex = bestIndex;
+    }
+
+    std::string s = "Best Candidate based on number of matching pixels was #" +
+                    std::to_string(maxPixelsMatchingIndex) +
+                    " - Rot: (" +
+                    std::to_string(candidates.x_rotation_degrees[maxPixelsMatchingIndex]) + ", " +
+                    std::to_string(candidates.y_rotation_degrees[maxPixelsMatchingIndex]) + ", " +
+                    std::to_string(candidates.z_rotation_degrees[maxPixelsMatchingIndex]) + ") ";
+    // GS_LOG_MSG(debug, s);
+
+    if (maxScaledScoreIndex < 0)
+    {
+        return -1;
+    }
+
+    s = "Best Candidate based on its scaled score of (" + std::to_string(maxScaledScore) +
+        ") was # " + std::to_string(maxScaledScoreIndex) +
+        " - Rot: (" + std::to_string(candidates.x_rotation_degrees[maxScaledScoreIndex]) + ", " +
+        std::to_string(candidates.y_rotation_degrees[maxScaledScoreIndex]) + ", " +
+        std::to_string(candidates.z_rotation_degrees[maxScaledScoreIndex]) + ") ";
+    GS_LOG_MSG(debug, s);
+
+    return maxScaledScoreIndex;
+}
+
+int BallImageProc::SelectBestRotationCandidate(const std::vector<RotationCandidate> &candidates)
+{
+    RotationCandidateTable table;
+    table.AppendCandidates(candidates);
+
+    return SelectBestRotationCandidate(table);
+}
+
+int BallImageProc::FindBestRotationCandidate(const cv::Mat &base_dimple_image,
+                                             const cv::Mat &target_image,
+                                             const RotationSearchSpace &search_space,
+                                             const GolfBall &ball,
+                                             std::vector<RotationCandidate> &output_candidates,
+                                             std::vector<std::string> &comparison_csv_data)
+{
+    if (kUseStreamingCandidateScoring)
+    {
+        return ScoreCandidateAngles(base_dimple_image,
+                                    target_image,
+                                    search_space,
+                                    ball,
+                                    output_candidates,
+                                    comparison_csv_data);
+    }
+
+    cv::Mat candidate_elements_mat;
+    cv::Vec3i candidate_elements_mat_size;
+
+    // ComputeCandidateAngleImages appends, and the candidates must line up
+    // with the index matrix
+    output_candidates.clear();
+
+    // After this, the candidate_elements_mat will have X,Y,Z elements with an
+    // index into the output_candidates vector.
+    // Each candidate in output_candidates will have an image, associated X,Y,Z
+    // information and a place to put a score
+    ComputeCandidateAngleImages(base_dimple_image,
+                                search_space,
+                                candidate_elements_mat,
+                                candidate_elements_mat_size,
+                                output_candidates,
+                                ball);
+
+    return CompareCandidateAngleImages(&target_image,
+                                       &candidate_elements_mat,
+                                       &candidate_elements_mat_size,
+                                       &output_candidates,
+                                       comparison_csv_data);
+}
+
+void RotationCandidateTable::AppendCandidates(const std::vector<RotationCandidate> &candidates)
+{
+    reserve(size() + candidates.size());
+
+    for (const RotationCandidate &c : candidates)
+    {
+        Append(c.x_rotation_degrees, c.y_rotation_degrees, c.z_rotation_degrees);
+        pixels_examined.back() = c.pixels_examined;
+        pixels_matching.back() = c.pixels_matching;
+        score.back() = c.score;
+    }
+}
+
+RotationCandidate RotationCandidateTable::GetCandidate(size_t i) const
+{
+    RotationCandidate c;
+    c.index = (int)i;
+    c.x_rotation_degrees = x_rotation_degrees[i];
+    c.y_rotation_degrees = y_rotation_degrees[i];
+    c.z_rotation_degrees = z_rotation_degrees[i];
+    c.pixels_examined = pixels_examined[i];
+    c.pixels_matching = pixels_matching[i];
+    c.score = score[i];
+
+    return c;
+}
+
+void RotationCandidateTable::GetCandidates(std::vector<RotationCandidate> &candidates) const
+{
+    candidates.clear();
+    candidates.reserve(size());
+
+    for (size_t i = 0; i < size(); i++)
+    {
+        candidates.push_back(GetCandidate(i));
+    }
+}
+
+// Adds every angle in search_space to candidates, in the same order as
+// ComputeCandidateAngleImages
+static void AppendCandidateAngles(const BallImageProc::RotationSearchSpace &search_space,
+                                  RotationCandidateTable &candidates)
+{
+    for (int x_rotation_degrees = search_space.anglex_rotation_degrees_start;
+         x_rotation_degrees <= search_space.anglex_rotation_degrees_end;
+         x_rotation_degrees += search_space.anglex_rotation_degrees_increment)
+    {
+        for (int y_rotation_degrees = search_space.angley_rotation_degrees_start;
+             y_rotation_degrees <= search_space.angley_rotation_degrees_end;
+             y_rotation_degrees += search_space.angley_rotation_degrees_increment)
+        {
+            for (int z_rotation_degrees = search_space.anglez_rotation_degrees_start;
+                 z_rotation_degrees <= search_space.anglez_rotation_degrees_end;
+                 z_rotation_degrees += search_space.anglez_rotation_degrees_increment)
+            {
+                candidates.Append(x_rotation_degrees, y_rotation_degrees, z_rotation_degrees);
+            }
+        }
+    }
+}
+
+int BallImageProc::FindBestCoarseRotationCandidate(const cv::Mat &base_dimple_image,
+                                                   const cv::Mat &target_image,
+                                                   const RotationSearchSpace &search_space,
+                                                   const GolfBall &ball,
+                                                   std::vector<RotationCandidate> &output_candidates,
+                                                   std::vector<std::string> &comparison_csv_data,
+                                                   cv::Vec3i &coarse_increments)
+{
+    coarse_increments = cv::Vec3i(search_space.anglex_rotation_degrees_increment,
+                                  search_space.angley_rotation_degrees_increment,
+                                  search_space.anglez_rotation_degrees_increment);
+
+    if (kSpinPyramidLevels > 1)
+    {
+        return FindBestRotationCandidatePyramid(base_dimple_image,
+                                                target_image,
+                                                search_space,
+                                                ball,
+                                                output_candidates,
+                                                comparison_csv_data,
+                                                coarse_increments);
+    }
+
+    return FindBestRotationCandidate(base_dimple_image,
+                                     target_image,
+                                     search_space,
+                                     ball,
+                                     output_candidates,
+                                     comparison_csv_data);
+}
+
+// Narrows [full_start, full_end] to [low, high], keeping the ends on the
+// full range's grid and never leaving the full range
+static void NarrowSpinPriorAxis(int full_start,
+                                int full_end,
+                                int increment,
+                                double low,
+                                double high,
+                                int &start,
+                                int &end)
+{
+    increment = std::max(1, increment);
+
+    int start_steps = (int)std::floor((low - full_start) / increment);
+    int end_steps = (int)std::ceil((high - full_start) / increment);
+
+    start = std::clamp(full_start + start_steps * increment, full_start, full_end);
+    end = std::clamp(full_start + end_steps * increment, start, full_end);
+}
+
+bool BallImageProc::GetSpinPriorSearchSpace(const RotationSearchSpace &full_search_space,
+                                            GolfSimClubs::GsClubType club_type,
+                                            RotationSearchSpace &prior_search_space)
+{
+    prior_search_space = full_search_space;
+
+    // Low and high ends of the window on each axis
+    cv::Vec3d low(full_search_space.anglex_rotation_degrees_start,
+                  full_search_space.angley_rotation_degrees_start,
+                  full_search_space.anglez_rotation_degrees_start);
+    cv::Vec3d high(full_search_space.anglex_rotation_degrees_end,
+                   full_search_space.angley_rotation_degrees_end,
+                   full_search_space.anglez_rotation_degrees_end);
+
+    std::vector<cv::Vec3d> history;
+
+    {
+        std::lock_guard<std::mutex> lock(spin_prior_history_mutex);
+        auto it = spin_prior_history.find((int)club_type);
+        if (it != spin_prior_history.end())
+        {
+            history.assign(it->second.begin(), it->second.end());
+        }
+    }
+
+    if (!history.empty() && (int)history.size() >= kSpinPriorMinHistoryShots)
+    {
+        // Recent shots with the same club are the best guide, so re-center on
+        // them.  The median keeps a single mis-read shot from dragging the
+        // window around.
+        for (int axis = 0; axis < 3; axis++)
+        {
+            std::vector<double> values;
+            for (const cv::Vec3d &rotation : history)
+            {
+                values.push_back(rotation[axis]);
+            }
+
+            std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+            double median = values[values.size() / 2];
+
+            low[axis] = median - kSpinPriorHistoryWindowDegrees;
+            high[axis] = median + kSpinPriorHistoryWindowDegrees;
+        }
+    }
+    else
+    {
+        const std::vector<float> *club_range = nullptr;
+
+        if (club_type == GolfSimClubs::GsClubType::kDriver)
+        {
+            club_range = &kSpinPriorDriverRange;
+        }
+        else if (club_type == GolfSimClubs::GsClubType::kIron)
+        {
+            club_range = &kSpinPriorIronRange;
+        }
+
+        if (club_range == nullptr || club_range->size() != 6)
+        {
+            return false;
+        }
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            low[axis] = (*club_range)[2 * axis];
+            high[axis] = (*club_range)[2 * axis + 1];
+        }
+    }
+
+    NarrowSpinPriorAxis(full_search_space.anglex_rotation_degrees_start,
+                        full_search_space.anglex_rotation_degrees_end,
+                        full_search_space.anglex_rotation_degrees_increment,
+                        low[0],
+                        high[0],
+                        prior_search_space.anglex_rotation_degrees_start,
+                        prior_search_space.anglex_rotation_degrees_end);
+    NarrowSpinPriorAxis(full_search_space.angley_rotation_degrees_start,
+                        full_search_space.angley_rotation_degrees_end,
+                        full_search_space.angley_rotation_degrees_increment,
+                        low[1],
+                        high[1],
+                        prior_search_space.angley_rotation_degrees_start,
+                        prior_search_space.angley_rotation_degrees_end);
+    NarrowSpinPriorAxis(full_search_space.anglez_rotation_degrees_start,
+                        full_search_space.anglez_rotation_degrees_end,
+                        full_search_space.anglez_rotation_degrees_increment,
+                        low[2],
+                        high[2],
+                        prior_search_space.anglez_rotation_degrees_start,
+                        prior_search_space.anglez_rotation_degrees_end);
+
+    const RotationSearchSpace &full = full_search_space;
+    const RotationSearchSpace &prior = prior_search_space;
+
+    bool narrowed = prior.anglex_rotation_degrees_start != full.anglex_rotation_degrees_start ||
+                    prior.anglex_rotation_degrees_end != full.anglex_rotation_degrees_end ||
+                    prior.angley_rotation_degrees_start != full.angley_rotation_degrees_start ||
+                    prior.angley_rotation_degrees_end != full.angley_rotation_degrees_end ||
+                    prior.anglez_rotation_degrees_start != full.anglez_rotation_degrees_start ||
+                    prior.anglez_rotation_degrees_end != full.anglez_rotation_degrees_end;
+
+    if (narrowed)
+    {
+        GS_LOG_TRACE_MSG(trace,
+                         "Spin search prior narrowed the coarse search to X: (" +
+                         std::to_string(prior.anglex_rotation_degrees_start) + ", " +
+                         std::to_string(prior.anglex_rotation_degrees_end) + "), Y: (" +
+                         std::to_string(prior.angley_rotation_degrees_start) + ", " +
+                         std::to_string(prior.angley_rotation_degrees_end) + "), Z: (" +
+                         std::to_string(prior.anglez_rotation_degrees_start) + ", " +
+                         std::to_string(prior.anglez_rotation_degrees_end) + ").");
+    }
+
+    return narrowed;
+}
+
+bool BallImageProc::IsSpinPriorResultAcceptable(const RotationCandidate &best,
+                                                const RotationSearchSpace &prior_search_space,
+                                                const RotationSearchSpace &full_search_space)
+{
+    if (best.score < kSpinPriorMinScore)
+    {
+        GS_LOG_TRACE_MSG(trace,
+                         "Spin search prior best score of " + std::to_string(best.score) +
+                         " is too low.");
+        return false;
+    }
+
+    // A best result within one step of an edge that the prior pulled in means
+    // that the real answer may well be outside of the window
+    auto atNarrowedEdge = [](int angle, int prior_start, int prior_end, int increment,
+                             int full_start, int full_end)
+                          {
+                              bool at_start = (prior_start > full_start &&
+                                               angle - prior_start < increment);
+                              bool at_end = (prior_end < full_end &&
+                                             prior_end - angle < increment);
+                              return at_start || at_end;
+                          };
+
+    if (atNarrowedEdge(best.x_rotation_degrees,
+                       prior_search_space.anglex_rotation_degrees_start,
+                       prior_search_space.anglex_rotation_degrees_end,
+                       prior_search_space.anglex_rotation_degrees_increment,
+                       full_search_space.anglex_rotation_degrees_start,
+                       full_search_space.anglex_rotation_degrees_end) ||
+        atNarrowedEdge(best.y_rotation_degrees,
+                       prior_search_space.angley_rotation_degrees_start,
+                       prior_search_space.angley_rotation_degrees_end,
+                       prior_search_space.angley_rotation_degrees_increment,
+                       full_search_space.angley_rotation_degrees_start,
+                       full_search_space.angley_rotation_degrees_end) ||
+        atNarrowedEdge(best.z_rotation_degrees,
+                       prior_search_space.anglez_rotation_degrees_start,
+                       prior_search_space.anglez_rotation_degrees_end,
+                       prior_search_space.anglez_rotation_degrees_increment,
+                       full_search_space.anglez_rotation_degrees_start,
+                       full_search_space.anglez_rotation_degrees_end))
+    {
+        GS_LOG_TRACE_MSG(trace, "Spin search prior best result is at the edge of the window.");
+        return false;
+    }
+
+    return true;
+}
+
+void BallImageProc::RecordSpinPriorResult(GolfSimClubs::GsClubType club_type,
+                                          const cv::Vec3d &rotation_degrees)
+{
+    std::lock_guard<std::mutex> lock(spin_prior_history_mutex);
+
+    std::deque<cv::Vec3d> &history = spin_prior_history[(int)club_type];
+    history.push_back(rotation_degrees);
+
+    while ((int)history.size() > std::max(1, kSpinPriorHistorySize))
+    {
+        history.pop_front();
+    }
+}
+
+void BallImageProc::ClearSpinPriorHistory()
+{
+    std::lock_guard<std::mutex> lock(spin_prior_history_mutex);
+    spin_prior_history.clear();
+}
+
+bool BallImageProc::FuseSpinPairRotations(const std::vector<cv::Vec3d> &pair_rotations,
+                                          const std::vector<double> &pair_intervals_uS,
+                                          double max_rpm_deviation,
+                                          int min_consistent_pairs,
+                                          cv::Vec3d &fused_rotation,
+                                          double &fused_interval_uS)
+{
+    const size_t number_pairs = std::min(pair_rotations.size(), pair_intervals_uS.size());
+
+    if (number_pairs == 0)
+    {
+        return false;
+    }
+
+    // Degrees per uS to RPM
+    const double kRateToRpm = 60. * 1000000. / 360.;
+
+    std::vector<cv::Vec3d> rates;
+
+    for (size_t p = 0; p < number_pairs; p++)
+    {
+        rates.push_back(pair_rotations[p] / pair_intervals_uS[p]);
+    }
+
+    cv::Vec3d median_rate;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        std::vector<double> axis_rates;
+
+        for (const cv::Vec3d &rate : rates)
+        {
+            axis_rates.push_back(rate[axis]);
+        }
+
+        std::sort(axis_rates.begin(), axis_rates.end());
+        size_t middle = axis_rates.size() / 2;
+        median_rate[axis] = (axis_rates.size() % 2 == 1) ? axis_rates[middle] :
+                            (axis_rates[middle - 1] + axis_rates[middle]) / 2.0;
+    }
+
+    cv::Vec3d weighted_rate_sum(0., 0., 0.);
+    double weight_sum = 0.0;
+    double interval_sum = 0.0;
+    int number_consistent_pairs = 0;
+
+    for (size_t p = 0; p < number_pairs; p++)
+    {
+        cv::Vec3d deviation = rates[p] - median_rate;
+        double max_deviation_rpm = kRateToRpm * std::max({ std::abs(deviation[0]),
+                                                           std::abs(deviation[1]),
+                                                           std::abs(deviation[2]) });
+
+        if (max_deviation_rpm > max_rpm_deviation)
+        {
+            GS_LOG_TRACE_MSG(trace, "FuseSpinPairRotations - dropping pair " + std::to_string(p) +
+                             ", which is " + std::to_string(max_deviation_rpm) +
+                             " RPM from the median.");
+            continue;
+        }
+
+        double weight = pair_intervals_uS[p] * pair_intervals_uS[p];
+        weighted_rate_sum += weight * rates[p];
+        weight_sum += weight;
+        interval_sum += pair_intervals_uS[p];
+        number_consistent_pairs++;
+    }
+
+    if (number_consistent_pairs < std::max(1, min_consistent_pairs) ||
+        weight_sum <= 0.0)
+    {
+        GS_LOG_TRACE_MSG(trace, "FuseSpinPairRotations - only " +
+                         std::to_string(number_consistent_pairs) + " consistent pairs.");
+        return false;
+    }
+
+    // Report the rotation over the average interval of the pairs that were
+    // used, so the angles stay comparable to a single-pair result
+    fused_interval_uS = interval_sum / number_consistent_pairs;
+    fused_rotation = (weighted_rate_sum / weight_sum) * fused_interval_uS;
+
+    GS_LOG_TRACE_MSG(trace, "FuseSpinPairRotations - fused " +
+                     std::to_string(number_consistent_pairs) + " of " +
+                     std::to_string(number_pairs) + " pairs.");
+
+    return true;
+}
+
+int BallImageProc::ScoreCandidateAngles(const cv::Mat &base_dimple_image,
+                                        const cv::Mat &target_image,
+                                        const RotationSearchSpace &search_space,
+                                        const GolfBall &ball,
+                                        std::vector<RotationCandidate> &output_candidates,
+                                        std::vector<std::string> &comparison_csv_data)
+{
+    boost::timer::cpu_timer timer1;
+
+    RotationCandidateTable candidates;
+    AppendCandidateAngles(search_space, candidates);
+
+    GS_LOG_TRACE_MSG(trace,
+                     "ScoreCandidateAngles will score " +
+                     std::to_string(candidates.size()) + " candidates.");
+
+    if (candidates.empty())
+    {
+        output_candidates.clear();
+        return -1;
+    }
+
+    ScoreRotationCandidates(base_dimple_image, target_image, ball, candidates);
+
+    comparison_csv_data.clear();
+    comparison_csv_data.reserve(candidates.size());
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        comparison_csv_data.push_back(FormatRotationCandidateCsv(candidates, i));
+    }
+
+    int best_candidate_index = SelectBestRotationCandidate(candidates);
+
+    candidates.GetCandidates(output_candidates);
+
+    timer1.stop();
+    boost::timer::cpu_times times = timer1.elapsed();
+    std::cout << "ScoreCandidateAngles: ";
+    std::cout << std::fixed << std::setprecision(8)
+              << times.wall / 1.0e9 << "s wall, "
+              << times.user / 1.0e9 << "s user + "
+              << times.system / 1.0e9 << "s system.\n";
+
+    return best_candidate_index;
+}
+
+void BallImageProc::ScoreRotationCandidates(const cv::Mat &base_dimple_image,
+                                            const cv::Mat &target_image,
+                                            const GolfBall &ball,
+                                            RotationCandidateTable &candidates,
+                                            bool allow_early_termination)
+{
+    if (candidates.empty())
+    {
+        return;
+    }
+
+    std::shared_ptr<const SphereProjectionTable> table = GetSphereProjectionTable(
+        base_dimple_image,
+        ball);
+
+    BitplaneImage packed_target_image;
+    BitplaneImage::Pack(target_image, kPixelIgnoreValue, packed_target_image);
+
+    std::unique_ptr<RotationCandidateBound> bound;
+
+    if (kUseBranchAndBoundCandidateScoring && allow_early_termination)
+    {
+        bound = std::make_unique<RotationCandidateBound>(packed_target_image);
+    }
+
+    // Each worker re-uses a single projected bitplane image for all of the
+    // candidates in its (contiguous) range of the table, so nothing here grows
+    // with the number of candidates except for the table itself
+    auto scoreCandidates = [&](const cv::Range &range)
+                           {
+                               BitplaneImage projected;
+
+                               for (int i = range.start; i < range.end; i++)
+                               {
+                                   cv::Vec3i rotation(candidates.x_rotation_degrees[i],
+                                                      candidates.y_rotation_degrees[i],
+                                                      candidates.z_rotation_degrees[i]);
+
+                                   ProjectToBitplaneImage(base_dimple_image,
+                                                          *table,
+                                                          rotation,
+                                                          projected);
+
+                                   if (bound)
+                                   {
+                                       bound->ScoreCandidate(projected, candidates, i);
+                                       continue;
+                                   }
+
+                                   cv::Vec2i results = BitplaneImage::Compare(packed_target_image,
+                                                                              projected);
+                                   candidates.pixels_matching[i] = results[0];
+                                   candidates.pixels_examined[i] = results[1];
+                                   candidates.score[i] = (results[1] > 0) ?
+                                                         (double)results[0] / (double)results[1] :
+                                                         0.0;
+                               }
+                           };
+
+    if (kSerializeOpsForDebug)
+    {
+        scoreCandidates(cv::Range(0, (int)candidates.size()));
+    }
+    else
+    {
+        cv::parallel_for_(cv::Range(0, (int)candidates.size()), scoreCandidates);
+    }
+
+    if (bound)
+    {
+        RecordSkippedPixelComparisons(candidates, *bound);
+    }
+}
+
+int BallImageProc::FindBestRotationCandidatePyramid(const cv::Mat &base_dimple_image,
+                                                    const cv::Mat &target_image,
+                                                    const RotationSearchSpace &search_space,
+                                                    const GolfBall &ball,
+                                                    std::vector<RotationCandidate> &output_candidates,
+                                                    std::vector<std::string> &comparison_csv_data,
+                                                    cv::Vec3i &final_increments)
+{
+    boost::timer::cpu_timer timer1;
+
+    int levels = std::clamp(kSpinPyramidLevels, 1, kMaxSpinPyramidLevels);
+    int top_k = std::max(1, kSpinPyramidTopK);
+
+    // Each axis has its own schedule of steps.  An axis without one entry per
+    // level uses its coarse increment scaled by the level's downsampling
+    // factor instead.
+    const std::vector<float> *configured_increments[3] = {
+        &kSpinPyramidLevelXIncrementDegrees,
+        &kSpinPyramidLevelYIncrementDegrees,
+        &kSpinPyramidLevelZIncrementDegrees
+    };
+    const cv::Vec3i coarse_increments(search_space.anglex_rotation_degrees_increment,
+                                      search_space.angley_rotation_degrees_increment,
+                                      search_space.anglez_rotation_degrees_increment);
+
+    RotationCandidateTable candidates;
+    std::vector<cv::Vec3i> survivors;
+    cv::Vec3i previous_increments;
+    int total_candidates_scored = 0;
+
+    for (int level = 0; level < levels; level++)
+    {
+        // Level 0 is the lowest resolution.  The last level is always at full
+        // resolution.
+        int factor = 1 << (levels - 1 - level);
+
+        cv::Vec3i increments;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            const std::vector<float> &schedule = *configured_increments[axis];
+
+            if (schedule.size() == (size_t)levels)
+            {
+                increments[axis] = std::max(1, (int)std::round(schedule[level]));
+            }
+            else
+            {
+                increments[axis] = coarse_increments[axis] * factor;
+            }
+        }
 
-    // Iterate through the matrix of candidates
+        candidates.clear();
 
-    ImgComparisonOp::setup(target_image, candidate_elements_mat, candidates, &comparisonData);
+        if (level == 0)
+        {
+            RotationSearchSpace level_search_space = search_space;
+            level_search_space.anglex_rotation_degrees_increment = increments[0];
+            level_search_space.angley_rotation_degrees_increment = increments[1];
+            level_search_space.anglez_rotation_degrees_increment = increments[2];
 
-    //  Serialized version for debugging
-    if (kSerializeOpsForDebug)
-    {
-        for (int x = 0; x < xSize; x++)
+            AppendCandidateAngles(level_search_space, candidates);
+        }
+        else
         {
-            for (int y = 0; y < ySize; y++)
+            // Search the window between the survivor and its neighbors on the
+            // previous level's grid.  The windows of nearby survivors will
+            // overlap, so only add each angle once.
+            std::set<std::tuple<int, int, int> > added_angles;
+
+            for (const cv::Vec3i &survivor : survivors)
             {
-                for (int z = 0; z < zSize; z++)
+                RotationSearchSpace window;
+
+                int anglex_window_width = (int)ceil(previous_increments[0] / 2.);
+                int angley_window_width = (int)ceil(previous_increments[1] / 2.);
+                int anglez_window_width = (int)ceil(previous_increments[2] / 2.);
+
+                window.anglex_rotation_degrees_increment = increments[0];
+                window.anglex_rotation_degrees_start = survivor[0] - anglex_window_width;
+                window.anglex_rotation_degrees_end = survivor[0] + anglex_window_width;
+                window.angley_rotation_degrees_increment = increments[1];
+                window.angley_rotation_degrees_start = survivor[1] - angley_window_width;
+                window.angley_rotation_degrees_end = survivor[1] + angley_window_width;
+                window.anglez_rotation_degrees_increment = increments[2];
+                window.anglez_rotation_degrees_start = survivor[2] - anglez_window_width;
+                window.anglez_rotation_degrees_end = survivor[2] + anglez_window_width;
+
+                RotationCandidateTable window_candidates;
+                AppendCandidateAngles(window, window_candidates);
+
+                for (size_t i = 0; i < window_candidates.size(); i++)
                 {
-                    ushort unusedValue = 0;
-                    int position[]{ x, y, z };
-                    ImgComparisonOp()(unusedValue, position);
+                    int x_rotation = window_candidates.x_rotation_degrees[i];
+                    int y_rotation = window_candidates.y_rotation_degrees[i];
+                    int z_rotation = window_candidates.z_rotation_degrees[i];
+
+                    if (added_angles.insert(std::make_tuple(x_rotation,
+                                                            y_rotation,
+                                                            z_rotation)).second)
+                    {
+                        candidates.Append(x_rotation, y_rotation, z_rotation);
+                    }
                 }
             }
         }
+
+        if (candidates.empty())
+        {
+            output_candidates.clear();
+            return -1;
+        }
+
+        GolfBall level_ball = ball;
+
+        if (factor > 1)
+        {
+            level_ball.set_x((float)(ball.x() / (double)factor));
+            level_ball.set_y((float)(ball.y() / (double)factor));
+            level_ball.measured_radius_pixels_ = ball.measured_radius_pixels_ / factor;
+            level_ball.ball_circle_[2] = ball.ball_circle_[2] / (float)factor;
+        }
+
+        // The survivors of the lower levels need their true scores, so only
+        // the final level (which just needs the single best) can abandon
+        // candidates early
+        ScoreRotationCandidates(DownsampleDimpleImage(base_dimple_image, factor),
+                                DownsampleDimpleImage(target_image, factor),
+                                level_ball,
+                                candidates,
+                                level == levels - 1);
+
+        total_candidates_scored += (int)candidates.size();
+
+        GS_LOG_TRACE_MSG(trace,
+                         "FindBestRotationCandidatePyramid level " + std::to_string(level) +
+                         " (1/" + std::to_string(factor) + " resolution) scored " +
+                         std::to_string(candidates.size()) + " candidates.");
+
+        if (level < levels - 1)
+        {
+            // Rank by the same penalized score that SelectBestRotationCandidate
+            // will eventually use, with the pixel counts scaled back up to
+            // full-resolution pixels
+            double maxPixelsExamined = *std::max_element(candidates.pixels_examined.begin(),
+                                                         candidates.pixels_examined.end());
+
+            std::vector<std::pair<double, int> > ranked;
+            ranked.reserve(candidates.size());
+
+            for (size_t i = 0; i < candidates.size(); i++)
+            {
+                ranked.emplace_back(GetPenalizedCandidateScore(candidates.score[i],
+                                                               candidates.pixels_examined[i],
+                                                               maxPixelsExamined,
+                                                               (double)(factor * factor)),
+                                    (int)i);
+            }
+
+            size_t num_survivors = std::min(ranked.size(), (size_t)top_k);
+            std::partial_sort(ranked.begin(),
+                              ranked.begin() + num_survivors,
+                              ranked.end(),
+                              [](const std::pair<double, int> &a, const std::pair<double, int> &b)
+                              {
+                                  return a.first > b.first;
+                              });
+
+            survivors.clear();
+
+            for (size_t i = 0; i < num_survivors; i++)
+            {
+                int survivor = ranked[i].second;
+                survivors.emplace_back(candidates.x_rotation_degrees[survivor],
+                                       candidates.y_rotation_degrees[survivor],
+                                       candidates.z_rotation_degrees[survivor]);
+            }
+        }
+
+        previous_increments = increments;
     }
-    else
+
+    final_increments = previous_increments;
+
+    comparison_csv_data.clear();
+    comparison_csv_data.reserve(candidates.size());
+
+    for (size_t i = 0; i < candidates.size(); i++)
     {
-        (*candidate_elements_mat).forEach<ushort>(ImgComparisonOp());
+        comparison_csv_data.push_back(FormatRotationCandidateCsv(candidates, i));
     }
 
-    // Find the best candidate from the comparison results
-    double maxScaledScore = -1.0;
-    double maxPixelsExamined = -1.0;
-    double maxPixelsMatching = -1.0;
-    int maxPixelsExaminedIndex = -1;
-    int maxPixelsMatchingIndex = -1;
-    int maxScaledScoreIndex = -1;
-    int bestScaledScoreRotX = 0;
-    int bestScaledScoreRotY = 0;
-    int bestScaledScoreRotZ = 0;
-    int bestPixelsMatchingRotX = 0;
-    int bestPixelsMatchingRotY = 0;
-    int bestPixelsMatchingRotZ = 0;
+    int best_candidate_index = SelectBestRotationCandidate(candidates);
 
-    // Find the best candidate
-    // First, figure out what the largest number of pixels examined were.
-    // If we later get a good score, but the number of examined pixels were
-    // really low, then we might not want to pick that one.
-    // OR... just pick the highest number of matching pixels?  Probably not,
-    // as a far rotation that had few pixels to begin with, but very high
-    // correspondence might be the correct one
+    candidates.GetCandidates(output_candidates);
 
-    double kSpinLowCountPenaltyPower = 2.0;
-    double kSpinLowCountPenaltyScalingFactor = 1000.0;
-    double kSpinLowCountDifferenceWeightingFactor = 500.0;
+    timer1.stop();
+    boost::timer::cpu_times times = timer1.elapsed();
+    std::cout << "FindBestRotationCandidatePyramid (" << levels << " levels, " <<
+        total_candidates_scored << " candidates): ";
+    std::cout << std::fixed << std::setprecision(8)
+              << times.wall / 1.0e9 << "s wall, "
+              << times.user / 1.0e9 << "s user + "
+              << times.system / 1.0e9 << "s system.\n";
 
-    double low_count_penalty = 0.0;
-    double final_scaled_score = 0.0;
+    return best_candidate_index;
+}
 
-    // Find the range of numbers of matching pixels and the total
-    // most-available pixels in order to insert that into the mix for
-    // a combined score
-    for (auto &element : *candidates)
+int BallImageProc::OptimizeRotation(const cv::Mat &base_dimple_image,
+                                    const cv::Mat &target_image,
+                                    const GolfBall &ball,
+                                    const cv::Vec3d &start_rotation,
+                                    const cv::Vec3d &initial_step,
+                                    double reference_pixels_examined,
+                                    cv::Vec3d &best_rotation,
+                                    std::vector<std::string> &comparison_csv_data)
+{
+    boost::timer::cpu_timer timer1;
+
+    std::shared_ptr<const SphereProjectionTable> table = GetSphereProjectionTable(
+        base_dimple_image,
+        ball);
+
+    BitplaneImage packed_target_image;
+    BitplaneImage::Pack(target_image, kPixelIgnoreValue, packed_target_image);
+    BitplaneImage projected;
+
+    comparison_csv_data.clear();
+    int evaluations = 0;
+
+    // Returns the negated (penalized) score, as the simplex minimizes
+    auto evaluate = [&](const cv::Vec3d &rotation)
+                    {
+                        ProjectToBitplaneImage(base_dimple_image, *table, rotation, projected);
+                        cv::Vec2i results = BitplaneImage::Compare(packed_target_image, projected);
+
+                        int pixels_matching = results[0];
+                        int pixels_examined = results[1];
+                        double score = (pixels_examined > 0) ?
+                                       (double)pixels_matching / (double)pixels_examined : 0.0;
+
+                        // Same columns as the grid search's CSV output
+                        comparison_csv_data.push_back(std::to_string(evaluations) + "\t" +
+                                                      std::to_string(rotation[0]) + "\t" +
+                                                      std::to_string(rotation[1]) + "\t" +
+                                                      std::to_string(rotation[2]) + "\t" +
+                                                      std::to_string(pixels_matching) + "\t" +
+                                                      std::to_string(pixels_examined) + "\t" +
+                                                      std::to_string(score) + "\n");
+                        evaluations++;
+
+                        // Covering more pixels than the reference is not penalized
+                        return -GetPenalizedCandidateScore(score,
+                                                           pixels_examined,
+                                                           std::max(reference_pixels_examined,
+                                                                    (double)pixels_examined));
+                    };
+
+    typedef std::pair<double, cv::Vec3d> SimplexVertex;
+    std::array<SimplexVertex, 4> simplex;
+
+    simplex[0] = SimplexVertex(evaluate(start_rotation), start_rotation);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        cv::Vec3d vertex = start_rotation;
+        vertex[axis] += initial_step[axis];
+        simplex[axis + 1] = SimplexVertex(evaluate(vertex), vertex);
+    }
+
+    auto byValue = [](const SimplexVertex &a, const SimplexVertex &b)
+                   {
+                       return a.first < b.first;
+                   };
+
+    // Standard Nelder-Mead reflection, expansion, contraction and shrink
+    // coefficients
+    const double kReflection = 1.0;
+    const double kExpansion = 2.0;
+    const double kContraction = 0.5;
+    const double kShrink = 0.5;
+
+    while (evaluations < kSpinOptimizerMaxEvaluations)
     {
-        RotationCandidate c = element;
+        std::sort(simplex.begin(), simplex.end(), byValue);
 
-        if (c.pixels_examined > maxPixelsExamined)
+        // Done once every vertex is within the tolerance of the best one
+        double simplex_size = 0.0;
+
+        for (int i = 1; i < 4; i++)
         {
-            maxPixelsExamined = c.pixels_examined;
-            maxPixelsExaminedIndex = c.index;
+            simplex_size = std::max(simplex_size,
+                                    cv::norm(simplex[i].second - simplex[0].second,
+                                             cv::NORM_INF));
         }
 
-        if (c.pixels_matching > maxPixelsMatching)
+        if (simplex_size < kSpinOptimizerToleranceDegrees)
         {
-            maxPixelsMatching = c.pixels_matching;
-            maxPixelsMatchingIndex = c.index;
-            bestPixelsMatchingRotX = c.x_rotation_degrees;
-            bestPixelsMatchingRotY = c.y_rotation_degrees;
-            bestPixelsMatchingRotZ = c.z_rotation_degrees;
+            break;
         }
-    }
 
-    for (auto &element : *candidates)
-    {
-        RotationCandidate c = element;
+        cv::Vec3d centroid = (simplex[0].second + simplex[1].second + simplex[2].second) / 3.0;
+        cv::Vec3d worst = simplex[3].second;
+        double worst_value = simplex[3].first;
 
-        low_count_penalty = std::pow((maxPixelsExamined - (double)c.pixels_examined) /
-                                     kSpinLowCountDifferenceWeightingFactor,
-                                     kSpinLowCountPenaltyPower) / kSpinLowCountPenaltyScalingFactor;
-        final_scaled_score = (c.score * 10.) - low_count_penalty;
+        cv::Vec3d reflected = centroid + kReflection * (centroid - worst);
+        double reflected_value = evaluate(reflected);
 
-        if (final_scaled_score > maxScaledScore)
+        if (reflected_value < simplex[0].first)
         {
-            maxScaledScore = final_scaled_score;
-            maxScaledScoreIndex = c.index;
-            bestScaledScoreRotX = c.x_rotation_degrees;
-            bestScaledScoreRotY = c.y_rotation_degrees;
-            bestScaledScoreRotZ = c.z_rotation_degrees;
+            cv::Vec3d expanded = centroid + kExpansion * (centroid - worst);
+            double expanded_value = evaluate(expanded);
+
+            simplex[3] = (expanded_value < reflected_value) ?
+                         SimplexVertex(expanded_value, expanded) :
+                         SimplexVertex(reflected_value, reflected);
+        }
+        else if (reflected_value < simplex[2].first)
+        {
+            simplex[3] = SimplexVertex(reflected_value, reflected);
+        }
+        else
+        {
+            // Contract toward whichever of the reflected and worst points is
+            // better
+            bool outside = (reflected_value < worst_value);
+            cv::Vec3d contracted = outside ?
+                                   centroid + kContraction * (reflected - centroid) :
+                                   centroid + kContraction * (worst - centroid);
+            double contracted_value = evaluate(contracted);
+
+            if (contracted_value < std::min(reflected_value, worst_value))
+            {
+                simplex[3] = SimplexVertex(contracted_value, contracted);
+            }
+            else
+            {
+                for (int i = 1; i < 4; i++)
+                {
+                    simplex[i].second = simplex[0].second +
+                                        kShrink * (simplex[i].second - simplex[0].second);
+                    simplex[i].first = evaluate(simplex[i].second);
+                }
+            }
         }
     }
 
-    std::string s = "Best Candidate based on number of matching pixels was #" +
-                    std::to_string(maxPixelsMatchingIndex) +
-                    " - Rot: (" + std::to_string(bestPixelsMatchingRotX) + ", " +
-                    std::to_string(bestPixelsMatchingRotY) + ", " +
-                    std::to_string(bestPixelsMatchingRotZ) + ") ";
-    // GS_LOG_MSG(debug, s);
-
-    s = "Best Candidate based on its scaled score of (" + std::to_string(maxScaledScore) +
-        ") was # " + std::to_string(maxScaledScoreIndex) +
-        " - Rot: (" + std::to_string(bestScaledScoreRotX) + ", " +
-        std::to_string(bestScaledScoreRotY) + ", " + std::to_string(bestScaledScoreRotZ) + ") ";
-    GS_LOG_MSG(debug, s);
+    std::sort(simplex.begin(), simplex.end(), byValue);
+    best_rotation = simplex[0].second;
 
-    // Transfer all the csv data to the output variable
-    comparison_csv_data = comparisonData;
+    GS_LOG_TRACE_MSG(trace,
+                     "OptimizeRotation found Rot: (" + std::to_string(best_rotation[0]) + ", " +
+                     std::to_string(best_rotation[1]) + ", " +
+                     std::to_string(best_rotation[2]) + ") after " +
+                     std::to_string(evaluations) + " evaluations.");
 
     timer1.stop();
     boost::timer::cpu_times times = timer1.elapsed();
-    std::cout << "CompareCandidateAngleImages: ";
+    std::cout << "OptimizeRotation (" << evaluations << " evaluations): ";
     std::cout << std::fixed << std::setprecision(8)
               << times.wall / 1.0e9 << "s wall, "
               << times.user / 1.0e9 << "s user + "
               << times.system / 1.0e9 << "s system.\n";
 
-    return maxScaledScoreIndex;
+    return evaluations;
+}
+
+cv::Mat BallImageProc::DownsampleDimpleImage(const cv::Mat &dimple_image, int factor)
+{
+    if (factor <= 1)
+    {
+        return dimple_image;
+    }
+
+    CV_Assert(dimple_image.type() == CV_8UC1);
+
+    cv::Size reduced_size(std::max(1, dimple_image.cols / factor),
+                          std::max(1, dimple_image.rows / factor));
+
+    // Area-averaging the valid and on pixels separately gives, for each
+    // reduced pixel, the fraction of its source pixels that were valid and
+    // the fraction that were both valid and on
+    cv::Mat valid_mask = (dimple_image != kPixelIgnoreValue);
+    cv::Mat on_mask = (dimple_image != 0) & valid_mask;
+
+    cv::Mat valid_fraction;
+    cv::Mat on_fraction;
+    valid_mask.convertTo(valid_fraction, CV_32F, 1.0 / 255.0);
+    on_mask.convertTo(on_fraction, CV_32F, 1.0 / 255.0);
+    cv::resize(valid_fraction, valid_fraction, reduced_size, 0, 0, cv::INTER_AREA);
+    cv::resize(on_fraction, on_fraction, reduced_size, 0, 0, cv::INTER_AREA);
+
+    cv::Mat reduced(reduced_size, CV_8UC1);
+
+    for (int row = 0; row < reduced.rows; row++)
+    {
+        const float *valid_row = valid_fraction.ptr<float>(row);
+        const float *on_row = on_fraction.ptr<float>(row);
+        uchar *reduced_row = reduced.ptr<uchar>(row);
+
+        for (int col = 0; col < reduced.cols; col++)
+        {
+            if (valid_row[col] < 0.5f)
+            {
+                reduced_row[col] = kPixelIgnoreValue;
+            }
+            else
+            {
+                reduced_row[col] = (on_row[col] * 2.0f >= valid_row[col]) ? 255 : 0;
+            }
+        }
+    }
+
+    return reduced;
 }
 
 cv::Vec2i BallImageProc::CompareRotationImage(const cv::Mat &img1,
@@ -4394,7 +6194,6 @@ cv::Mat BallImageProc::ApplyGaborFilterToBall(const cv::Mat &image_gray,
     int pos_lambda = 6;       // Nominal: 13.  Lambda = 5 and Gamma = 4 or 3
                               // also works well. last was 8
     int pos_gamma = 4;       // Nominal: 4, might try 3
-    int pos_th = 60;       // Nominal:
     int pos_psi = 9;      // Seems to have to be 9 or 27.  Will be multiplied by
                           // 3 degrees - CRITICAL - other values do not work at
                           // all
@@ -4405,7 +6204,6 @@ cv::Mat BallImageProc::ApplyGaborFilterToBall(const cv::Mat &image_gray,
     int pos_lambda = 6;       // Nominal: 13.  Lambda = 5 and Gamma = 4 or 3
                               // also works well
     int pos_gamma = 4;       // Nominal: 4
-    int pos_th = 60;       // Nominal:
     int pos_psi = 27;      // Will be multiplied by 3 degrees - CRITICAL - other
                            // values do not work at all
     float binary_threshold = 8.5;       // *10.  Nominal: 3
@@ -4420,21 +6218,50 @@ cv::Mat BallImageProc::ApplyGaborFilterToBall(const cv::Mat &image_gray,
 
     double sig = pos_sigma / 2.0;
     double lm = (double)pos_lambda;
-    double th = (double)pos_th * 2;
     double ps = (double)pos_psi * 10.0;
     double gm = (double)pos_gamma / 20.0;       // Nominal:  30
 
-    int white_percent = 0;
+    // The filter bank response does not depend on the binary threshold, so it
+    // is only computed once.  Each threshold that is tried below then just
+    // needs a lookup into the response's histogram.
+    cv::Mat response = ComputeGaborResponse(img_f32, kernel_size, sig, lm, ps, gm);
+
+    // pixels_above[t] is the number of response pixels that are > t, which is
+    // what cv::threshold would turn white for a threshold of t
+    int hist[256] = { 0 };
+
+    for (int row = 0; row < response.rows; row++)
+    {
+        const uchar *p = response.ptr<uchar>(row);
+
+        for (int col = 0; col < response.cols; col++)
+        {
+            hist[p[col]]++;
+        }
+    }
+
+    int pixels_above[256];
+    int running_count = 0;
+
+    for (int t = 255; t >= 0; t--)
+    {
+        pixels_above[t] = running_count;
+        running_count += hist[t];
+    }
+
+    const double total_pixels = (double)response.rows * response.cols;
+
+    // Same white percentage as ApplyTestGaborFilter would report
+    auto getWhitePercent = [&](float threshold)
+                           {
+                               int t = (int)std::round(threshold * 10.);
+                               int white_pixels = (t < 0) ? running_count :
+                                                  (t > 255) ? 0 : pixels_above[t];
 
-    cv::Mat dimpleImg = ApplyTestGaborFilter(img_f32,
-                                             kernel_size,
-                                             sig,
-                                             lm,
-                                             th,
-                                             ps,
-                                             gm,
-                                             binary_threshold,
-                                             white_percent);
+                               return (int)std::round(((double)white_pixels * 100.) / total_pixels);
+                           };
+
+    int white_percent = getWhitePercent(binary_threshold);
 
     GS_LOG_TRACE_MSG(trace,
                      "Initial Gabor filter white percent = " + std::to_string(white_percent));
@@ -4482,15 +6309,7 @@ cv::Mat BallImageProc::ApplyGaborFilterToBall(const cv::Mat &image_gray,
                                  std::to_string(binary_threshold) + " for better balance.");
             }
 
-            dimpleImg = ApplyTestGaborFilter(img_f32,
-                                             kernel_size,
-                                             sig,
-                                             lm,
-                                             th,
-                                             ps,
-                                             gm,
-                                             binary_threshold,
-                                             white_percent);
+            white_percent = getWhitePercent(binary_threshold);
             GS_LOG_TRACE_MSG(trace,
                              "Next, refined, Gabor white percent = " +
                              std::to_string(white_percent));
@@ -4512,6 +6331,8 @@ cv::Mat BallImageProc::ApplyGaborFilterToBall(const cv::Mat &image_gray,
         GS_LOG_TRACE_MSG(trace, "Final Gabor white percent = " + std::to_string(white_percent));
     }
 
+    cv::Mat dimpleImg = ThresholdGaborResponse(response, binary_threshold, white_percent);
+
     return dimpleImg;
 }
 
@@ -4525,9 +6346,33 @@ cv::Mat BallImageProc::ApplyTestGaborFilter(const cv::Mat &img_f32,
                                             float binary_threshold,
                                             int &white_percent  )
 {
-    cv::Mat dest = cv::Mat::zeros(img_f32.rows, img_f32.cols, img_f32.type());
-    cv::Mat accum = cv::Mat::zeros(img_f32.rows, img_f32.cols, img_f32.type());
-    cv::Mat kernel;
+    cv::Mat accumGray = ComputeGaborResponse(img_f32, kernel_size, sig, lm, ps, gm);
+
+    return ThresholdGaborResponse(accumGray, binary_threshold, white_percent);
+}
+
+std::shared_ptr<const std::vector<cv::Mat> > BallImageProc::GetGaborKernelBank(int kernel_size,
+                                                                               double sig,
+                                                                               double lm,
+                                                                               double ps,
+                                                                               double gm)
+{
+    typedef std::tuple<int, double, double, double, double> GaborKernelBankKey;
+
+    static std::mutex cache_mutex;
+    static std::map<GaborKernelBankKey, std::shared_ptr<const std::vector<cv::Mat> > > cache;
+
+    GaborKernelBankKey key(kernel_size, sig, lm, ps, gm);
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    auto it = cache.find(key);
+    if (it != cache.end())
+    {
+        return it->second;
+    }
+
+    auto kernels = std::make_shared<std::vector<cv::Mat> >();
 
     // Sweep through a bunch of different angles for the filter in order to pick
     // up features
@@ -4537,7 +6382,34 @@ cv::Mat BallImageProc::ApplyTestGaborFilter(const cv::Mat &img_f32,
                                              // works
     for (double theta = 0; theta <= 360.0; theta += thetaIncrement)
     {
-        kernel = CreateGaborKernel(kernel_size, sig, theta, lm, gm, ps);
+        kernels->push_back(CreateGaborKernel(kernel_size, sig, theta, lm, gm, ps));
+    }
+
+    GS_LOG_TRACE_MSG(trace,
+                     "Created bank of " + std::to_string(kernels->size()) + " Gabor kernels.");
+
+    cache.emplace(key, kernels);
+    return kernels;
+}
+
+cv::Mat BallImageProc::ComputeGaborResponse(const cv::Mat &img_f32,
+                                            const int kernel_size,
+                                            double sig,
+                                            double lm,
+                                            double ps,
+                                            double gm)
+{
+    std::shared_ptr<const std::vector<cv::Mat> > kernels = GetGaborKernelBank(kernel_size,
+                                                                             sig,
+                                                                             lm,
+                                                                             ps,
+                                                                             gm);
+
+    cv::Mat dest = cv::Mat::zeros(img_f32.rows, img_f32.cols, img_f32.type());
+    cv::Mat accum = cv::Mat::zeros(img_f32.rows, img_f32.cols, img_f32.type());
+
+    for (const cv::Mat &kernel : *kernels)
+    {
         cv::filter2D(img_f32, dest, CV_32F, kernel);
 
         cv::max(accum, dest, accum);
@@ -4548,12 +6420,19 @@ cv::Mat BallImageProc::ApplyTestGaborFilter(const cv::Mat &img_f32,
     // Convert from the 0.0 to 1.0 range into 0-255
     accum.convertTo(accumGray, CV_8U, 255, 0);
 
-    cv::Mat dimpleEdges = cv::Mat::zeros(accum.rows, accum.cols, accum.type());
+    return accumGray;
+}
+
+cv::Mat BallImageProc::ThresholdGaborResponse(const cv::Mat &response,
+                                              float binary_threshold,
+                                              int &white_percent)
+{
+    cv::Mat dimpleEdges = cv::Mat::zeros(response.rows, response.cols, response.type());
 
     // Threshold the image to either 0 or 255
     const int edgeThresholdLow = (int)std::round(binary_threshold * 10.);
     const int edgeThresholdHigh = 255;
-    cv::threshold(accumGray, dimpleEdges, edgeThresholdLow, edgeThresholdHigh, cv::THRESH_BINARY);
+    cv::threshold(response, dimpleEdges, edgeThresholdLow, edgeThresholdHigh, cv::THRESH_BINARY);
 
     white_percent = (int)std::round(((double)cv::countNonZero(dimpleEdges) * 100.) /
                                     ((double)dimpleEdges.rows * dimpleEdges.cols));
@@ -4679,6 +6558,11 @@ bool BallImageProc::ComputeCandidateAngleImages(const cv::Mat &base_dimple_image
                 // centered in the camera's image
                 c.index = vectorIndex;
                 c.img = ball13DImage;
+
+                if (kUseBitplaneImageComparison)
+                {
+                    BitplaneImage::Pack(ball13DImage, kPixelIgnoreValue, c.packed_img);
+                }
                 c.x_rotation_degrees = x_rotation_degrees - xAngleOffset;
                 c.y_rotation_degrees = y_rotation_degrees - yAngleOffset;
                 c.z_rotation_degrees = z_rotation_degrees;
@@ -5067,6 +6951,13 @@ cv::Mat BallImageProc::Project2dImageTo3dBall(const cv::Mat &image_gray,
                                               const GolfBall &ball,
                                               const cv::Vec3i &rotation_angles_degrees)
 {
+    if (kUseSphereProjectionCache)
+    {
+        std::shared_ptr<const SphereProjectionTable> table = GetSphereProjectionTable(image_gray,
+                                                                                      ball);
+        return Project2dImageTo3dBallUsingTable(image_gray, *table, rotation_angles_degrees);
+    }
+
     // Create a new 3D Mat to hold the results
     int sizes[2] = { image_gray.rows, image_gray.cols };      // , image_gray.rows
                                                               // };
@@ -5199,6 +7090,245 @@ cv::Mat BallImageProc::Project2dImageTo3dBall(const cv::Mat &image_gray,
     return projectedImg;
 }
 
+cv::Matx33d BallImageProc::GetBallRotationMatrix(const cv::Vec3d &rotation_angles_degrees)
+{
+    // Negative due to rotation in X axis being backward - see
+    // Project2dImageTo3dBall
+    double x_rad = -CvUtils::DegreesToRadians(rotation_angles_degrees[0]);
+    double y_rad = CvUtils::DegreesToRadians(rotation_angles_degrees[1]);
+    double z_rad = CvUtils::DegreesToRadians(rotation_angles_degrees[2]);
+
+    double sinX = sin(x_rad);
+    double cosX = cos(x_rad);
+    double sinY = sin(y_rad);
+    double cosY = cos(y_rad);
+    double sinZ = sin(z_rad);
+    double cosZ = cos(z_rad);
+
+    // These are the same three rotations (and in the same order) that the
+    // projectionOp performs pixel-by-pixel
+    cv::Matx33d rotX(1.0, 0.0, 0.0,
+                     0.0, cosX, -sinX,
+                     0.0, sinX, cosX);
+    cv::Matx33d rotY(cosY, 0.0, sinY,
+                     0.0, 1.0, 0.0,
+                     -sinY, 0.0, cosY);
+    cv::Matx33d rotZ(cosZ, -sinZ, 0.0,
+                     sinZ, cosZ, 0.0,
+                     0.0, 0.0, 1.0);
+
+    return rotZ * rotY * rotX;
+}
+
+std::shared_ptr<const SphereProjectionTable> BallImageProc::GetSphereProjectionTable(
+    const cv::Mat &image_gray,
+    const GolfBall &ball)
+{
+    typedef std::tuple<double, int, int, long, long> TableKey;
+
+    static std::mutex cache_mutex;
+    static std::map<TableKey, std::shared_ptr<const SphereProjectionTable> > cache;
+
+    TableKey key(ball.measured_radius_pixels_, image_gray.rows, image_gray.cols, ball.x(),
+                 ball.y());
+
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end())
+        {
+            return it->second;
+        }
+    }
+
+    boost::timer::cpu_timer timer1;
+
+    auto table = std::make_shared<SphereProjectionTable>();
+    table->rows = image_gray.rows;
+    table->cols = image_gray.cols;
+    table->center_x = ball.x();
+    table->center_y = ball.y();
+    table->radius = ball.measured_radius_pixels_;
+    table->unit_xyz = cv::Mat(image_gray.rows, image_gray.cols, CV_32FC3, cv::Scalar(0, 0, 0));
+    table->valid_mask = cv::Mat::zeros(image_gray.rows, image_gray.cols, CV_8UC1);
+
+    const double r = table->radius;
+    const double rSquared = r * r;
+
+    // Same (imageX, imageY) convention and hemisphere math as
+    // projectionOp::getBallZ, just done once instead of per-candidate
+    for (int imageX = 0; imageX < table->rows; imageX++)
+    {
+        cv::Vec3f *xyz = table->unit_xyz.ptr<cv::Vec3f>(imageX);
+        uchar *valid = table->valid_mask.ptr<uchar>(imageX);
+
+        for (int imageY = 0; imageY < table->cols; imageY++)
+        {
+            double imageXFromCenter = (double)imageX - (double)table->center_x;
+            double imageYFromCenter = (double)imageY - (double)table->center_y;
+            double ball3dZ = 0.0;
+
+            if (std::abs(imageXFromCenter) <= r && std::abs(imageYFromCenter) <= r)
+            {
+                double diff = rSquared - (imageXFromCenter * imageXFromCenter +
+                                          imageYFromCenter * imageYFromCenter);
+                if (diff > 0.0)
+                {
+                    ball3dZ = sqrt(diff);
+                }
+            }
+
+            // Points off the hemisphere are still rotated (with a zero Z) so
+            // that they can mark where they land as being ignored
+            xyz[imageY] = cv::Vec3f((float)(imageXFromCenter / r),
+                                    (float)(imageYFromCenter / r),
+                                    (float)(ball3dZ / r));
+            valid[imageY] = (ball3dZ > 0.0001) ? 255 : 0;
+        }
+    }
+
+    timer1.stop();
+    GS_LOG_TRACE_MSG(trace,
+                     "Built sphere projection table for radius " + std::to_string(r) + " (" +
+                     std::to_string(table->cols) + "x" + std::to_string(table->rows) + ") in " +
+                     std::to_string(timer1.elapsed().wall / 1.0e6) + "ms.");
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+
+    if (cache.size() >= kMaxSphereProjectionTables)
+    {
+        cache.clear();
+    }
+
+    // If another thread beat us to it, just use the one that is already there
+    auto result = cache.emplace(key, table);
+    return result.first->second;
+}
+
+// Rotates the pixels in rows [start_row, end_row) of the projection table by
+// the rotation matrix m.  For each pixel that lands on the visible part of the
+// ball, calls write_pixel(rotated_row, rotated_col, rotated_z, source_row,
+// source_col).  Pixels are visited in row-major order.
+template <typename PixelWriter>
+static void RotateSphereProjectionRows(const SphereProjectionTable &table,
+                                       const cv::Matx33d &m,
+                                       int start_row,
+                                       int end_row,
+                                       PixelWriter &&write_pixel)
+{
+    const double r = table.radius;
+    const double rSquared = r * r;
+    const double centerX = (double)table.center_x;
+    const double centerY = (double)table.center_y;
+
+    for (int imageX = start_row; imageX < end_row; imageX++)
+    {
+        const cv::Vec3f *xyz = table.unit_xyz.ptr<cv::Vec3f>(imageX);
+
+        for (int imageY = 0; imageY < table.cols; imageY++)
+        {
+            const cv::Vec3f &p = xyz[imageY];
+
+            // Only the X and Y of the rotated point are needed to find where it
+            // lands
+            double rotatedXFromCenter = r * (m(0, 0) * p[0] + m(0, 1) * p[1] + m(0, 2) * p[2]);
+            double rotatedYFromCenter = r * (m(1, 0) * p[0] + m(1, 1) * p[1] + m(1, 2) * p[2]);
+
+            double diff = rSquared - (rotatedXFromCenter * rotatedXFromCenter +
+                                      rotatedYFromCenter * rotatedYFromCenter);
+
+            // As with the projectionOp, points that land off of the visible
+            // ball are dropped
+            if (diff <= 0.0)
+            {
+                continue;
+            }
+
+            double rotatedImageX = rotatedXFromCenter + centerX;
+            double rotatedImageY = rotatedYFromCenter + centerY;
+
+            if (rotatedImageX < 0 || rotatedImageY < 0 ||
+                rotatedImageX >= table.cols || rotatedImageY >= table.rows)
+            {
+                continue;
+            }
+
+            write_pixel((int)(rotatedImageX + 0.5),
+                        (int)(rotatedImageY + 0.5),
+                        (int)sqrt(diff),
+                        imageX,
+                        imageY);
+        }
+    }
+}
+
+cv::Mat BallImageProc::Project2dImageTo3dBallUsingTable(const cv::Mat &image_gray,
+                                                        const SphereProjectionTable &table,
+                                                        const cv::Vec3i &rotation_angles_degrees)
+{
+    CV_Assert((image_gray.type() == CV_8UC1));
+    CV_Assert((image_gray.rows == table.rows && image_gray.cols == table.cols));
+
+    int sizes[2] = { image_gray.rows, image_gray.cols };
+    cv::Mat projectedImg = cv::Mat(2, sizes, CV_32SC2, cv::Scalar(0, kPixelIgnoreValue));
+    projectedImg.rows = image_gray.rows;
+    projectedImg.cols = image_gray.cols;
+
+    const cv::Matx33d m = GetBallRotationMatrix(rotation_angles_degrees);
+
+    auto writePixel = [&](int rotatedX, int rotatedY, int rotatedZ, int sourceX, int sourceY)
+                      {
+                          cv::Vec2i &dest = projectedImg.at<cv::Vec2i>(rotatedX, rotatedY);
+                          dest[0] = rotatedZ;
+                          dest[1] = table.valid_mask.at<uchar>(sourceX, sourceY) ?
+                                    image_gray.at<uchar>(sourceX, sourceY) : kPixelIgnoreValue;
+                      };
+
+    auto projectRows = [&](const cv::Range &range)
+                       {
+                           RotateSphereProjectionRows(table, m, range.start, range.end,
+                                                      writePixel);
+                       };
+
+    if (kSerializeOpsForDebug)
+    {
+        projectRows(cv::Range(0, table.rows));
+    }
+    else
+    {
+        cv::parallel_for_(cv::Range(0, table.rows), projectRows);
+    }
+
+    return projectedImg;
+}
+
+void BallImageProc::ProjectToBitplaneImage(const cv::Mat &image_gray,
+                                           const SphereProjectionTable &table,
+                                           const cv::Vec3d &rotation_angles_degrees,
+                                           BitplaneImage &projected)
+{
+    CV_Assert((image_gray.type() == CV_8UC1));
+    CV_Assert((image_gray.rows == table.rows && image_gray.cols == table.cols));
+
+    // Anything that is never written to stays invalid (ignored), just as with
+    // the kPixelIgnoreValue-initialized Mat in Project2dImageTo3dBall
+    projected.Reset(image_gray.rows, image_gray.cols);
+
+    const cv::Matx33d m = GetBallRotationMatrix(rotation_angles_degrees);
+
+    // This is run serially, as the callers parallelize across candidates
+    RotateSphereProjectionRows(table, m, 0, table.rows,
+                               [&](int rotatedX, int rotatedY, int rotatedZ, int sourceX,
+                                   int sourceY)
+                               {
+                                   uchar pixel = table.valid_mask.at<uchar>(sourceX, sourceY) ?
+                                                 image_gray.at<uchar>(sourceX, sourceY) :
+                                                 kPixelIgnoreValue;
+                                   projected.SetPixel(rotatedX, rotatedY,
+                                                      pixel != kPixelIgnoreValue, pixel != 0);
+                               });
+}
+
 void BallImageProc::Unproject3dBallTo2dImage(const cv::Mat &src3D,
                                              cv::Mat &destination_image_gray,
                                              const GolfBall &ball)
@@ -10,8 +10,12 @@
 #ifndef PI_TRAC_IMAGE_PROCESSOR_H
 #define PI_TRAC_IMAGE_PROCESSOR_H
 
+#include <atomic>
 #include <iostream>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
 
 #include <opencv4/opencv2/core.hpp>
 #include <opencv4/opencv2/imgcodecs.hpp>
@@ -22,6 +26,9 @@
 #include "Common/Camera/gs_camera.h"
 #include "Common/Utils/colorsys.h"
 #include "Common/GolfSim/Ball/golf_ball.h"
+#include "Common/GolfSim/Clubs/gs_clubs.h"
+#include "Infrastructure/ImageProcessing/BitplaneImage.h"
+#include "Infrastructure/ImageProcessing/ColorMaskLut.h"
 
 
 namespace PiTrac
@@ -33,7 +40,7 @@ const uchar kPixelIgnoreValue = 128;
 // Holds one potential rotated golf ball candidate image and associated data
 struct RotationCandidate
 {
-    short index = 0;
+    int index = 0;
     cv::Mat img;
     int x_rotation_degrees = 0; // All Rotations are in degrees
     int y_rotation_degrees = 0;
@@ -41,6 +48,95 @@ struct RotationCandidate
     int pixels_examined = 0;
     int pixels_matching = 0;
     double score = 0;
+
+    // The same candidate image, packed for the faster bitplane comparison
+    BitplaneImage packed_img;
+};
+
+// The angles and results of a set of rotation candidates, stored as parallel
+// arrays (one entry per candidate) so that scoring can be partitioned over
+// them directly and the best-candidate selection is a simple pass over
+// contiguous memory.  Used by the searches that never need candidate images.
+struct RotationCandidateTable
+{
+    std::vector<int> x_rotation_degrees;
+    std::vector<int> y_rotation_degrees;
+    std::vector<int> z_rotation_degrees;
+    std::vector<int> pixels_examined;
+    std::vector<int> pixels_matching;
+    std::vector<double> score;
+
+    size_t size() const
+    {
+        return x_rotation_degrees.size();
+    }
+
+    bool empty() const
+    {
+        return x_rotation_degrees.empty();
+    }
+
+    void clear()
+    {
+        x_rotation_degrees.clear();
+        y_rotation_degrees.clear();
+        z_rotation_degrees.clear();
+        pixels_examined.clear();
+        pixels_matching.clear();
+        score.clear();
+    }
+
+    void reserve(size_t number_candidates)
+    {
+        x_rotation_degrees.reserve(number_candidates);
+        y_rotation_degrees.reserve(number_candidates);
+        z_rotation_degrees.reserve(number_candidates);
+        pixels_examined.reserve(number_candidates);
+        pixels_matching.reserve(number_candidates);
+        score.reserve(number_candidates);
+    }
+
+    // Adds an as-yet unscored candidate at the given angles
+    void Append(int x_rotation, int y_rotation, int z_rotation)
+    {
+        x_rotation_degrees.push_back(x_rotation);
+        y_rotation_degrees.push_back(y_rotation);
+        z_rotation_degrees.push_back(z_rotation);
+        pixels_examined.push_back(0);
+        pixels_matching.push_back(0);
+        score.push_back(0.0);
+    }
+
+    // Appends the angles and results (but not the images) of candidates
+    void AppendCandidates(const std::vector<RotationCandidate> &candidates);
+
+    // Returns candidate i as a RotationCandidate (without an image) whose
+    // index is i
+    RotationCandidate GetCandidate(size_t i) const;
+
+    // Replaces candidates with every entry of the table, in order
+    void GetCandidates(std::vector<RotationCandidate> &candidates) const;
+};
+
+// Per-pixel geometry of an (isolated) ball image projected onto the unit
+// sphere.  This only depends on the image size and the ball's center and
+// radius, so it is built once for that geometry and then shared by every
+// rotation candidate (and every shot) that uses the same ball radius.
+struct SphereProjectionTable
+{
+    int rows = 0;
+    int cols = 0;
+    long center_x = 0;
+    long center_y = 0;
+    double radius = 0.0;
+
+    // CV_32FC3 - the (x, y, z) point on the unit sphere for each pixel, using
+    // the same (imageX, imageY) indexing as Project2dImageTo3dBall.  Pixels
+    // that are not on the visible hemisphere have a z of 0.
+    cv::Mat unit_xyz;
+
+    // CV_8UC1 - 255 where the pixel is on the visible hemisphere, 0 otherwise
+    cv::Mat valid_mask;
 };
 
 class BallImageProc
@@ -142,6 +238,26 @@ class BallImageProc
     static int kExternallyStrobedCLAHEClipLimit;
     static int kExternallyStrobedCLAHETilesGridSize;
 
+    // If set, GetBall runs its Hough transform once and then steps param2
+    // over the resulting candidates instead of re-running the transform
+    static bool kUseSinglePassHoughAccumulator;
+
+    // If set, GetBall makes its color mask directly from the BGR image with
+    // a lookup table, rather than converting the image to HSV first
+    static bool kUseColorMaskLut;
+
+    // If set, GetBall makes its search image with SearchImagePreprocessor
+    // (one pass over row strips) instead of a chain of whole-image operations
+    static bool kUseFusedSearchImagePreprocessing;
+
+    // If set, AnalyzeStrobedBalls uses GetBallWithConcurrentHoughStrategies
+    // for its search of the whole image
+    static bool kUseConcurrentHoughStrategies;
+
+    // If set, FindBestEllipseFornaciari runs the ellipse detector's four
+    // triplet passes concurrently
+    static bool kUseParallelEllipseTriplets;
+
     static bool kUseDynamicRadiiAdjustment;
     static int kNumberRadiiToAverageForDynamicAdjustment;
     static double kStrobedNarrowingRadiiMinRatio;
@@ -183,9 +299,78 @@ class BallImageProc
     static double kBestCircleIdentificationMinRadiusRatio;
     static double kBestCircleIdentificationMaxRadiusRatio;
 
+    // If set, DetermineBestCircle first tries to refine the circle with a
+    // robust least-squares fit to the ball's edge (see CircleRefiner), and
+    // only runs its Hough transform if that fails
+    static bool kUseLeastSquaresBestCircleRefinement;
+
     static int kGaborMaxWhitePercent;
     static int kGaborMinWhitePercent;
 
+    // If true, candidate rotations are projected using a cached, per-radius
+    // table of unit-sphere coordinates instead of re-solving the hemisphere
+    // for every pixel of every candidate
+    static bool kUseSphereProjectionCache;
+
+    // If true, rotation candidates are compared using packed bitplanes and
+    // popcounts instead of byte-by-byte.  The byte-wise CompareRotationImage is
+    // kept for verification.
+    static bool kUseBitplaneImageComparison;
+
+    // If true, each rotation candidate is projected and scored in the same
+    // pass, and the candidate images are never materialized.  Memory use during
+    // GetBallRotation then stays flat regardless of the search space size.
+    static bool kUseStreamingCandidateScoring;
+
+    // Number of image pyramid levels used for the coarse spin search.  Each
+    // level halves the resolution of the dimple images.  The full coarse
+    // angular grid is only searched at the lowest resolution, and each
+    // higher-resolution level only searches around the best
+    // kSpinPyramidTopK candidates of the level below it.  A value of 1 (or
+    // less) turns the pyramid off.
+    static int kSpinPyramidLevels;
+    static int kSpinPyramidTopK;
+
+    // The angular step (in degrees) on each axis for each pyramid level, from
+    // the lowest resolution to full resolution.  If an axis does not have
+    // exactly one entry per level, each level uses that axis' coarse
+    // increment multiplied by the level's downsampling factor.
+    static std::vector<float> kSpinPyramidLevelXIncrementDegrees;
+    static std::vector<float> kSpinPyramidLevelYIncrementDegrees;
+    static std::vector<float> kSpinPyramidLevelZIncrementDegrees;
+
+    // If true, the fine spin search starts a Nelder-Mead optimizer at the best
+    // coarse candidate instead of evaluating a dense 1-degree grid around it.
+    // The optimizer works with fractional angles, and stops once its simplex
+    // has shrunk below kSpinOptimizerToleranceDegrees or after
+    // kSpinOptimizerMaxEvaluations candidate evaluations.
+    static bool kUseSpinOptimizerForFineSearch;
+    static double kSpinOptimizerToleranceDegrees;
+    static int kSpinOptimizerMaxEvaluations;
+
+    // If true, packed rotation candidates are compared a block of rows at a
+    // time, and a candidate is abandoned as soon as it can no longer beat the
+    // best candidate so far (including the low-count penalty).  The best
+    // candidate is always the same as with a full comparison.
+    static bool kUseBranchAndBoundCandidateScoring;
+
+    // If true, the coarse spin search is narrowed to where the spin for the
+    // current club is likely to be.  Once there are at least
+    // kSpinPriorMinHistoryShots recent results for the club, the window is
+    // +/- kSpinPriorHistoryWindowDegrees around their median.  Otherwise, the
+    // kSpinPrior<Club>Range band is used (X start, X end, Y start, Y end,
+    // Z start, Z end, in the same search-space degrees as the kCoarse
+    // ranges).  If the best narrowed result scores below kSpinPriorMinScore
+    // or lands on the edge of the window, the full coarse range is searched
+    // instead.
+    static bool kUseSpinSearchPrior;
+    static std::vector<float> kSpinPriorDriverRange;
+    static std::vector<float> kSpinPriorIronRange;
+    static int kSpinPriorHistorySize;
+    static int kSpinPriorMinHistoryShots;
+    static double kSpinPriorHistoryWindowDegrees;
+    static double kSpinPriorMinScore;
+
 
     // This determines which potential 3D angles will be searched for spin
     // processing
@@ -267,6 +452,47 @@ class BallImageProc
                    bool chooseLargestFinalBall = false,
                    bool report_find_failures = true );
 
+    // The Hough transform that GetBall uses for the strobed modes
+    enum HoughStrategy
+    {
+        kConfiguredHough = 0,       // Per kStrobedBallsUseAltHoughAlgorithm
+        kGradientHough = 1,
+        kGradientAltHough = 2
+    };
+
+    HoughStrategy hough_strategy_ = kConfiguredHough;
+
+    // If set, GetBall checks this between its stages and gives up (returning
+    // false) once it is true
+    const std::atomic<bool> *search_cancelled_ = nullptr;
+
+    // Runs GetBall with the configured Hough strategy and with the other one
+    // at the same time, each on its own thread and with its own copy of this
+    // object (and of its images).  Returns the balls from the configured
+    // strategy if it finds at least min_balls balls, and otherwise from the
+    // other one if it does.  Returns false with no balls if neither does.
+    // Always waits for both strategies to finish.
+    bool GetBallWithConcurrentHoughStrategies(const cv::Mat &img,
+                                              const GolfBall &baseBallWithSearchParams,
+                                              std::vector<GolfBall> &return_balls,
+                                              cv::Rect &expectedBallArea,
+                                              BallSearchMode search_mode,
+                                              bool chooseLargestFinalBall,
+                                              bool report_find_failures,
+                                              int min_balls);
+
+    // Runs run_strategy(i, cancelled) for each i from 0 to
+    // number_of_strategies - 1, all at the same time, and waits for all of
+    // them to finish.  Returns the lowest i for which run_strategy returned
+    // true, or -1 if there is none.  Once strategy i has returned true, the
+    // cancelled flags of the strategies after it are set, as they can no
+    // longer win.
+    using ConcurrentStrategy = std::function<bool (size_t index,
+                                                   const std::atomic<bool> &cancelled)>;
+
+    static int RunConcurrentStrategies(size_t number_of_strategies,
+                                       const ConcurrentStrategy &run_strategy);
+
     bool BallIsPresent(const cv::Mat &img);
 
     // Performs some iterative refinement to try to identify the best ball
@@ -287,10 +513,23 @@ class BallImageProc
 
     // Inputs are two balls and the images within which those balls exist
     // Returns the estimated amount of rotation in x, y, and z axes in degrees
+    // If pair_index >= 0, the balls are one of several pairs being analyzed
+    // at once.  The CSV files and logged images are then named for the pair,
+    // only pair 0 updates the webserver's result images, and the result is
+    // not recorded in the spin prior.  Instead, if prior_rotation is given,
+    // it is set to what would have been recorded (or to nothing), so that
+    // the caller can record one result for the whole shot.
     static cv::Vec3d GetBallRotation(const cv::Mat &full_gray_image1,
                                      const GolfBall &ball1,
                                      const cv::Mat &full_gray_image2,
-                                     const GolfBall &ball2);
+                                     const GolfBall &ball2,
+                                     int pair_index = -1,
+                                     std::optional<cv::Vec3d> *prior_rotation = nullptr);
+
+    // True if GetBallRotation can be called from several threads at once.
+    // The non-streaming candidate comparison and the uncached projection both
+    // keep their working state in static members.
+    static bool IsGetBallRotationReentrant();
 
     static bool ComputeCandidateAngleImages(const cv::Mat &base_dimple_image,
                                             const RotationSearchSpace &search_space,
@@ -307,6 +546,85 @@ class BallImageProc
                                            std::vector<RotationCandidate> *candidates,
                                            std::vector<std::string> &comparison_csv_data);
 
+    // Projects each candidate rotation of base_dimple_image in the search
+    // space and scores it against target_image in the same pass.  Only the
+    // angles, pixel counts and scores are kept in output_candidates.
+    // Returns the index within output_candidates that has the best comparison.
+    // Returns -1 on failure.
+    static int ScoreCandidateAngles(const cv::Mat &base_dimple_image,
+                                    const cv::Mat &target_image,
+                                    const RotationSearchSpace &search_space,
+                                    const GolfBall &ball,
+                                    std::vector<RotationCandidate> &output_candidates,
+                                    std::vector<std::string> &comparison_csv_data);
+
+    // Returns the index of the candidate with the best score once candidates
+    // that examined relatively few pixels have been penalized
+    static int SelectBestRotationCandidate(const RotationCandidateTable &candidates);
+    static int SelectBestRotationCandidate(const std::vector<RotationCandidate> &candidates);
+
+    // Coarse-to-fine version of FindBestRotationCandidate that searches
+    // search_space on downsampled dimple images and then refines only the best
+    // few candidates at each higher resolution.  The candidates of the final,
+    // full-resolution level are returned in output_candidates, and
+    // final_increments is set to the angular step used at that level so that
+    // the caller can size its fine search window.
+    static int FindBestRotationCandidatePyramid(const cv::Mat &base_dimple_image,
+                                                const cv::Mat &target_image,
+                                                const RotationSearchSpace &search_space,
+                                                const GolfBall &ball,
+                                                std::vector<RotationCandidate> &output_candidates,
+                                                std::vector<std::string> &comparison_csv_data,
+                                                cv::Vec3i &final_increments);
+
+    // Searches for the (fractional) rotation near start_rotation that best
+    // turns base_dimple_image into target_image using a Nelder-Mead simplex.
+    // The initial simplex extends initial_step degrees along each axis.
+    // Candidates are ranked with the same low-count penalty as the grid
+    // search, relative to reference_pixels_examined.  Each evaluation is
+    // added to comparison_csv_data.  Returns the number of evaluations.
+    static int OptimizeRotation(const cv::Mat &base_dimple_image,
+                                const cv::Mat &target_image,
+                                const GolfBall &ball,
+                                const cv::Vec3d &start_rotation,
+                                const cv::Vec3d &initial_step,
+                                double reference_pixels_examined,
+                                cv::Vec3d &best_rotation,
+                                std::vector<std::string> &comparison_csv_data);
+
+    // Sets prior_search_space to the narrowed coarse search window for the
+    // club (see kUseSpinSearchPrior).  The window is kept on the same angular
+    // grid as full_search_space.  Returns false (with prior_search_space set
+    // to the full search space) if there is no useful prior.
+    static bool GetSpinPriorSearchSpace(const RotationSearchSpace &full_search_space,
+                                        GolfSimClubs::GsClubType club_type,
+                                        RotationSearchSpace &prior_search_space);
+
+    // Remembers a (raw, search-space) spin result for the club's prior
+    static void RecordSpinPriorResult(GolfSimClubs::GsClubType club_type,
+                                      const cv::Vec3d &rotation_degrees);
+
+    static void ClearSpinPriorHistory();
+
+    // Combines per-pair rotations (each measured over the corresponding
+    // interval) into a single rotation over fused_interval_uS.  Pairs whose
+    // rate is more than max_rpm_deviation from the median rate on any axis
+    // are discarded, and the rest are weighted by the square of their
+    // interval, as the angle error of each pair is roughly constant and so
+    // its rate error shrinks with time.  Returns false if fewer than
+    // min_consistent_pairs pairs are left.
+    static bool FuseSpinPairRotations(const std::vector<cv::Vec3d> &pair_rotations,
+                                      const std::vector<double> &pair_intervals_uS,
+                                      double max_rpm_deviation,
+                                      int min_consistent_pairs,
+                                      cv::Vec3d &fused_rotation,
+                                      double &fused_interval_uS);
+
+    // Reduces a 0/255/kPixelIgnoreValue dimple image by an integer factor.
+    // Each output pixel is a majority vote of the valid pixels it covers, and
+    // is only valid if most of the covered pixels were.
+    static cv::Mat DownsampleDimpleImage(const cv::Mat &dimple_image, int factor);
+
     static cv::Vec2i CompareRotationImage(const cv::Mat &img1,
                                           const cv::Mat &img2,
                                           const int index = 0);
@@ -321,6 +639,14 @@ class BallImageProc
                                 const cv::Vec3i rotation,
                                 cv::Mat &outputGrayImg);
 
+    // If prior_binary_threshold < 0, then there is no prior threshold and a new
+    // one will be determined and returns
+    // in the calibrated_binary_threshold variable.
+    static cv::Mat ApplyGaborFilterToBall(const cv::Mat &img,
+                                          const GolfBall &ball,
+                                          float &calibrated_binary_threshold,
+                                          float prior_binary_threshold = -1);
+
     static bool RemoveSmallestConcentricCircles(std::vector<cv::Vec3f> &circles);
 
     // Img would be a constant reference, but we need to perform sub-imaging on
@@ -342,10 +668,30 @@ class BallImageProc
                                      const cv::Scalar input_upperHsv,
                                      double wideningAmount = 0.0);
 
+    // Same as GetColorMaskImage on the HSV version of bgrImage, except that
+    // colors are quantized to the bins of a ColorMaskLut.  The table is only
+    // rebuilt when the ball's HSV range changes.
+    cv::Mat GetColorMaskImageFromBgr(const cv::Mat &bgrImage, const GolfBall &ball);
+
     bool PreProcessStrobedImage(cv::Mat &search_image, BallSearchMode search_mode);
 
   private:
 
+    ColorMaskLut color_mask_lut_;
+
+    // Re-used by each GetBall call when using the fused preprocessing
+    cv::Mat search_image_buffer_;
+
+    // True if the strobed modes should use HOUGH_GRADIENT_ALT
+    bool UseAltHoughAlgorithm() const;
+
+    // True if search_cancelled_ is set and has been signalled
+    bool SearchCancelled() const;
+
+    // Returns the color mask table for the ball's color, building it first
+    // if necessary
+    const ColorMaskLut &GetColorMaskLut(const GolfBall &ball);
+
     // When we create a candidate ball list, the elements of that list include
     // not only
     // the ball, but also the ball identifier(e.g., 1, 2...),
@@ -398,14 +744,6 @@ class BallImageProc
                                   cv::Mat &filtered_image,
                                   const cv::Mat &mask);
 
-    // If prior_binary_threshold < 0, then there is no prior threshold and a new
-    // one will be determined and returns
-    // in the calibrated_binary_threshold variable.
-    static cv::Mat ApplyGaborFilterToBall(const cv::Mat &img,
-                                          const GolfBall &ball,
-                                          float &calibrated_binary_threshold,
-                                          float prior_binary_threshold = -1);
-
     // Applies the gabor filter with the specified parameters and returns the
     // final image and white percentage
     static cv::Mat ApplyTestGaborFilter(const cv::Mat &img_f32,
@@ -421,10 +759,91 @@ class BallImageProc
     static cv::Mat CreateGaborKernel(int ks, double sig, double th, double lm, double gm,
                                      double ps);
 
+    // Returns the (cached) Gabor kernels for every filter angle.  Thread-safe.
+    static std::shared_ptr<const std::vector<cv::Mat> > GetGaborKernelBank(int kernel_size,
+                                                                           double sig,
+                                                                           double lm,
+                                                                           double ps,
+                                                                           double gm);
+
+    // Returns the 0-255 maximum response over the whole kernel bank.  This is
+    // independent of the binary threshold.
+    static cv::Mat ComputeGaborResponse(const cv::Mat &img_f32,
+                                        const int kernel_size,
+                                        double sig,
+                                        double lm,
+                                        double ps,
+                                        double gm);
+
+    // Thresholds the response from ComputeGaborResponse to 0 or 255
+    static cv::Mat ThresholdGaborResponse(const cv::Mat &response,
+                                          float binary_threshold,
+                                          int &white_percent);
+
     static cv::Mat Project2dImageTo3dBall(const cv::Mat &image_gray,
                                           const GolfBall &ball,
                                           const cv::Vec3i &rotation_angles_degrees);
 
+    // Same result as Project2dImageTo3dBall, but each pixel is just rotated by
+    // a single 3x3 matrix applied to the pre-computed unit-sphere table
+    static cv::Mat Project2dImageTo3dBallUsingTable(const cv::Mat &image_gray,
+                                                    const SphereProjectionTable &table,
+                                                    const cv::Vec3i &rotation_angles_degrees);
+
+    // Returns the (possibly cached) projection table for the image size and
+    // ball geometry.  Thread-safe.
+    static std::shared_ptr<const SphereProjectionTable> GetSphereProjectionTable(
+        const cv::Mat &image_gray,
+        const GolfBall &ball);
+
+    // Projects image_gray (rotated) directly into a packed bitplane image
+    // without creating the intermediate CV_32SC2 3D image
+    static void ProjectToBitplaneImage(const cv::Mat &image_gray,
+                                       const SphereProjectionTable &table,
+                                       const cv::Vec3d &rotation_angles_degrees,
+                                       BitplaneImage &projected);
+
+    // Searches the rotations in search_space for the one that best turns
+    // base_dimple_image into target_image, using either the streaming or the
+    // materialized-candidate approach.  Returns the index of the best
+    // candidate in output_candidates, or -1 on failure.
+    static int FindBestRotationCandidate(const cv::Mat &base_dimple_image,
+                                         const cv::Mat &target_image,
+                                         const RotationSearchSpace &search_space,
+                                         const GolfBall &ball,
+                                         std::vector<RotationCandidate> &output_candidates,
+                                         std::vector<std::string> &comparison_csv_data);
+
+    // Runs the coarse search over search_space, using the pyramid if it is
+    // enabled.  coarse_increments is set to the angular step of the result.
+    static int FindBestCoarseRotationCandidate(const cv::Mat &base_dimple_image,
+                                               const cv::Mat &target_image,
+                                               const RotationSearchSpace &search_space,
+                                               const GolfBall &ball,
+                                               std::vector<RotationCandidate> &output_candidates,
+                                               std::vector<std::string> &comparison_csv_data,
+                                               cv::Vec3i &coarse_increments);
+
+    // True if the best coarse result from a prior-narrowed search can be
+    // trusted, i.e., it scored well enough and is not at a narrowed edge
+    static bool IsSpinPriorResultAcceptable(const RotationCandidate &best,
+                                            const RotationSearchSpace &prior_search_space,
+                                            const RotationSearchSpace &full_search_space);
+
+    // Projects and scores each of the candidates (whose angles must already be
+    // set) without keeping any of the candidate images.  If
+    // allow_early_termination is true, candidates that cannot be the best one
+    // may be left with only an upper bound on their score.
+    static void ScoreRotationCandidates(const cv::Mat &base_dimple_image,
+                                        const cv::Mat &target_image,
+                                        const GolfBall &ball,
+                                        RotationCandidateTable &candidates,
+                                        bool allow_early_termination = true);
+
+    // The combined rotation matrix that is equivalent to the sequential X, Y
+    // and then Z-axis rotations performed by the projectionOp
+    static cv::Matx33d GetBallRotationMatrix(const cv::Vec3d &rotation_angles_degrees);
+
     static void Unproject3dBallTo2dImage(const cv::Mat &src3D,
                                          cv::Mat &destination_image_gray,
                                          const GolfBall &ball);
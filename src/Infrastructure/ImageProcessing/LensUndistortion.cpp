@@ -0,0 +1,51 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <opencv4/opencv2/calib3d.hpp>
+
+#include "Infrastructure/ImageProcessing/CircleRefiner.h"
+#include "Infrastructure/ImageProcessing/LensUndistortion.h"
+
+namespace PiTrac
+{
+bool LensUndistortion::UndistortCircle(const cv::Vec3f &distorted_circle,
+                                       const cv::Mat &calibration_matrix,
+                                       const cv::Mat &distortion_vector,
+                                       cv::Vec3f &undistorted_circle,
+                                       int number_of_points)
+{
+    if (distorted_circle[2] <= 0.0f || number_of_points < 3)
+    {
+        return false;
+    }
+
+    std::vector<cv::Point2f> distorted_points;
+    distorted_points.reserve(number_of_points);
+
+    for (int i = 0; i < number_of_points; i++)
+    {
+        double angle = 2.0 * CV_PI * i / number_of_points;
+        distorted_points.emplace_back(
+            (float)(distorted_circle[0] + distorted_circle[2] * std::cos(angle)),
+            (float)(distorted_circle[1] + distorted_circle[2] * std::sin(angle)));
+    }
+
+    // Giving the calibration matrix as the new projection matrix returns the
+    // points in pixels, the same as cv::initUndistortRectifyMap does for the
+    // undistorted image
+    std::vector<cv::Point2f> undistorted_points;
+    cv::undistortPoints(distorted_points,
+                        undistorted_points,
+                        calibration_matrix,
+                        distortion_vector,
+                        cv::noArray(),
+                        calibration_matrix);
+
+    return CircleRefiner::FitCircleAlgebraic(undistorted_points, undistorted_circle);
+}
+}
@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// Removes lens distortion from circle geometry found in a raw (distorted)
+// camera image.  When only a ball's center and radius are needed, this is
+// much cheaper than undistorting the whole image before looking for the ball.
+
+#ifndef PI_TRAC_LENS_UNDISTORTION_H
+#define PI_TRAC_LENS_UNDISTORTION_H
+
+#include <opencv4/opencv2/core.hpp>
+
+
+namespace PiTrac
+{
+class LensUndistortion
+{
+  public:
+
+    // Sets undistorted_circle to where distorted_circle (x, y, radius) would
+    // be in the image after it was undistorted with the same calibration
+    // (see UndistortionMapCache).  number_of_points points around the circle
+    // are undistorted, and a circle is fit to them, so that a radius that the
+    // distortion has stretched or squeezed is also corrected.
+    // Returns false if no circle could be fit.
+    static bool UndistortCircle(const cv::Vec3f &distorted_circle,
+                                const cv::Mat &calibration_matrix,
+                                const cv::Mat &distortion_vector,
+                                cv::Vec3f &undistorted_circle,
+                                int number_of_points = 32);
+};
+}
+
+#endif // PI_TRAC_LENS_UNDISTORTION_H
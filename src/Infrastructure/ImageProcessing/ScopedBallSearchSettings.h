@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// Changes the ball search settings of a BallImageProc (its color mask and
+// ball radius limits) for a search of a sub-image, and puts the previous
+// settings back when it goes out of scope, including if the search throws.
+// GetBall only builds a color mask if it does not already have one, and that
+// mask has to be the same size as the image being searched, so a sub-image
+// search starts without one.
+
+#ifndef PI_TRAC_SCOPED_BALL_SEARCH_SETTINGS_H
+#define PI_TRAC_SCOPED_BALL_SEARCH_SETTINGS_H
+
+#include <algorithm>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+namespace PiTrac
+{
+class ScopedBallSearchSettings
+{
+  public:
+
+    // The arguments are the searcher's color_mask_image_, min_ball_radius_
+    // and max_ball_radius_.  The maximum radius is kept above the minimum.
+    ScopedBallSearchSettings(cv::Mat &color_mask_image,
+                             int &min_ball_radius,
+                             int &max_ball_radius,
+                             int search_min_ball_radius,
+                             int search_max_ball_radius)
+        : color_mask_image_(color_mask_image),
+          min_ball_radius_(min_ball_radius),
+          max_ball_radius_(max_ball_radius),
+          saved_color_mask_image_(color_mask_image),
+          saved_min_ball_radius_(min_ball_radius),
+          saved_max_ball_radius_(max_ball_radius)
+    {
+        color_mask_image_ = cv::Mat();
+        min_ball_radius_ = std::max(1, search_min_ball_radius);
+        max_ball_radius_ = std::max(min_ball_radius_ + 1, search_max_ball_radius);
+    }
+
+    ~ScopedBallSearchSettings()
+    {
+        color_mask_image_ = saved_color_mask_image_;
+        min_ball_radius_ = saved_min_ball_radius_;
+        max_ball_radius_ = saved_max_ball_radius_;
+    }
+
+    ScopedBallSearchSettings(const ScopedBallSearchSettings &) = delete;
+    ScopedBallSearchSettings &operator=(const ScopedBallSearchSettings &) = delete;
+
+  private:
+
+    cv::Mat &color_mask_image_;
+    int &min_ball_radius_;
+    int &max_ball_radius_;
+
+    cv::Mat saved_color_mask_image_;
+    int saved_min_ball_radius_;
+    int saved_max_ball_radius_;
+};
+}
+
+#endif // PI_TRAC_SCOPED_BALL_SEARCH_SETTINGS_H
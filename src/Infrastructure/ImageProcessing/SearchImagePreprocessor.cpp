@@ -0,0 +1,109 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <algorithm>
+
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include "Infrastructure/ImageProcessing/SearchImagePreprocessor.h"
+
+namespace PiTrac
+{
+void SearchImagePreprocessor::Process(const cv::Mat &bgr_image,
+                                      int blur_size,
+                                      const ColorMaskLut *color_mask_lut,
+                                      cv::Mat &search_image,
+                                      cv::Mat &color_mask)
+{
+    StripMaskFunction strip_mask_function;
+
+    if (color_mask_lut != nullptr)
+    {
+        strip_mask_function = [color_mask_lut](const cv::Mat &bgr_strip, cv::Mat &mask_strip)
+            {
+                color_mask_lut->Apply(bgr_strip, mask_strip);
+            };
+    }
+
+    ProcessStrips(bgr_image, blur_size, strip_mask_function, search_image, color_mask);
+}
+
+void SearchImagePreprocessor::ProcessWithHsvMask(const cv::Mat &bgr_image,
+                                                 int blur_size,
+                                                 const ColorMaskLut::HsvMaskFunction &hsv_mask_function,
+                                                 cv::Mat &search_image,
+                                                 cv::Mat &color_mask)
+{
+    CV_Assert(hsv_mask_function);
+
+    StripMaskFunction strip_mask_function =
+        [&hsv_mask_function](const cv::Mat &bgr_strip, cv::Mat &mask_strip)
+        {
+            // Kept for the life of the thread, so only allocated once
+            thread_local cv::Mat hsv_strip;
+
+            cv::cvtColor(bgr_strip, hsv_strip, cv::COLOR_BGR2HSV);
+
+            // mask_strip is a view into the full mask, so copy into it rather
+            // than re-assigning it
+            cv::Mat strip_mask = hsv_mask_function(hsv_strip);
+            CV_Assert(strip_mask.type() == CV_8UC1 && strip_mask.size() == mask_strip.size());
+            strip_mask.copyTo(mask_strip);
+        };
+
+    ProcessStrips(bgr_image, blur_size, strip_mask_function, search_image, color_mask);
+}
+
+void SearchImagePreprocessor::ProcessStrips(const cv::Mat &bgr_image,
+                                            int blur_size,
+                                            const StripMaskFunction &strip_mask_function,
+                                            cv::Mat &search_image,
+                                            cv::Mat &color_mask)
+{
+    CV_Assert(bgr_image.type() == CV_8UC3);
+
+    search_image.create(bgr_image.size(), CV_8UC1);
+
+    if (strip_mask_function)
+    {
+        color_mask.create(bgr_image.size(), CV_8UC1);
+    }
+
+    const int number_of_strips = (bgr_image.rows + kStripRows - 1) / kStripRows;
+
+    cv::parallel_for_(cv::Range(0, number_of_strips), [&](const cv::Range &range)
+        {
+            // Kept for the life of the thread, so only allocated once
+            thread_local cv::Mat blurred_strip;
+
+            for (int strip = range.start; strip < range.end; strip++)
+            {
+                int first_row = strip * kStripRows;
+                int end_row = std::min(first_row + kStripRows, bgr_image.rows);
+
+                cv::Mat bgr_strip = bgr_image.rowRange(first_row, end_row);
+                cv::Mat gray_strip = search_image.rowRange(first_row, end_row);
+
+                if (blur_size > 0)
+                {
+                    // The strip is a sub-matrix, so the blur reads the rows
+                    // just above and below it from the full image.  The
+                    // result is the same as blurring the whole image.
+                    cv::GaussianBlur(bgr_strip, blurred_strip, cv::Size(blur_size, blur_size), 0);
+                    bgr_strip = blurred_strip;
+                }
+
+                cv::cvtColor(bgr_strip, gray_strip, cv::COLOR_BGR2GRAY);
+
+                if (strip_mask_function)
+                {
+                    cv::Mat mask_strip = color_mask.rowRange(first_row, end_row);
+                    strip_mask_function(bgr_strip, mask_strip);
+                    cv::bitwise_and(gray_strip, mask_strip, gray_strip);
+                }
+            }
+        });
+}
+}
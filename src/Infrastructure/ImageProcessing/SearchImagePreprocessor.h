@@ -0,0 +1,72 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// Makes the gray search image that GetBall looks for balls in.  Done as a
+// chain of whole-image operations, the blur, gray conversion and color
+// masking each read and write (and usually allocate) a full frame.  Here they
+// are all done on one strip of rows at a time, while the strip is still in
+// the cache, and the intermediate results go into per-thread scratch buffers
+// that are kept from call to call.
+
+#ifndef PI_TRAC_SEARCH_IMAGE_PREPROCESSOR_H
+#define PI_TRAC_SEARCH_IMAGE_PREPROCESSOR_H
+
+#include <functional>
+
+#include <opencv4/opencv2/core.hpp>
+
+#include "Infrastructure/ImageProcessing/ColorMaskLut.h"
+
+
+namespace PiTrac
+{
+class SearchImagePreprocessor
+{
+  public:
+
+    // Number of image rows processed together
+    static const int kStripRows = 16;
+
+    // Sets search_image (CV_8UC1) from bgr_image (CV_8UC3) by:
+    //   1 - a blur_size x blur_size Gaussian blur (skipped if blur_size is 0)
+    //   2 - conversion to gray
+    //   3 - if color_mask_lut is not null, an AND with the color mask from
+    //       the table, which is also returned in color_mask
+    // The result is the same as doing each step over the whole image.
+    // search_image and color_mask are only re-allocated if they are not
+    // already the right size.
+    static void Process(const cv::Mat &bgr_image,
+                        int blur_size,
+                        const ColorMaskLut *color_mask_lut,
+                        cv::Mat &search_image,
+                        cv::Mat &color_mask);
+
+    // Same as Process, except that the color mask is made exactly, by
+    // running hsv_mask_function on the HSV version of each blurred strip
+    // rather than by a table lookup.  The masking is done pixel by pixel, so
+    // this is the same as running hsv_mask_function on the whole image.
+    static void ProcessWithHsvMask(const cv::Mat &bgr_image,
+                                   int blur_size,
+                                   const ColorMaskLut::HsvMaskFunction &hsv_mask_function,
+                                   cv::Mat &search_image,
+                                   cv::Mat &color_mask);
+
+  private:
+
+    // Sets mask_strip (CV_8UC1) from bgr_strip (CV_8UC3)
+    using StripMaskFunction = std::function<void (const cv::Mat &bgr_strip,
+                                                  cv::Mat &mask_strip)>;
+
+    // The strip loop for both of the above.  No masking is done if
+    // strip_mask_function is empty.
+    static void ProcessStrips(const cv::Mat &bgr_image,
+                              int blur_size,
+                              const StripMaskFunction &strip_mask_function,
+                              cv::Mat &search_image,
+                              cv::Mat &color_mask);
+};
+}
+
+#endif // PI_TRAC_SEARCH_IMAGE_PREPROCESSOR_H
@@ -0,0 +1,286 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+
+#include <opencv4/opencv2/calib3d.hpp>
+#include <opencv4/opencv2/imgproc.hpp>
+
+#include "Infrastructure/ImageProcessing/UndistortionMapCache.h"
+
+namespace PiTrac
+{
+// Start of each persisted map file, followed by a format version
+static const char kMapFileMagic[4] = { 'P', 'T', 'U', 'M' };
+static const int32_t kMapFileVersion = 1;
+
+static cv::Mat AsDoubles(const cv::Mat &values)
+{
+    cv::Mat doubles;
+    values.reshape(1, 1).convertTo(doubles, CV_64F);
+    return doubles;
+}
+
+int UndistortionMapCache::Map2Type(int map1_type)
+{
+    return map1_type == CV_32FC1 ? CV_32FC1 : CV_16UC1;
+}
+
+bool UndistortionMapCache::IsFor(const Entry &entry,
+                                 const cv::Mat &calibration_matrix,
+                                 const cv::Mat &distortion_vector)
+{
+    if (entry.calibration_matrix.total() != calibration_matrix.total() ||
+        entry.distortion_vector.total() != distortion_vector.total())
+    {
+        return false;
+    }
+
+    return cv::norm(entry.calibration_matrix, AsDoubles(calibration_matrix),
+                    cv::NORM_INF) == 0.0 &&
+           cv::norm(entry.distortion_vector, AsDoubles(distortion_vector),
+                    cv::NORM_INF) == 0.0;
+}
+
+void UndistortionMapCache::GetMaps(int camera_number,
+                                   const cv::Mat &calibration_matrix,
+                                   const cv::Mat &distortion_vector,
+                                   const cv::Size &image_size,
+                                   cv::Mat &map1,
+                                   cv::Mat &map2,
+                                   int map1_type)
+{
+    CV_Assert(map1_type == CV_16SC2 || map1_type == CV_32FC1);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    Entry *entry = nullptr;
+
+    for (Entry &e : entries_)
+    {
+        if (e.camera_number == camera_number && e.image_size == image_size &&
+            e.map1_type == map1_type)
+        {
+            entry = &e;
+            break;
+        }
+    }
+
+    if (entry != nullptr && IsFor(*entry, calibration_matrix, distortion_vector))
+    {
+        map1 = entry->map1;
+        map2 = entry->map2;
+        return;
+    }
+
+    // Either new, or the calibration has changed since the maps were built
+    if (entry == nullptr)
+    {
+        entries_.emplace_back();
+        entry = &entries_.back();
+    }
+
+    entry->camera_number = camera_number;
+    entry->image_size = image_size;
+    entry->map1_type = map1_type;
+    entry->calibration_matrix = AsDoubles(calibration_matrix);
+    entry->distortion_vector = AsDoubles(distortion_vector);
+
+    // Release (rather than overwrite) the old maps, as callers may still be
+    // using them
+    entry->map1 = cv::Mat();
+    entry->map2 = cv::Mat();
+
+    if (!ReadMaps(*entry))
+    {
+        cv::initUndistortRectifyMap(calibration_matrix,
+                                    distortion_vector,
+                                    cv::Mat(),
+                                    calibration_matrix,
+                                    image_size,
+                                    map1_type,
+                                    entry->map1,
+                                    entry->map2);
+        number_of_builds_++;
+
+        WriteMaps(*entry);
+    }
+
+    map1 = entry->map1;
+    map2 = entry->map2;
+}
+
+void UndistortionMapCache::Undistort(const cv::Mat &image,
+                                     int camera_number,
+                                     const cv::Mat &calibration_matrix,
+                                     const cv::Mat &distortion_vector,
+                                     cv::Mat &undistorted_image,
+                                     int map1_type)
+{
+    cv::Mat map1;
+    cv::Mat map2;
+    GetMaps(camera_number, calibration_matrix, distortion_vector, image.size(), map1, map2,
+            map1_type);
+
+    cv::remap(image, undistorted_image, map1, map2, cv::INTER_LINEAR);
+}
+
+void UndistortionMapCache::SetPersistenceDirectory(const std::string &directory)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    persistence_directory_ = directory;
+
+    if (!persistence_directory_.empty() && persistence_directory_.back() != '/')
+    {
+        persistence_directory_ += '/';
+    }
+}
+
+void UndistortionMapCache::Clear()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+}
+
+int UndistortionMapCache::NumberOfBuilds() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return number_of_builds_;
+}
+
+std::string UndistortionMapCache::PersistenceFileName(const Entry &entry) const
+{
+    return persistence_directory_ + "undistortion_map_camera" +
+           std::to_string(entry.camera_number) + "_" + std::to_string(entry.image_size.width) +
+           "x" + std::to_string(entry.image_size.height) +
+           (entry.map1_type == CV_32FC1 ? "_float" : "") + ".bin";
+}
+
+// The file is the magic and version, the image size, the number and values of
+// the calibration and distortion coefficients that the maps were built from,
+// and then the raw map data.  Maps built from other coefficients are ignored.
+bool UndistortionMapCache::ReadMaps(Entry &entry) const
+{
+    if (persistence_directory_.empty())
+    {
+        return false;
+    }
+
+    std::ifstream file(PersistenceFileName(entry), std::ios::binary);
+
+    if (!file)
+    {
+        return false;
+    }
+
+    char magic[sizeof(kMapFileMagic)];
+    int32_t version = 0;
+    int32_t width = 0;
+    int32_t height = 0;
+
+    file.read(magic, sizeof(magic));
+    file.read(reinterpret_cast<char *>(&version), sizeof(version));
+    file.read(reinterpret_cast<char *>(&width), sizeof(width));
+    file.read(reinterpret_cast<char *>(&height), sizeof(height));
+
+    if (!file || !std::equal(magic, magic + sizeof(magic), kMapFileMagic) ||
+        version != kMapFileVersion || width != entry.image_size.width ||
+        height != entry.image_size.height)
+    {
+        return false;
+    }
+
+    for (const cv::Mat *coefficients : { &entry.calibration_matrix, &entry.distortion_vector })
+    {
+        int32_t count = 0;
+        file.read(reinterpret_cast<char *>(&count), sizeof(count));
+
+        if (!file || count != (int32_t)coefficients->total())
+        {
+            return false;
+        }
+
+        std::vector<double> values(count);
+        file.read(reinterpret_cast<char *>(values.data()), count * sizeof(double));
+
+        if (!file || cv::norm(*coefficients, cv::Mat(values).reshape(1, 1), cv::NORM_INF) != 0.0)
+        {
+            return false;
+        }
+    }
+
+    cv::Mat map1(entry.image_size, entry.map1_type);
+    cv::Mat map2(entry.image_size, Map2Type(entry.map1_type));
+
+    file.read(reinterpret_cast<char *>(map1.data), map1.total() * map1.elemSize());
+    file.read(reinterpret_cast<char *>(map2.data), map2.total() * map2.elemSize());
+
+    if (!file)
+    {
+        return false;
+    }
+
+    entry.map1 = map1;
+    entry.map2 = map2;
+
+    return true;
+}
+
+bool UndistortionMapCache::WriteMaps(const Entry &entry) const
+{
+    if (persistence_directory_.empty())
+    {
+        return false;
+    }
+
+    // Written to a temporary file first, so that a partly-written file is
+    // never read back
+    std::string file_name = PersistenceFileName(entry);
+    std::string temporary_file_name = file_name + ".tmp";
+
+    {
+        std::ofstream file(temporary_file_name, std::ios::binary | std::ios::trunc);
+
+        if (!file)
+        {
+            return false;
+        }
+
+        int32_t width = entry.image_size.width;
+        int32_t height = entry.image_size.height;
+
+        file.write(kMapFileMagic, sizeof(kMapFileMagic));
+        file.write(reinterpret_cast<const char *>(&kMapFileVersion), sizeof(kMapFileVersion));
+        file.write(reinterpret_cast<const char *>(&width), sizeof(width));
+        file.write(reinterpret_cast<const char *>(&height), sizeof(height));
+
+        for (const cv::Mat *coefficients : { &entry.calibration_matrix, &entry.distortion_vector })
+        {
+            int32_t count = (int32_t)coefficients->total();
+            file.write(reinterpret_cast<const char *>(&count), sizeof(count));
+            file.write(reinterpret_cast<const char *>(coefficients->ptr<double>()),
+                       count * sizeof(double));
+        }
+
+        // The maps are made by initUndistortRectifyMap, so are continuous
+        file.write(reinterpret_cast<const char *>(entry.map1.data),
+                   entry.map1.total() * entry.map1.elemSize());
+        file.write(reinterpret_cast<const char *>(entry.map2.data),
+                   entry.map2.total() * entry.map2.elemSize());
+
+        if (!file)
+        {
+            std::remove(temporary_file_name.c_str());
+            return false;
+        }
+    }
+
+    return std::rename(temporary_file_name.c_str(), file_name.c_str()) == 0;
+}
+}
@@ -0,0 +1,98 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// Keeps the lens undistortion maps for each camera.  Building the maps with
+// cv::initUndistortRectifyMap takes about as long as the cv::remap that uses
+// them, and they only change if the camera's resolution or calibration does.
+// By default the maps are kept in the fixed-point (CV_16SC2 + CV_16UC1) form,
+// which is also faster to remap with than float maps.  Float (CV_32FC1) maps
+// can be asked for where the full interpolation precision is wanted.
+// If a persistence directory is set, the maps are also written there, so that
+// a restart can read them back instead of building them again.
+
+#ifndef PI_TRAC_UNDISTORTION_MAP_CACHE_H
+#define PI_TRAC_UNDISTORTION_MAP_CACHE_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <opencv4/opencv2/core.hpp>
+
+
+namespace PiTrac
+{
+class UndistortionMapCache
+{
+  public:
+
+    // Sets map1 and map2 to the maps for the camera, building (or reading)
+    // them only if there are none yet for this image_size, map1_type,
+    // calibration_matrix and distortion_vector.  map1_type is either CV_16SC2
+    // (map2 is then CV_16UC1) or CV_32FC1 (map2 is then also CV_32FC1).  The
+    // returned maps stay valid even if the cache later replaces them.
+    void GetMaps(int camera_number,
+                 const cv::Mat &calibration_matrix,
+                 const cv::Mat &distortion_vector,
+                 const cv::Size &image_size,
+                 cv::Mat &map1,
+                 cv::Mat &map2,
+                 int map1_type = CV_16SC2);
+
+    // Sets undistorted_image to image with the camera's lens distortion
+    // removed, using maps of map1_type (see GetMaps)
+    void Undistort(const cv::Mat &image,
+                   int camera_number,
+                   const cv::Mat &calibration_matrix,
+                   const cv::Mat &distortion_vector,
+                   cv::Mat &undistorted_image,
+                   int map1_type = CV_16SC2);
+
+    // Maps are read from and written to this directory.  Empty (the default)
+    // means the maps are only kept in memory.
+    void SetPersistenceDirectory(const std::string &directory);
+
+    // Forgets all maps that are in memory
+    void Clear();
+
+    // Number of times maps had to be built, rather than found in memory or
+    // read from the persistence directory
+    int NumberOfBuilds() const;
+
+  private:
+
+    struct Entry
+    {
+        int camera_number = 0;
+        cv::Size image_size;
+        int map1_type = CV_16SC2;
+
+        // CV_64F copies, so that changes to the camera's calibration are
+        // noticed whatever type it is kept in
+        cv::Mat calibration_matrix;
+        cv::Mat distortion_vector;
+
+        cv::Mat map1;
+        cv::Mat map2;
+    };
+
+    static int Map2Type(int map1_type);
+
+    static bool IsFor(const Entry &entry,
+                      const cv::Mat &calibration_matrix,
+                      const cv::Mat &distortion_vector);
+
+    std::string PersistenceFileName(const Entry &entry) const;
+    bool ReadMaps(Entry &entry) const;
+    bool WriteMaps(const Entry &entry) const;
+
+    mutable std::mutex mutex_;
+    std::vector<Entry> entries_;
+    std::string persistence_directory_;
+    int number_of_builds_ = 0;
+};
+}
+
+#endif // PI_TRAC_UNDISTORTION_MAP_CACHE_H
@@ -0,0 +1,73 @@
+#include "Interfaces/Camera/GSCameraBase/FramePool.h"
+#include <algorithm>
+
+namespace PiTrac
+{
+void FramePool::reset(size_t initialFrames, size_t maxFrames, int rows, int cols, int type)
+{
+    clear();
+
+    rows_ = rows;
+    cols_ = cols;
+    type_ = type;
+    maxFrames_ = std::max(initialFrames, maxFrames);
+
+    frames_.reserve(maxFrames_);
+    for (size_t i = 0; i < initialFrames; ++i)
+    {
+        frames_.push_back(allocate());
+    }
+}
+
+cv::Mat FramePool::acquire()
+{
+    if (rows_ <= 0 || cols_ <= 0)
+    {
+        return cv::Mat();
+    }
+
+    // Start after the frame that was handed out last, so that the frames are
+    // used in turn and the oldest one is checked first
+    for (size_t i = 0; i < frames_.size(); ++i)
+    {
+        size_t index = (nextFrame_ + i) % frames_.size();
+
+        if (!isInUse(frames_[index]))
+        {
+            nextFrame_ = (index + 1) % frames_.size();
+            return frames_[index];
+        }
+    }
+
+    cv::Mat frame = allocate();
+
+    if (frames_.size() < maxFrames_)
+    {
+        frames_.push_back(frame);
+        nextFrame_ = 0;
+    }
+
+    return frame;
+}
+
+void FramePool::clear()
+{
+    frames_.clear();
+    nextFrame_ = 0;
+    allocationCount_ = 0;
+}
+
+bool FramePool::isInUse(const cv::Mat &frame)
+{
+    // The pool's own reference is the only one when the frame is free.  Only
+    // acquire() adds references to a free frame, so once it is seen to be
+    // free, it stays that way.
+    return CV_XADD(&frame.u->refcount, 0) > 1;
+}
+
+cv::Mat FramePool::allocate()
+{
+    ++allocationCount_;
+    return cv::Mat(rows_, cols_, type_);
+}
+} // namespace PiTrac
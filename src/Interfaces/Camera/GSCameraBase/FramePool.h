@@ -0,0 +1,89 @@
+#ifndef GS_FRAME_POOL_H
+#define GS_FRAME_POOL_H
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <vector>
+
+namespace PiTrac
+{
+/**
+ * @class FramePool
+ * @brief A set of preallocated frames that are reused from one camera frame
+ * to the next.
+ *
+ * Each frame is handed out as a cv::Mat that shares its data with the pool.
+ * cv::Mat reference counting then tells the pool when nobody else is using a
+ * frame any more, so the frame can be handed out again.  Once the pool has
+ * as many frames as the consumers hold on to at once, no more memory is
+ * allocated.
+ *
+ * acquire() must only be called from one thread (the camera's completion
+ * callback).  The frames it returns can be used and released from any
+ * thread.
+ */
+class FramePool
+{
+  public:
+
+    /**
+     * @brief Drops all frames and preallocates new ones.
+     *
+     * @param[in] initialFrames Number of frames to allocate now.
+     * @param[in] maxFrames     Most frames the pool will ever hold.  If all of
+     * them are in use, acquire() returns a frame that is not pooled.
+     * @param[in] rows          Frame height in pixels.
+     * @param[in] cols          Frame width in pixels.
+     * @param[in] type          OpenCV type of the frames, e.g. CV_8UC3.
+     */
+    void reset(size_t initialFrames, size_t maxFrames, int rows, int cols, int type);
+
+    /**
+     * @brief Returns a frame that nobody else is using.
+     *
+     * The contents of the frame are whatever was last written to it.
+     *
+     * @return A frame of the size and type given to reset(), or an empty Mat
+     * if the pool was never reset.
+     */
+    cv::Mat acquire();
+
+    /**
+     * @brief Drops all frames.  Frames that are still in use stay valid.
+     */
+    void clear();
+
+    /**
+     * @brief Number of frames that are pooled.
+     */
+    size_t size() const
+    {
+        return frames_.size();
+    }
+
+    /**
+     * @brief Number of frames allocated since the last reset(), including the
+     * preallocated ones.  Stops growing once the pool is large enough.
+     */
+    size_t allocationCount() const
+    {
+        return allocationCount_;
+    }
+
+  private:
+
+    static bool isInUse(const cv::Mat &frame);
+
+    cv::Mat allocate();
+
+    std::vector<cv::Mat> frames_;
+    size_t maxFrames_ = 0;
+    size_t nextFrame_ = 0;
+    size_t allocationCount_ = 0;
+    int rows_ = 0;
+    int cols_ = 0;
+    int type_ = 0;
+};
+} // namespace PiTrac
+
+#endif // GS_FRAME_POOL_H
@@ -0,0 +1,214 @@
+#include "Interfaces/Camera/GSCameraBase/FrameRing.h"
+#include <algorithm>
+
+namespace PiTrac
+{
+FrameRing::FrameRing(size_t capacity)
+{
+    reset(capacity);
+}
+
+void FrameRing::reset(size_t capacity)
+{
+    // Two more entries than slots: one for the producer to fill next, and one
+    // that the consumer may be reading
+    capacity_ = std::clamp(capacity, (size_t)1, (size_t)(kIndexMask - 2));
+    const size_t numberOfEntries = capacity_ + 2;
+
+    entries_.assign(numberOfEntries, cv::Mat());
+
+    slots_ = std::make_unique<std::atomic<uint64_t>[]>(capacity_);
+    for (size_t i = 0; i < capacity_; ++i)
+    {
+        slots_[i].store(kEmptySlot, std::memory_order_relaxed);
+    }
+
+    head_.store(0, std::memory_order_relaxed);
+    tail_.store(0, std::memory_order_relaxed);
+
+    returnedEntries_.assign(numberOfEntries, 0);
+    returnedHead_.store(0, std::memory_order_relaxed);
+    returnedTail_.store(0, std::memory_order_relaxed);
+
+    droppedFrames_.store(0, std::memory_order_relaxed);
+
+    spareEntry_ = 0;
+    for (size_t entry = 1; entry < numberOfEntries; ++entry)
+    {
+        returnEntry(entry);
+    }
+}
+
+void FrameRing::push(const cv::Mat &frame)
+{
+    // The producer only lacks a spare entry if the returned-entry queue was
+    // found empty at the end of an earlier push.  With no entry to put the
+    // frame in, the frame is dropped.
+    if (spareEntry_ == kNoEntry && !takeReturnedEntry(spareEntry_))
+    {
+        droppedFrames_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+
+    entries_[spareEntry_] = frame;
+
+    // The exchange publishes the entry.  If the slot still held a frame, it
+    // is the oldest one and has not been read, so it is dropped and its entry
+    // filled next time.
+    uint64_t previous = slots_[head % capacity_].exchange(makeSlotValue(head, spareEntry_),
+                                                           std::memory_order_acq_rel);
+    head_.store(head + 1, std::memory_order_release);
+
+    if (previous != kEmptySlot)
+    {
+        spareEntry_ = previous & kIndexMask;
+        entries_[spareEntry_].release();
+        return;
+    }
+
+    // The consumer took the frame that was in the slot.  Counting the
+    // entries shows the queue is never empty here: at most capacity_ are in
+    // slots and at most one is being read.  That is not relied on, though.
+    if (!takeReturnedEntry(spareEntry_))
+    {
+        spareEntry_ = kNoEntry;
+    }
+}
+
+bool FrameRing::takeReturnedEntry(uint64_t &entry)
+{
+    const uint64_t returnedTail = returnedTail_.load(std::memory_order_relaxed);
+
+    // Acquire, so that the entry read below is the one the consumer wrote
+    if (returnedTail == returnedHead_.load(std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    entry = returnedEntries_[returnedTail % returnedEntries_.size()];
+    returnedTail_.store(returnedTail + 1, std::memory_order_release);
+
+    return true;
+}
+
+bool FrameRing::take(uint64_t sequence, cv::Mat &frame)
+{
+    std::atomic<uint64_t> &slot = slots_[sequence % capacity_];
+
+    // The sequence number in the slot value means a frame that has been
+    // overwritten is never mistaken for the newer one in its slot
+    uint64_t value = slot.load(std::memory_order_acquire);
+    if (value == kEmptySlot || (value >> kIndexBits) != sequence)
+    {
+        return false;
+    }
+
+    // Fails only if the producer overwrote the frame just now
+    if (!slot.compare_exchange_strong(value, kEmptySlot, std::memory_order_acq_rel,
+                                      std::memory_order_acquire))
+    {
+        return false;
+    }
+
+    // Moved rather than copied, so the entry no longer holds on to the frame
+    const uint64_t entry = value & kIndexMask;
+    frame = std::move(entries_[entry]);
+    returnEntry(entry);
+
+    return true;
+}
+
+void FrameRing::returnEntry(uint64_t entry)
+{
+    const uint64_t returnedHead = returnedHead_.load(std::memory_order_relaxed);
+    returnedEntries_[returnedHead % returnedEntries_.size()] = entry;
+    returnedHead_.store(returnedHead + 1, std::memory_order_release);
+}
+
+cv::Mat FrameRing::popLatest()
+{
+    cv::Mat latest;
+
+    // The newest frame can only be lost if the producer has since pushed a
+    // whole ring of newer frames, so one retry with the new head is enough in
+    // practice, and keeps this bounded
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (int attempt = 0; attempt < 2 && latest.empty(); ++attempt)
+    {
+        if (attempt > 0)
+        {
+            head = head_.load(std::memory_order_acquire);
+        }
+
+        if (head == tail_.load(std::memory_order_relaxed))
+        {
+            return latest;
+        }
+
+        take(head - 1, latest);
+    }
+
+    // Release the older frames now, rather than when they are overwritten, so
+    // that whatever they were allocated from can reuse them.  Frames pushed
+    // since are kept.
+    discardBefore(head);
+
+    return latest;
+}
+
+size_t FrameRing::drain(std::vector<cv::Mat> &frames)
+{
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+    // Frames older than one ring back have been overwritten
+    const uint64_t oldest = std::max(tail, head > capacity_ ? head - capacity_ : 0);
+
+    size_t count = 0;
+    for (uint64_t sequence = oldest; sequence < head; ++sequence)
+    {
+        cv::Mat frame;
+        if (take(sequence, frame))
+        {
+            frames.push_back(std::move(frame));
+            ++count;
+        }
+    }
+
+    tail_.store(head, std::memory_order_relaxed);
+
+    return count;
+}
+
+size_t FrameRing::size() const
+{
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+
+    return (size_t)std::min(head - tail, (uint64_t)capacity_);
+}
+
+void FrameRing::clear()
+{
+    discardBefore(head_.load(std::memory_order_acquire));
+}
+
+void FrameRing::discardBefore(uint64_t head)
+{
+    const uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t oldest = std::max(tail, head > capacity_ ? head - capacity_ : 0);
+
+    cv::Mat frame;
+    for (uint64_t sequence = oldest; sequence < head; ++sequence)
+    {
+        if (take(sequence, frame))
+        {
+            frame.release();
+        }
+    }
+
+    tail_.store(head, std::memory_order_relaxed);
+}
+} // namespace PiTrac
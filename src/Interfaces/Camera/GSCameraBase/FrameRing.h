@@ -0,0 +1,163 @@
+#ifndef GS_FRAME_RING_H
+#define GS_FRAME_RING_H
+
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace PiTrac
+{
+/**
+ * @class FrameRing
+ * @brief A bounded, lock-free frame queue for one producer (the camera's
+ * completion callback) and one consumer.
+ *
+ * When the ring is full, pushing a frame overwrites the oldest one, so the
+ * producer never waits for the consumer.  Every operation finishes in a
+ * bounded number of steps.
+ *
+ * The frames themselves are kept in a fixed set of entries.  A slot of the
+ * ring holds the index of an entry, tagged with the frame's sequence number,
+ * and ownership of an entry moves between the producer and the consumer with
+ * a single atomic exchange or compare-exchange.  The consumer gives entries
+ * it has read back to the producer through a second (never full) queue.
+ */
+class FrameRing
+{
+  public:
+
+    /**
+     * @brief Constructs a ring that holds up to capacity frames.
+     */
+    explicit FrameRing(size_t capacity = 100);
+
+    /**
+     * @brief Drops all frames and changes the capacity.  Must not be called
+     * while frames are being pushed or read.
+     */
+    void reset(size_t capacity);
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    /**
+     * @brief Adds a frame, overwriting the oldest frame if the ring is full.
+     * Producer only.
+     *
+     * If the consumer has not yet given back any of the entries it has read,
+     * there may be no entry to hold the frame, in which case the frame is
+     * dropped (and counted in droppedFrames()).
+     */
+    void push(const cv::Mat &frame);
+
+    /**
+     * @brief Number of frames push() has dropped for lack of a free entry
+     * since the last reset().
+     */
+    uint64_t droppedFrames() const
+    {
+        return droppedFrames_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the newest frame and discards all older ones.  Consumer
+     * only.
+     *
+     * @return The newest frame, or an empty Mat if there are no frames.
+     */
+    cv::Mat popLatest();
+
+    /**
+     * @brief Appends all available frames to frames, oldest first.  Consumer
+     * only.
+     *
+     * @return The number of frames appended.
+     */
+    size_t drain(std::vector<cv::Mat> &frames);
+
+    /**
+     * @brief Number of frames that have not been read or overwritten.
+     */
+    size_t size() const;
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /**
+     * @brief Discards all frames.  Consumer only.
+     */
+    void clear();
+
+  private:
+
+    // A slot value is (sequence number << kIndexBits) | entry index
+    static constexpr int kIndexBits = 16;
+    static constexpr uint64_t kIndexMask = (1ULL << kIndexBits) - 1;
+    static constexpr uint64_t kEmptySlot = kIndexMask;
+
+    // spareEntry_ when the producer has no entry to fill
+    static constexpr uint64_t kNoEntry = kIndexMask;
+
+    static uint64_t makeSlotValue(uint64_t sequence, uint64_t entry)
+    {
+        return (sequence << kIndexBits) | entry;
+    }
+
+    /**
+     * @brief Takes frame number sequence out of its slot, if it is still
+     * there.  Consumer only.
+     */
+    bool take(uint64_t sequence, cv::Mat &frame);
+
+    /**
+     * @brief Releases the unread frames older than head and marks them as
+     * read.  Consumer only.
+     */
+    void discardBefore(uint64_t head);
+
+    /**
+     * @brief Gives an entry that the consumer has read back to the producer.
+     */
+    void returnEntry(uint64_t entry);
+
+    /**
+     * @brief Takes the oldest entry the consumer has given back.  Producer
+     * only.
+     *
+     * @return False if there is none.
+     */
+    bool takeReturnedEntry(uint64_t &entry);
+
+    size_t capacity_ = 0;
+
+    // The frames.  Each entry is owned by exactly one of: a slot, the
+    // producer (spareEntry_), the consumer, or the returned-entry queue.
+    std::vector<cv::Mat> entries_;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+
+    // Number of frames ever pushed.  Written only by the producer.
+    alignas(64) std::atomic<uint64_t> head_{0};
+    uint64_t spareEntry_ = 0;
+    std::atomic<uint64_t> droppedFrames_{0};
+
+    // Sequence number of the oldest frame not yet read.  Written only by the
+    // consumer.
+    alignas(64) std::atomic<uint64_t> tail_{0};
+
+    // Entries the consumer has finished with, on their way back to the
+    // producer.  Large enough to hold every entry, so it is never full.
+    std::vector<uint64_t> returnedEntries_;
+    alignas(64) std::atomic<uint64_t> returnedHead_{0};
+    alignas(64) std::atomic<uint64_t> returnedTail_{0};
+};
+} // namespace PiTrac
+
+#endif // GS_FRAME_RING_H
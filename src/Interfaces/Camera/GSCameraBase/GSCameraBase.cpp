@@ -107,20 +107,8 @@ void GSCameraBase::closeCamera()
         requests_.clear();
 
         // Free all allocated buffers
-        if (allocator_)
-        {
-            for (size_t i = 0; i < config_->size(); ++i)
-            {
-                libcamera::Stream *stream = config_->at(i).stream();
-                const std::vector<std::unique_ptr<libcamera::FrameBuffer> > &buffers =
-                    allocator_->buffers(stream);
-                if (!buffers.empty())
-                {
-                    allocator_->free(stream);
-                }
-            }
-        }
-        allocator_.reset();
+        freeBuffers();
+        framePool_.clear();
 
         camera_->release();
         camera_.reset();
@@ -176,8 +164,10 @@ cv::Mat GSCameraBase::captureFrame()
 
             if (frameReady_)
             {
+                // The pool will not reuse the frame while the caller holds
+                // it, so no copy is needed
                 frameReady_ = false;
-                return latestFrame_.clone();
+                return latestFrame_;
             }
             else
             {
@@ -307,21 +297,7 @@ bool GSCameraBase::switchStream(StreamType newStream)
     requests_.clear();
 
     // Step 3: Free ALL buffers
-    if (allocator_)
-    {
-        for (size_t i = 0; i < config_->size(); ++i)
-        {
-            libcamera::Stream *stream = config_->at(i).stream();
-            const std::vector<std::unique_ptr<libcamera::FrameBuffer> > &buffers =
-                allocator_->buffers(stream);
-            if (!buffers.empty())
-            {
-                allocator_->free(stream);
-                std::cout << "Freed buffers for stream " << i << std::endl;
-            }
-        }
-        allocator_.reset();
-    }
+    freeBuffers();
 
     // Step 4: Switch active stream
     activeStream_ = newStream;
@@ -347,57 +323,48 @@ bool GSCameraBase::switchStream(StreamType newStream)
 
 cv::Mat GSCameraBase::getLatestFrame()
 {
-    std::lock_guard<std::mutex> lock(frameBufferMutex_);
-
-    if (frameBuffer_.empty())
-    {
-        return cv::Mat(); // No frames available
-    }
-
-    // Get the most recent frame (discard older ones if multiple available)
-    cv::Mat latestFrame;
-    while (!frameBuffer_.empty())
-    {
-        latestFrame = frameBuffer_.front();
-        frameBuffer_.pop();
-    }
-
-    return latestFrame;
+    // Returns the most recent frame and discards older ones
+    return frameBuffer_.popLatest();
 }
 
 std::vector<cv::Mat> GSCameraBase::getAllAvailableFrames()
 {
-    std::lock_guard<std::mutex> lock(frameBufferMutex_);
-
     std::vector<cv::Mat> frames;
-    while (!frameBuffer_.empty())
-    {
-        frames.push_back(frameBuffer_.front());
-        frameBuffer_.pop();
-    }
+    frames.reserve(frameBuffer_.size());
+    frameBuffer_.drain(frames);
 
     return frames;
 }
 
 bool GSCameraBase::hasFramesAvailable() const
 {
-    std::lock_guard<std::mutex> lock(frameBufferMutex_);
     return !frameBuffer_.empty();
 }
 
 size_t GSCameraBase::getFrameQueueSize() const
 {
-    std::lock_guard<std::mutex> lock(frameBufferMutex_);
     return frameBuffer_.size();
 }
 
-void GSCameraBase::clearFrameBuffer()
+bool GSCameraBase::setMaxFrameBuffer(size_t maxFrames)
 {
-    std::lock_guard<std::mutex> lock(frameBufferMutex_);
-    while (!frameBuffer_.empty())
+    // The ring is only resized while the completion callback cannot be
+    // pushing to it
+    if (isCapturing_)
     {
-        frameBuffer_.pop();
+        std::cerr << "Cannot change frame buffer size while capturing" << std::endl;
+        return false;
     }
+
+    maxFrameBuffer_ = maxFrames;
+    frameBuffer_.reset(maxFrameBuffer_);
+
+    return true;
+}
+
+void GSCameraBase::clearFrameBuffer()
+{
+    frameBuffer_.clear();
 }
 
 std::string GSCameraBase::toString() const
@@ -433,6 +400,22 @@ bool GSCameraBase::allocateBuffersForStream(libcamera::Stream *stream)
     // Clear any existing requests
     requests_.clear();
 
+    if (!mapBuffers(stream))
+    {
+        std::cerr << "Failed to map buffers for stream" << std::endl;
+        return false;
+    }
+
+    // Enough frames for the ones libcamera is filling, the one being handed
+    // out, and a few held by the consumer.  The pool grows (up to the
+    // frame buffer size) if the consumer holds on to more.
+    const libcamera::StreamConfiguration &streamConfig = config_->at(0);
+    framePool_.reset(allocated + 2,
+                     maxFrameBuffer_ + 2,
+                     streamConfig.size.height,
+                     streamConfig.size.width,
+                     CV_8UC3);
+
     const std::vector<std::unique_ptr<libcamera::FrameBuffer> > &buffers =
         allocator_->buffers(stream);
     for (unsigned int i = 0; i < buffers.size(); ++i)
@@ -493,57 +476,116 @@ bool GSCameraBase::configureTriggerMode(const TriggerMode &mode)
     return true;
 }
 
+bool GSCameraBase::mapBuffers(libcamera::Stream *stream)
+{
+    unmapBuffers();
+
+    for (const std::unique_ptr<libcamera::FrameBuffer> &buffer : allocator_->buffers(stream))
+    {
+        const libcamera::FrameBuffer::Plane &plane = buffer->planes()[0];
+
+        // The plane may start part-way into its dmabuf
+        size_t mappingLength = plane.offset + plane.length;
+        void *mapping = mmap(nullptr, mappingLength, PROT_READ, MAP_SHARED, plane.fd.get(), 0);
+
+        if (mapping == MAP_FAILED)
+        {
+            std::cerr << "Failed to map buffer" << std::endl;
+            unmapBuffers();
+            return false;
+        }
+
+        MappedPlane &mappedPlane = mappedPlanes_[buffer.get()];
+        mappedPlane.mapping = mapping;
+        mappedPlane.mappingLength = mappingLength;
+        mappedPlane.data = static_cast<uint8_t *>(mapping) + plane.offset;
+    }
+
+    return true;
+}
+
+void GSCameraBase::unmapBuffers()
+{
+    for (auto &[buffer, mappedPlane] : mappedPlanes_)
+    {
+        munmap(mappedPlane.mapping, mappedPlane.mappingLength);
+    }
+
+    mappedPlanes_.clear();
+}
+
+void GSCameraBase::freeBuffers()
+{
+    unmapBuffers();
+
+    if (allocator_)
+    {
+        for (size_t i = 0; i < config_->size(); ++i)
+        {
+            libcamera::Stream *stream = config_->at(i).stream();
+            const std::vector<std::unique_ptr<libcamera::FrameBuffer> > &buffers =
+                allocator_->buffers(stream);
+            if (!buffers.empty())
+            {
+                allocator_->free(stream);
+                std::cout << "Freed buffers for stream " << i << std::endl;
+            }
+        }
+        allocator_.reset();
+    }
+}
+
 cv::Mat GSCameraBase::convertBufferToMat(libcamera::FrameBuffer *buffer)
 {
     // Active stream is always at index 0 in single-stream configuration
     const libcamera::StreamConfiguration &streamConfig = config_->at(0);
 
-    const libcamera::FrameBuffer::Plane &plane = buffer->planes()[0];
-    void *data = mmap(nullptr, plane.length, PROT_READ, MAP_SHARED, plane.fd.get(), 0);
+    auto mappedPlane = mappedPlanes_.find(buffer);
 
-    if (data == MAP_FAILED)
+    if (mappedPlane == mappedPlanes_.end())
     {
-        std::cerr << "Failed to map buffer" << std::endl;
+        std::cerr << "Buffer was not mapped" << std::endl;
         return cv::Mat();
     }
 
-    cv::Mat result;
+    void *data = mappedPlane->second.data;
+
     int width = streamConfig.size.width;
     int height = streamConfig.size.height;
     size_t stride = streamConfig.stride;
 
-    if (streamConfig.pixelFormat == libcamera::formats::SRGGB10_CSI2P)
+    if (streamConfig.pixelFormat != libcamera::formats::SRGGB10_CSI2P &&
+        streamConfig.pixelFormat != libcamera::formats::BGR888)
     {
-        cv::Mat rawImg = unpack10BitBayer(data, width, height, stride);
-        cv::cvtColor(rawImg, result, cv::COLOR_BayerRG2BGR);
+        std::cerr << "Unsupported pixel format: " << streamConfig.pixelFormat.toString() <<
+            std::endl;
+        return cv::Mat();
     }
-    else if (streamConfig.pixelFormat == libcamera::formats::BGR888)
+
+    // Converted straight into a pooled frame, which is handed out without
+    // any further copies
+    cv::Mat result = framePool_.acquire();
+
+    if (streamConfig.pixelFormat == libcamera::formats::SRGGB10_CSI2P)
     {
-        cv::Mat bgrImg(height, width, CV_8UC3, data, stride);
-        result = bgrImg.clone();
+        unpack10BitBayer(data, width, height, stride, bayer8Scratch_);
+        cv::cvtColor(bayer8Scratch_, result, cv::COLOR_BayerRG2BGR);
     }
     else
     {
-        std::cerr << "Unsupported pixel format: " << streamConfig.pixelFormat.toString() <<
-            std::endl;
+        cv::Mat bgrImg(height, width, CV_8UC3, data, stride);
+        bgrImg.copyTo(result);
     }
 
-    munmap(data, plane.length);
     return result;
 }
 
 void GSCameraBase::addFrameToBuffer(const cv::Mat &frame)
 {
-    std::lock_guard<std::mutex> lock(frameBufferMutex_);
-
-    // Add frame to buffer
-    frameBuffer_.push(frame.clone());
-
-    // Enforce maximum buffer size
-    while (frameBuffer_.size() > maxFrameBuffer_)
-    {
-        frameBuffer_.pop(); // Remove oldest frame
-    }
+    // Add frame to buffer, overwriting the oldest frame if it is full.  The
+    // frame comes from the frame pool, which will not reuse it while it is in
+    // the buffer.
+    frameBuffer_.push(frame);
 }
 
 void GSCameraBase::requestComplete(libcamera::Request *request)
@@ -591,13 +633,17 @@ void GSCameraBase::requestComplete(libcamera::Request *request)
     }
 }
 
-cv::Mat GSCameraBase::unpack10BitBayer(void *data, int width, int height, size_t stride)
+void GSCameraBase::unpack10BitBayer(void *data,
+                                    int width,
+                                    int height,
+                                    size_t stride,
+                                    cv::Mat &result)
 {
     // SRGGB10_CSI2P packs 4 pixels (40 bits) into 5 bytes
-    cv::Mat result(height, width, CV_16UC1);  // Use 16-bit for 10-bit data
+    bayer16Scratch_.create(height, width, CV_16UC1);  // Use 16-bit for 10-bit data
 
     uint8_t *src = static_cast<uint8_t *>(data);
-    uint16_t *dst = reinterpret_cast<uint16_t *>(result.data);
+    uint16_t *dst = reinterpret_cast<uint16_t *>(bayer16Scratch_.data);
 
     for (int y = 0; y < height; y++)
     {
@@ -631,11 +677,8 @@ cv::Mat GSCameraBase::unpack10BitBayer(void *data, int width, int height, size_t
     }
 
     // Convert to 8-bit for OpenCV compatibility (shift right by 2 bits)
-    cv::Mat result8bit;
-    result.convertTo(result8bit, CV_8UC1, 1.0 / 4.0);  // Divide by 4 to convert
-                                                       // 10-bit to 8-bit
-
-    return result8bit;
+    bayer16Scratch_.convertTo(result, CV_8UC1, 1.0 / 4.0);  // Divide by 4 to convert
+                                                            // 10-bit to 8-bit
 }
 
 bool GSCameraBase::reconfigureForActiveStream()
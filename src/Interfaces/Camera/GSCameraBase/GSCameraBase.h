@@ -2,6 +2,10 @@
 #define GS_CAMERA_BASE_H
 
 #include "Interfaces/Camera/GSCameraInterface.h"
+#include "Interfaces/Camera/GSCameraBase/FramePool.h"
+#include "Interfaces/Camera/GSCameraBase/FrameRing.h"
+#include <unordered_map>
+
 namespace PiTrac
 {
 class GSCameraBase : public GSCameraInterface
@@ -127,15 +131,34 @@ class GSCameraBase : public GSCameraInterface
 
   private:
 
-    // @brief Frame buffer for external trigger mode
-    mutable std::mutex frameBufferMutex_;
-
-    // @brief Buffer for storing captured frames.
-    std::queue<cv::Mat> frameBuffer_;
-
     // @brief Maximum number of frames to buffer.
     size_t maxFrameBuffer_ = 100;
 
+    // @brief Frame buffer for external trigger mode.  Filled by the libcamera
+    // completion callback, which it never blocks, and read by one consumer
+    // thread.
+    FrameRing frameBuffer_{maxFrameBuffer_};
+
+    // @brief A plane of a libcamera::FrameBuffer, mapped into memory
+    struct MappedPlane
+    {
+        void *mapping = nullptr;     // Start of the mapping, for munmap
+        size_t mappingLength = 0;
+        uint8_t *data = nullptr;     // Start of the plane within the mapping
+    };
+
+    // @brief The first plane of each allocated buffer.  Mapped once, when the
+    // buffers are allocated, rather than for every frame.
+    std::unordered_map<const libcamera::FrameBuffer *, MappedPlane> mappedPlanes_;
+
+    // @brief The converted frames.  Reused once nobody holds them any more.
+    FramePool framePool_;
+
+    // @brief Scratch images for unpacking raw Bayer frames, kept between
+    // frames
+    cv::Mat bayer16Scratch_;
+    cv::Mat bayer8Scratch_;
+
     /**
      * @brief Configures the camera with the required settings.
      *
@@ -153,6 +176,27 @@ class GSCameraBase : public GSCameraInterface
      */
     bool allocateBuffersForStream(libcamera::Stream *stream) override;
 
+    /**
+     * @brief Maps the first plane of each buffer allocated for the stream.
+     *
+     * @param stream Pointer to the libcamera::Stream whose buffers to map.
+     *
+     * @return true if every buffer was mapped, false otherwise.
+     */
+    bool mapBuffers(libcamera::Stream *stream);
+
+    /**
+     * @brief Unmaps all buffers mapped by mapBuffers.  Must be called before
+     * the buffers are freed.
+     */
+    void unmapBuffers();
+
+    /**
+     * @brief Frees all allocated buffers (after unmapping them) and the
+     * allocator.
+     */
+    void freeBuffers();
+
     /**
      * @brief Configures the camera to operate in trigger mode.
      *
@@ -243,13 +287,12 @@ class GSCameraBase : public GSCameraInterface
      * only)
      *
      * If the buffer exceeds this size, the oldest frames will be discarded.
+     * Any frames in the buffer are cleared.  Cannot be changed while capturing.
      *
      * @param[in] maxFrames The maximum number of frames to buffer.
+     * @return true if the size was changed, false if capturing.
      */
-    void setMaxFrameBuffer(size_t maxFrames)
-    {
-        maxFrameBuffer_ = maxFrames;
-    }
+    bool setMaxFrameBuffer(size_t maxFrames);
 
     /**
      * @brief Get the maximum number of frames that can be buffered
@@ -274,10 +317,10 @@ class GSCameraBase : public GSCameraInterface
      * @param width Width of the image in pixels.
      * @param height Height of the image in pixels.
      * @param stride Number of bytes per row in the input data.
-     *
-     * @return cv::Mat The unpacked image as an OpenCV matrix.
+     * @param result The unpacked (8-bit) image.  Only re-allocated if it is
+     * not already the right size.
      */
-    cv::Mat unpack10BitBayer(void *data, int width, int height, size_t stride);
+    void unpack10BitBayer(void *data, int width, int height, size_t stride, cv::Mat &result);
 }; // class GSCameraBase
 } // namespace PiTrac
 
@@ -0,0 +1,56 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2022-2025, Verdant Consultants, LLC.
+ */
+
+// Picks out the frames of a streaming still camera that are new enough to
+// answer a capture request.  A camera that is kept running between pictures
+// has frames waiting in its queue that were exposed before the picture was
+// asked for.  Those frames are skipped (and counted), and the first frame
+// whose sensor timestamp is not before the request is used.  A frame without
+// a timestamp cannot be shown to be stale, so it is used.
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+
+namespace PiTrac
+{
+class StaleFrameFilter
+{
+  public:
+
+    // request_time_ns is when the picture was asked for, on the same clock as
+    // the sensor timestamps
+    explicit StaleFrameFilter(int64_t request_time_ns)
+        : request_time_ns_(request_time_ns)
+    {
+    }
+
+    // True if the frame can be used.  has_image is false if the frame does
+    // not include the still image, in which case it is skipped.  Skipped
+    // frames are counted.
+    bool Accept(std::optional<int64_t> sensor_timestamp_ns, bool has_image = true)
+    {
+        if (!has_image || (sensor_timestamp_ns && *sensor_timestamp_ns < request_time_ns_))
+        {
+            skipped_frames_++;
+            return false;
+        }
+
+        return true;
+    }
+
+    int SkippedFrames() const
+    {
+        return skipped_frames_;
+    }
+
+  private:
+
+    int64_t request_time_ns_;
+    int skipped_frames_ = 0;
+};
+}
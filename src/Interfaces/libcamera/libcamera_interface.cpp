@@ -67,6 +67,11 @@ std::string LibCameraInterface::kCameraMotionDetectSettings = "./assets/motion_d
 long LibCameraInterface::kCamera1StillShutterTimeuS = 15000;
 long LibCameraInterface::kCamera2StillShutterTimeuS = 15000;
 
+std::string LibCameraInterface::kUndistortionMapDirectory = "";
+UndistortionMapCache LibCameraInterface::undistortion_map_cache_;
+bool LibCameraInterface::kUsePointSpaceUndistortion = false;
+bool LibCameraInterface::kUseWarmStillCapture = false;
+
 // Default values are based on empirical measurements using a 6mm lens
 int kCroppedImagePixelOffsetLeft = -5;
 int kCroppedImagePixelOffsetUp = -13;
@@ -79,9 +84,12 @@ cv::Vec2i LibCameraInterface::current_watch_offset_;
 
 LibCameraInterface::CameraConfiguration LibCameraInterface::libcamera_configuration_[] =
 { LibCameraInterface::CameraConfiguration::kNotConfigured,
+  LibCameraInterface::CameraConfiguration::kNotConfigured,
   LibCameraInterface::CameraConfiguration::kNotConfigured };
 
-LibcameraJpegApp *LibCameraInterface::libcamera_app_[] = { nullptr, nullptr };
+LibcameraJpegApp *LibCameraInterface::libcamera_app_[] = { nullptr, nullptr, nullptr };
+
+bool LibCameraInterface::still_camera_streaming_[] = { false, false, false };
 
 bool camera_location_found_ = false;
 int previously_found_media_number_ = -1;
@@ -194,6 +202,8 @@ bool WatchForBallMovement(GolfSimCamera &camera, const GolfBall &ball, bool &mot
     // sensor that will
     // be processed in each frame (cropping)
 
+    ReleaseStillCamera(camera.camera_hardware_.camera_number_);
+
     // Will be setup when camera is configured for cropping, then is used in the
     // ball-watcher-loop
     RPiCamEncoder app;
@@ -1137,6 +1147,8 @@ bool RetrieveCameraInfo(const GsCameraNumber camera_number,
 
     if (restartCamera)
     {
+        ReleaseStillCamera(camera_number);
+
         try
         {
             StillOptions *options = app.GetOptions();
@@ -1236,40 +1248,24 @@ cv::Mat LibCameraInterface::undistort_camera_image(const cv::Mat &img, const Gol
                "undistort_camera_image called with camera_number = " +
                std::to_string(camera_number) + ", camera_model = " + std::to_string(camera_model));
 
-    // Get the calibration values from the camera
+    // The maps are only built the first time for each camera and resolution,
+    // or if the camera's calibration values have changed since then.
+    // The mono camera uses the fixed-point maps, as it always has.  The color
+    // camera keeps the full precision of the float maps.
+    int map1_type = camera.camera_hardware_.is_mono_camera_ ? CV_16SC2 : CV_32FC1;
 
-    cv::Mat cameracalibrationMatrix_ = camera.camera_hardware_.calibrationMatrix_;
-    cv::Mat cameraDistortionVector_ = camera.camera_hardware_.cameraDistortionVector_;
+    GS_LOG_MSG(trace,
+               std::string("undistort_camera_image using ") +
+               (map1_type == CV_16SC2 ? "fixed-point" : "float") + " maps");
 
     cv::Mat unDistortedBall1Img;
-    cv::Mat m_undistMap1, m_undistMap2;
-
-    if (camera.camera_hardware_.is_mono_camera_)
-    {
-        GS_LOG_MSG(trace, "undistort_camera_image using image format CV_8UC1");
-        cv::initUndistortRectifyMap(cameracalibrationMatrix_,
-                                    cameraDistortionVector_,
-                                    cv::Mat(),
-                                    cameracalibrationMatrix_,
-                                    cv::Size(img.cols, img.rows),
-                                    CV_8UC1,
-                                    m_undistMap1,
-                                    m_undistMap2);
-    }
-    else
-    {
-        GS_LOG_MSG(trace, "undistort_camera_image using image format CV_32FC1");
-        cv::initUndistortRectifyMap(cameracalibrationMatrix_,
-                                    cameraDistortionVector_,
-                                    cv::Mat(),
-                                    cameracalibrationMatrix_,
-                                    cv::Size(img.cols, img.rows),
-                                    CV_32FC1,
-                                    m_undistMap1,
-                                    m_undistMap2);
-    }
 
-    cv::remap(img, unDistortedBall1Img, m_undistMap1, m_undistMap2, cv::INTER_LINEAR);
+    undistortion_map_cache_.Undistort(img,
+                                      camera_number,
+                                      camera.camera_hardware_.calibrationMatrix_,
+                                      camera.camera_hardware_.cameraDistortionVector_,
+                                      unDistortedBall1Img,
+                                      map1_type);
 
     return unDistortedBall1Img;
 }
@@ -1580,6 +1576,7 @@ bool DeConfigureForLibcameraStill(const GsCameraNumber camera_number)
     {
         GS_LOG_TRACE_MSG(trace, "Tearing down initial camera.");
         lci::libcamera_app_[camera_number]->StopCamera();
+        lci::still_camera_streaming_[camera_number] = false;
         lci::libcamera_app_[camera_number]->Teardown();  // TBD - Need?
         delete lci::libcamera_app_[camera_number];
         lci::libcamera_app_[camera_number] = nullptr;
@@ -1596,9 +1593,25 @@ bool DeConfigureForLibcameraStill(const GsCameraNumber camera_number)
     return true;
 }
 
+void ReleaseStillCamera(const GsCameraNumber camera_number)
+{
+    if (lci::libcamera_app_[camera_number] != nullptr)
+    {
+        GS_LOG_TRACE_MSG(trace,
+                         "ReleaseStillCamera releasing still camera " +
+                         std::to_string(camera_number));
+        DeConfigureForLibcameraStill(camera_number);
+    }
+}
+
 // Actually from libcamera_jpeg code, not libcamera_still
 bool TakeLibcameraStill(const GolfSimCamera &camera, cv::Mat &img)
 {
+    const GsCameraNumber camera_number = camera.camera_hardware_.camera_number_;
+    const bool first_capture = (lci::libcamera_app_[camera_number] == nullptr);
+
+    auto start_time = std::chrono::steady_clock::now();
+
     LibcameraJpegApp *app = ConfigureForLibcameraStill(camera);
 
     if (app == nullptr)
@@ -1607,27 +1620,52 @@ bool TakeLibcameraStill(const GolfSimCamera &camera, cv::Mat &img)
         return false;
     }
 
+    bool success = true;
+
     try
     {
-        still_image_event_loop(*app, img);
+        if (lci::kUseWarmStillCapture)
+        {
+            success = warm_still_image_event_loop(*app,
+                                                  lci::still_camera_streaming_[camera_number],
+                                                  img);
+        }
+        else
+        {
+            still_image_event_loop(*app, img);
+        }
     }
     catch (std::exception const &e)
     {
         GS_LOG_MSG(error, "ERROR: *** " + std::string(e.what()) + " ***");
-        return false;
+        success = false;
     }
 
-    if (!DeConfigureForLibcameraStill(GolfSimOptions::GetCommandLineOptions().GetCameraNumber()))
+    // A warm camera is left running for the next picture, unless something
+    // went wrong with it
+    if (!lci::kUseWarmStillCapture || !success)
     {
-        GS_LOG_TRACE_MSG(error, "failed to DeConfigureForLibcameraStill.");
-        return false;
+        if (!DeConfigureForLibcameraStill(camera_number))
+        {
+            GS_LOG_TRACE_MSG(error, "failed to DeConfigureForLibcameraStill.");
+            return false;
+        }
     }
 
-    return true;
+    auto capture_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_time).count();
+
+    GS_LOG_TRACE_MSG(trace,
+                     std::string("TakeLibcameraStill (") +
+                     (lci::kUseWarmStillCapture ? "warm" : "cold") +
+                     (first_capture ? ", first frame" : "") + ") took " +
+                     std::to_string(capture_ms) + " ms.");
+
+    return success;
 }
 
 // TBD - This really seems like it should exist in the gs_camera module?
-bool TakeRawPicture(const GolfSimCamera &camera, cv::Mat &img)
+bool TakeRawPicture(const GolfSimCamera &camera, cv::Mat &img, bool undistort)
 {
     const GsCameraNumber camera_number = camera.camera_hardware_.camera_number_;
 
@@ -1654,6 +1692,12 @@ bool TakeRawPicture(const GolfSimCamera &camera, cv::Mat &img)
         return false;
     }
 
+    if (!undistort)
+    {
+        img = initialImg;
+        return true;
+    }
+
     img = PiTrac::LibCameraInterface::undistort_camera_image(initialImg, camera);
 
     return true;
@@ -1678,8 +1722,14 @@ bool CheckForBall(GolfBall &ball, cv::Mat &img)
         std::string("/mnt/VerdantShare/dev/GolfSim/LM/Images/") + "FirstWaitingImage";
     camera.camera_hardware_.firstCannedImage = img;
 
+    // This is called over and over while waiting for a ball, so in the
+    // point-space mode the full-frame undistortion is put off until there is
+    // a ball
+    bool image_is_distorted = lci::kUsePointSpaceUndistortion &&
+                              camera.camera_hardware_.use_calibration_matrix_;
+
     // If we are checking to see if a ball
-    if (!TakeRawPicture(camera, img))
+    if (!TakeRawPicture(camera, img, !image_is_distorted))
     {
         GS_LOG_MSG(error, "Failed to TakeRawPicture.");
         return false;
@@ -1688,7 +1738,12 @@ bool CheckForBall(GolfBall &ball, cv::Mat &img)
     cv::Vec2i search_area_center = camera.GetExpectedBallCenter();
 
     bool expectBall = false;
-    bool success = camera.GetCalibratedBall(camera, img, ball, search_area_center, expectBall);
+    bool success = camera.GetCalibratedBall(camera,
+                                            img,
+                                            ball,
+                                            search_area_center,
+                                            expectBall,
+                                            image_is_distorted);
 
     if (!success)
     {
@@ -1696,6 +1751,12 @@ bool CheckForBall(GolfBall &ball, cv::Mat &img)
         return false;
     }
 
+    // The ball's geometry is already undistorted, so make the image match it
+    if (image_is_distorted)
+    {
+        img = PiTrac::LibCameraInterface::undistort_camera_image(img, camera);
+    }
+
     GS_LOG_TRACE_MSG(trace, "kCalibrated BALL -------> " + ball.Format());
 
     return true;
@@ -1704,6 +1765,8 @@ bool CheckForBall(GolfBall &ball, cv::Mat &img)
 // The following code is only relevant to the camera 2 system
 bool WaitForCam2Trigger(cv::Mat &return_image)
 {
+    ReleaseStillCamera(GsCameraNumber::kGsCamera2);
+
     LibcameraJpegApp app;
 
     cv::Mat raw_image;
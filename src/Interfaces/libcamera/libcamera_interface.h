@@ -19,6 +19,7 @@
 #include "golf_ball.h"
 #include "gs_camera.h"
 #include "gs_options.h"
+#include "Infrastructure/ImageProcessing/UndistortionMapCache.h"
 
 #include "still_image_libcamera_app.hpp"
 
@@ -72,6 +73,25 @@ class LibCameraInterface
     static long kCamera1StillShutterTimeuS;
     static long kCamera2StillShutterTimeuS;
 
+    // If not empty, the undistortion maps for each camera are saved in this
+    // directory, so that they do not have to be rebuilt after a restart
+    static std::string kUndistortionMapDirectory;
+
+    // The undistortion maps for each camera, resolution and calibration
+    static UndistortionMapCache undistortion_map_cache_;
+
+    // If set, CheckForBall looks for the ball in the raw camera image and
+    // only undistorts the ball's circle.  The whole image is undistorted
+    // only once a ball has been found, as that image may then be logged or
+    // used later.
+    static bool kUsePointSpaceUndistortion;
+
+    // If set, TakeLibcameraStill leaves the camera configured and running
+    // between pictures, instead of opening, configuring, starting and
+    // tearing it down for every one.  The camera is only released when
+    // something else (such as the high-speed ball watching) needs it.
+    static bool kUseWarmStillCapture;
+
     // Once the cropped rectange is determined (usually around the center of the
     // ball)
     // These offsets can further move that cropping area
@@ -84,11 +104,14 @@ class LibCameraInterface
     static cv::Vec2i current_watch_offset_;
 
 
-    // The first (0th) element in the array is for camera1, the second for
-    // camera2
+    // These arrays are indexed by GsCameraNumber, so the first (0th) element
+    // is not used
     static CameraConfiguration libcamera_configuration_[];
     static LibcameraJpegApp *libcamera_app_[];
 
+    // True while a warm still-capture camera is running
+    static bool still_camera_streaming_[];
+
     // True (or set to a non-negative number) if we've already figured out the
     // media and device number for the camera;
     static bool camera_location_found_;
@@ -96,7 +119,9 @@ class LibCameraInterface
     static int previously_found_device_number_;
 };
 
-bool TakeRawPicture(const GolfSimCamera &camera, cv::Mat &img);
+// Returns the picture with the camera's lens distortion removed, unless
+// undistort is false
+bool TakeRawPicture(const GolfSimCamera &camera, cv::Mat &img, bool undistort = true);
 
 // Takes a picture and then tries to find the ball
 bool CheckForBall(GolfBall &ball, cv::Mat &return_image);
@@ -151,6 +176,10 @@ bool RetrieveCameraInfo(const GsCameraNumber camera_number,
 LibcameraJpegApp * ConfigureForLibcameraStill(const GolfSimCamera &camera);
 bool DeConfigureForLibcameraStill(const GsCameraNumber camera_number);
 
+// Closes any still-capture camera that was left running (see
+// kUseWarmStillCapture), so that the camera can be used some other way
+void ReleaseStillCamera(const GsCameraNumber camera_number);
+
 bool TakeLibcameraStill(const GolfSimCamera &camera, cv::Mat &return_image);
 
 bool WatchForHitAndTrigger(const GolfBall &ball, cv::Mat &return_image, bool &motion_detected);
@@ -7,6 +7,7 @@
  #include <chrono>
 #include <signal.h>
 #include <sys/stat.h>
+#include <time.h>
 
 #include <rpicam-apps/core/rpicam_encoder.hpp>
 #include <rpicam-apps/encoder/encoder.hpp>
@@ -38,6 +39,7 @@
 #include "image/image.hpp"
 
 #include "still_image_libcamera_app.hpp"
+#include "StaleFrameFilter.h"
 
 using namespace std::placeholders;
 using libcamera::Stream;
@@ -418,6 +420,34 @@ bool ball_flight_camera_event_loop(LibcameraJpegApp &app, cv::Mat &returnImg)
     return return_status;
 }
 
+// Copies the still image out of the completed request, so that the request's
+// buffer can be given back to the camera
+static void CopyStillImage(LibcameraJpegApp &app,
+                           CompletedRequestPtr &payload,
+                           cv::Mat &returnImg)
+{
+    Stream *stream = app.StillStream();
+    StreamInfo info = app.GetStreamInfo(stream);
+
+    unsigned int h = info.height, w = info.width, stride = info.stride;
+    GS_LOG_TRACE_MSG(trace,
+                     "Still image (width, height) = (" + std::to_string(w) + "," +
+                     std::to_string(h) + ") Stride = " + std::to_string(stride));
+
+    libcamera::FrameBuffer *buffer = payload->buffers[stream];
+
+    BufferReadSync r(&app, buffer);
+
+    const std::vector<libcamera::Span<uint8_t> > mem = r.Get();
+
+    uint32_t *image = (uint32_t *)mem[0].data();
+
+    cv::Mat frame = cv::Mat(info.height, info.width, CV_8UC3, image, info.stride);
+
+    // Save the image in memory
+    returnImg = frame.clone();
+}
+
 // The main event loop for the camera 1 system.
 
 bool still_image_event_loop(LibcameraJpegApp &app, cv::Mat &returnImg)
@@ -506,29 +536,101 @@ bool still_image_event_loop(LibcameraJpegApp &app, cv::Mat &returnImg)
             app.StopCamera();
             GS_LOG_TRACE_MSG(trace, "Still capture image received");
 
-            Stream *stream = app.StillStream();
-            StreamInfo info = app.GetStreamInfo(stream);
+            CompletedRequestPtr &payload = std::get<CompletedRequestPtr>(msg.payload);
+            CopyStillImage(app, payload, returnImg);
+
+            return true;
+        }
+    }
+}
+
+// Same as still_image_event_loop, but leaves the camera running afterward, so
+// that the next picture does not have to wait for the camera to start.
+// camera_streaming says whether the camera is already running, and is kept
+// up to date.
 
-            unsigned int h = info.height, w = info.width, stride = info.stride;
-            GS_LOG_TRACE_MSG(trace,
-                             "Still image (width, height) = (" + std::to_string(w) + "," +
-                             std::to_string(h) + ") Stride = " + std::to_string(stride));
+bool warm_still_image_event_loop(LibcameraJpegApp &app, bool &camera_streaming, cv::Mat &returnImg)
+{
+    GS_LOG_TRACE_MSG(trace, "warm_still_image_event_loop");
 
-            CompletedRequestPtr &payload = std::get<CompletedRequestPtr>(msg.payload);
-            libcamera::FrameBuffer *buffer = payload->buffers[stream];
+    StillOptions *options = app.GetOptions();
 
-            BufferReadSync r(&app, buffer);
+    // Frames that started before this point have been waiting in the queue
+    // and are too old to use.  The sensor timestamps use the boot-time clock.
+    struct timespec now_ts;
+    clock_gettime(CLOCK_BOOTTIME, &now_ts);
+    const int64_t request_time_ns = (int64_t)now_ts.tv_sec * 1000000000LL + now_ts.tv_nsec;
 
-            const std::vector<libcamera::Span<uint8_t> > mem = r.Get();
+    auto start_time = std::chrono::high_resolution_clock::now();
 
-            uint32_t *image = (uint32_t *)mem[0].data();
+    if (!camera_streaming)
+    {
+        options->no_raw = true;      // See
+                                     // https://forums.raspberrypi.com/viewtopic.php?t=369927
+        app.StartCamera();
+        camera_streaming = true;
+        GS_LOG_TRACE_MSG(trace, "Camera started.");
+    }
 
-            cv::Mat frame = cv::Mat(info.height, info.width, CV_8UC3, image, info.stride);
+    gs::StaleFrameFilter stale_frame_filter(request_time_ns);
 
-            // Save the image in memory
-            returnImg = frame.clone();
+    for (;;)
+    {
+        if (!gs::GolfSimGlobals::PiTrac_running_)
+        {
+            app.StopCamera();
+            camera_streaming = false;
+            return false;
+        }
 
-            return true;
+        RPiCamApp::Msg msg = app.Wait();
+
+        if (msg.type == RPiCamApp::MsgType::Timeout)
+        {
+            GS_LOG_MSG(error, "ERROR: Device timeout detected, attempting a restart.");
+            app.StopCamera();
+            app.StartCamera();
+            continue;
+        }
+        if (msg.type == RPiCamApp::MsgType::Quit)
+        {
+            return false;
+        }
+        else if (msg.type != RPiCamApp::MsgType::RequestComplete)
+        {
+            throw std::runtime_error("unrecognised message!");
         }
+
+        // Letting go of a completed request gives its buffer back to the
+        // camera for another frame
+        CompletedRequestPtr &payload = std::get<CompletedRequestPtr>(msg.payload);
+        auto sensor_timestamp = payload->metadata.get(libcamera::controls::SensorTimestamp);
+
+        // A completed request without a still buffer has nothing to copy
+        bool has_still_image = app.StillStream() != nullptr &&
+                               payload->buffers.count(app.StillStream()) != 0;
+
+        if (!stale_frame_filter.Accept(sensor_timestamp, has_still_image))
+        {
+            auto now = std::chrono::high_resolution_clock::now();
+            if (options->timeout &&
+                now - start_time >
+                std::chrono::milliseconds(options->timeout.get<std::chrono::milliseconds>()))
+            {
+                GS_LOG_MSG(warning, "warm_still_image_event_loop timed out.");
+                return false;
+            }
+
+            continue;
+        }
+
+        GS_LOG_TRACE_MSG(trace,
+                         "Warm still capture image received after skipping " +
+                         std::to_string(stale_frame_filter.SkippedFrames()) +
+                         " older frame(s).");
+
+        CopyStillImage(app, payload, returnImg);
+
+        return true;
     }
 }
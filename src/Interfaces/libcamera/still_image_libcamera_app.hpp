@@ -42,6 +42,7 @@ class LibcameraJpegApp : public RPiCamApp
 
 // The main event loops for the camera 1 and 2 systems
 bool still_image_event_loop(LibcameraJpegApp &app, cv::Mat &returnImg);
+bool warm_still_image_event_loop(LibcameraJpegApp &app, bool &camera_streaming, cv::Mat &returnImg);
 
 bool ball_flight_camera_event_loop(LibcameraJpegApp &app, cv::Mat &returnImg);
 
@@ -0,0 +1,155 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/CircleRefiner.h"
+
+namespace PiTrac
+{
+class CircleRefinerTest : public ::testing::Test
+{
+  protected:
+    // Draws an anti-aliased ball whose center and radius are not whole pixels
+    void DrawBall(const cv::Vec3f &ball)
+    {
+        const int shift = 4;
+        const float scale = (float)(1 << shift);
+
+        cv::circle(image,
+                   cv::Point((int)std::lround(ball[0] * scale), (int)std::lround(ball[1] * scale)),
+                   (int)std::lround(ball[2] * scale),
+                   cv::Scalar(200),
+                   cv::FILLED,
+                   cv::LINE_AA,
+                   shift);
+    }
+
+    void SetUp() override
+    {
+        image = cv::Mat(480, 640, CV_8UC1, cv::Scalar(40));
+        DrawBall(ball);
+    }
+
+    void AddNoise()
+    {
+        cv::Mat noise(image.size(), CV_16SC1);
+        cv::RNG rng(1234);
+        rng.fill(noise, cv::RNG::NORMAL, 0, 4);
+
+        cv::Mat noisy;
+        image.convertTo(noisy, CV_16SC1);
+        noisy += noise;
+        noisy.convertTo(image, CV_8UC1);
+    }
+
+    static void ExpectNear(const cv::Vec3f &circle, const cv::Vec3f &expected, float tolerance)
+    {
+        EXPECT_NEAR(circle[0], expected[0], tolerance);
+        EXPECT_NEAR(circle[1], expected[1], tolerance);
+        EXPECT_NEAR(circle[2], expected[2], tolerance);
+    }
+
+    cv::Mat image;
+    const cv::Vec3f ball = cv::Vec3f(320.3f, 241.7f, 52.4f);
+};
+
+TEST_F(CircleRefinerTest, FitsExactPoints) {
+    std::vector<cv::Point2f> points;
+
+    for (int i = 0; i < 36; i++)
+    {
+        double angle = i * CV_PI / 18.0;
+        points.emplace_back((float)(10.5 + 20.0 * std::cos(angle)),
+                            (float)(-3.25 + 20.0 * std::sin(angle)));
+    }
+
+    cv::Vec3f circle;
+    ASSERT_TRUE(CircleRefiner::FitCircleAlgebraic(points, circle));
+    ExpectNear(circle, cv::Vec3f(10.5f, -3.25f, 20.0f), 1e-3f);
+
+    ASSERT_TRUE(CircleRefiner::FitCircleRobust(points, 1.0, circle));
+    ExpectNear(circle, cv::Vec3f(10.5f, -3.25f, 20.0f), 1e-3f);
+}
+
+TEST_F(CircleRefinerTest, RefinesOffsetCircleToSubPixel) {
+    AddNoise();
+
+    // About what the first Hough pass gives
+    cv::Vec3f initial(ball[0] + 3.0f, ball[1] - 2.0f, ball[2] * 1.08f);
+    cv::Vec3f refined;
+
+    ASSERT_TRUE(CircleRefiner::Refine(image, initial, refined));
+    ExpectNear(refined, ball, 0.3f);
+}
+
+// Something touching the ball, like a second ball or the tee, should not pull
+// the circle toward it
+TEST_F(CircleRefinerTest, IgnoresNeighboringObject) {
+    cv::circle(image, cv::Point(385, 241), 20, cv::Scalar(200), cv::FILLED, cv::LINE_AA);
+    AddNoise();
+
+    cv::Vec3f initial(ball[0] - 2.0f, ball[1] + 2.0f, ball[2] * 0.95f);
+    cv::Vec3f refined;
+
+    ASSERT_TRUE(CircleRefiner::Refine(image, initial, refined));
+    ExpectNear(refined, ball, 0.5f);
+}
+
+TEST_F(CircleRefinerTest, FailsWithoutAnEdge) {
+    cv::Mat blank(480, 640, CV_8UC1, cv::Scalar(40));
+    cv::Vec3f refined;
+
+    EXPECT_FALSE(CircleRefiner::Refine(blank, ball, refined));
+}
+
+// Not a pass/fail test - shows what the refinement saves over the second
+// Hough pass in DetermineBestCircle
+TEST_F(CircleRefinerTest, CompareWithHoughBenchmark) {
+    AddNoise();
+
+    cv::Vec3f initial(ball[0] + 3.0f, ball[1] - 2.0f, ball[2] * 1.08f);
+    const int iterations = 200;
+
+    int search_radius = (int)(initial[2] * 1.5);
+    cv::Rect roi(cv::Point((int)initial[0] - search_radius, (int)initial[1] - search_radius),
+                 cv::Size(2 * search_radius, 2 * search_radius));
+    cv::Mat roi_image = image(roi);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<cv::Vec3f> circles;
+
+    for (int i = 0; i < iterations; i++)
+    {
+        cv::Mat blurred;
+        cv::GaussianBlur(roi_image, blurred, cv::Size(5, 5), 0);
+        cv::HoughCircles(blurred, circles, cv::HOUGH_GRADIENT_ALT, 1.0, 10, 300, 0.8,
+                         (int)(initial[2] * 0.85), (int)(initial[2] * 1.1));
+    }
+
+    auto hough_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+    start = std::chrono::high_resolution_clock::now();
+    cv::Vec3f refined;
+
+    for (int i = 0; i < iterations; i++)
+    {
+        CircleRefiner::Refine(image, initial, refined);
+    }
+
+    auto refine_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+    std::cout << "Hough (ROI): " << hough_ms << " ms" << std::endl;
+    std::cout << "Least-squares refinement: " << refine_ms << " ms" << std::endl;
+
+    if (!circles.empty())
+    {
+        cv::Vec3f hough_circle = circles[0];
+        hough_circle[0] += roi.x;
+        hough_circle[1] += roi.y;
+        std::cout << "Hough circle: " << hough_circle << ", refined circle: " << refined
+                  << ", actual: " << ball << std::endl;
+    }
+}
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/ColorMaskLut.h"
+
+namespace PiTrac
+{
+class ColorMaskLutTest : public ::testing::Test
+{
+  protected:
+    static cv::Mat InRangeMask(const cv::Mat &hsv_image)
+    {
+        cv::Mat mask;
+        cv::inRange(hsv_image, lower_hsv, upper_hsv, mask);
+        return mask;
+    }
+
+    static inline const cv::Scalar lower_hsv = cv::Scalar(20, 60, 60);
+    static inline const cv::Scalar upper_hsv = cv::Scalar(40, 255, 255);
+};
+
+TEST_F(ColorMaskLutTest, MatchesHsvMaskForBinCenterColors) {
+    ColorMaskLut lut;
+    EXPECT_FALSE(lut.IsBuiltFor(lower_hsv, upper_hsv));
+
+    lut.Build(lower_hsv, upper_hsv, InRangeMask);
+    EXPECT_TRUE(lut.IsBuiltFor(lower_hsv, upper_hsv));
+    EXPECT_FALSE(lut.IsBuiltFor(lower_hsv, cv::Scalar(50, 255, 255)));
+
+    // Random colors, each moved to the center of its bin
+    const int bin_size = 1 << (8 - ColorMaskLut::kBitsPerChannel);
+    cv::Mat bgr_image(120, 160, CV_8UC3);
+    cv::randu(bgr_image, cv::Scalar::all(0), cv::Scalar::all(256));
+    bgr_image.forEach<cv::Vec3b>([&](cv::Vec3b &pixel, const int *)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                pixel[c] = (uchar)((pixel[c] / bin_size) * bin_size + bin_size / 2);
+            }
+        });
+
+    cv::Mat hsv_image;
+    cv::cvtColor(bgr_image, hsv_image, cv::COLOR_BGR2HSV);
+    cv::Mat expected_mask = InRangeMask(hsv_image);
+
+    cv::Mat mask;
+    lut.Apply(bgr_image, mask);
+
+    ASSERT_EQ(mask.size(), bgr_image.size());
+    ASSERT_EQ(mask.type(), CV_8UC1);
+    EXPECT_EQ(cv::countNonZero(mask != expected_mask), 0);
+    EXPECT_GT(cv::countNonZero(expected_mask), 0);
+}
+}
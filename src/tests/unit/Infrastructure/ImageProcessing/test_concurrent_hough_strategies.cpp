@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Infrastructure/ImageProcessing/ImageProcessor.h"
+
+namespace PiTrac
+{
+// Waits until cancelled is set, for at most a few seconds.  Returns true if
+// it was set.
+static bool WaitForCancellation(const std::atomic<bool> &cancelled)
+{
+    auto give_up_time = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+
+    while (!cancelled.load() && std::chrono::steady_clock::now() < give_up_time)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return cancelled.load();
+}
+
+// The configured (first) Hough strategy wins whenever it passes, even if the
+// other one finishes first, and it is never cancelled by a later one
+TEST(ConcurrentHoughStrategiesTest, LowestPassingStrategyWins) {
+    std::atomic<bool> first_was_cancelled{ false };
+
+    int winner = BallImageProc::RunConcurrentStrategies(2,
+                                                        [&](size_t i,
+                                                            const std::atomic<bool> &cancelled)
+        {
+            if (i == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                first_was_cancelled = cancelled.load();
+            }
+
+            return true;
+        });
+
+    EXPECT_EQ(winner, 0);
+    EXPECT_FALSE(first_was_cancelled);
+
+    // The first strategy fails, so the second one wins
+    winner = BallImageProc::RunConcurrentStrategies(2, [](size_t i, const std::atomic<bool> &)
+        {
+            return i == 1;
+        });
+
+    EXPECT_EQ(winner, 1);
+}
+
+// Once a strategy passes, the later ones are cancelled, and the call still
+// waits for them to finish before returning
+TEST(ConcurrentHoughStrategiesTest, CancelsAndWaitsForLaterStrategies) {
+    std::atomic<bool> later_was_cancelled{ false };
+    std::atomic<int> number_finished{ 0 };
+
+    int winner = BallImageProc::RunConcurrentStrategies(3,
+                                                        [&](size_t i,
+                                                            const std::atomic<bool> &cancelled)
+        {
+            if (i == 2)
+            {
+                later_was_cancelled = WaitForCancellation(cancelled);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+
+            number_finished++;
+            return i == 1 || (i == 2 && !later_was_cancelled);
+        });
+
+    EXPECT_EQ(winner, 1);
+    EXPECT_TRUE(later_was_cancelled);
+    EXPECT_EQ(number_finished.load(), 3);
+}
+
+// With no strategy passing, there is no winner
+TEST(ConcurrentHoughStrategiesTest, NoWinnerIfNoStrategyPasses) {
+    std::atomic<int> number_run{ 0 };
+
+    int winner = BallImageProc::RunConcurrentStrategies(2,
+                                                        [&](size_t, const std::atomic<bool> &)
+        {
+            number_run++;
+            return false;
+        });
+
+    EXPECT_EQ(winner, -1);
+    EXPECT_EQ(number_run.load(), 2);
+}
+}
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdlib>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/EdgeDrawing/ED.h"
+#include "Infrastructure/ImageProcessing/EdgeDrawing/EDPF.h"
+
+namespace PiTrac
+{
+class EDGradientTest : public ::testing::Test
+{
+  protected:
+    // Noisy image with some edges in it.  The width is not a multiple of the
+    // vector size, so the scalar kernel also does part of each row.
+    static cv::Mat MakeImage()
+    {
+        cv::Mat image(97, 203, CV_8UC1);
+        cv::RNG rng(1234);
+        rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+        cv::circle(image, cv::Point(100, 48), 30, cv::Scalar(255), -1);
+        cv::rectangle(image, cv::Rect(10, 10, 40, 60), cv::Scalar(0), -1);
+        return image;
+    }
+
+    // Per-pixel gradient, as ED has always computed it.  Scharr has always
+    // ended up with the LSD result.
+    static cv::Mat ReferenceGradient(const cv::Mat &smooth,
+                                     GradientOperator op,
+                                     int grad_thresh,
+                                     bool sum_flag)
+    {
+        cv::Mat grad(smooth.size(), CV_16SC1, cv::Scalar(grad_thresh - 1));
+
+        for (int i = 1; i < smooth.rows - 1; i++)
+        {
+            for (int j = 1; j < smooth.cols - 1; j++)
+            {
+                auto p = [&](int r, int c)
+                         {
+                             return (int)smooth.at<uchar>(r, c);
+                         };
+
+                int gx;
+                int gy;
+
+                if (op == PREWITT_OPERATOR || op == SOBEL_OPERATOR)
+                {
+                    int weight = (op == SOBEL_OPERATOR) ? 2 : 1;
+                    gx = std::abs((p(i - 1, j + 1) - p(i - 1, j - 1)) +
+                                  weight * (p(i, j + 1) - p(i, j - 1)) +
+                                  (p(i + 1, j + 1) - p(i + 1, j - 1)));
+                    gy = std::abs((p(i + 1, j - 1) - p(i - 1, j - 1)) +
+                                  weight * (p(i + 1, j) - p(i - 1, j)) +
+                                  (p(i + 1, j + 1) - p(i - 1, j + 1)));
+                }
+                else
+                {
+                    gx = std::abs((p(i, j + 1) - p(i, j)) + (p(i + 1, j + 1) - p(i + 1, j)));
+                    gy = std::abs((p(i + 1, j) - p(i, j)) + (p(i + 1, j + 1) - p(i, j + 1)));
+                }
+
+                grad.at<short>(i, j) = sum_flag ? (short)(gx + gy) :
+                                       (short)std::sqrt((double)gx * gx + gy * gy);
+            }
+        }
+
+        return grad;
+    }
+};
+
+// The specialized (and vectorized) kernels must give exactly the same
+// gradient image for every operator
+TEST_F(EDGradientTest, MatchesPerPixelGradient) {
+    cv::Mat image = MakeImage();
+    const int kGradThresh = 20;
+
+    for (GradientOperator op : { PREWITT_OPERATOR, SOBEL_OPERATOR, SCHARR_OPERATOR,
+                                 LSD_OPERATOR })
+    {
+        for (bool sum_flag : { true, false })
+        {
+            ED ed(image, op, kGradThresh, 0, 1, 10, 1.0, sum_flag);
+
+            cv::Mat expected;
+            cv::convertScaleAbs(ReferenceGradient(ed.getSmoothImage(), op, kGradThresh,
+                                                  sum_flag), expected);
+
+            EXPECT_EQ(cv::countNonZero(ed.getGradImage() != expected), 0)
+                << "operator " << op << ", sum " << sum_flag;
+        }
+    }
+}
+
+// Reusing a workspace must not change the result
+TEST_F(EDGradientTest, WorkspaceGivesSameEdges) {
+    cv::Mat image = MakeImage();
+    EDWorkspace workspace;
+
+    ED without_workspace(image);
+
+    for (int i = 0; i < 2; i++)
+    {
+        ED with_workspace(image, PREWITT_OPERATOR, 20, 0, 1, 10, 1.0, true, &workspace);
+
+        EXPECT_EQ(cv::countNonZero(with_workspace.getEdgeImage() !=
+                                   without_workspace.getEdgeImage()), 0);
+        EXPECT_EQ(with_workspace.getSegmentNo(), without_workspace.getSegmentNo());
+    }
+}
+
+// A workspace grows for a bigger image and is then reused for a smaller one
+// (and by EDPF), without that changing any result
+TEST_F(EDGradientTest, WorkspaceReusedAcrossImageSizes) {
+    cv::Mat small_image = MakeImage();
+    cv::Mat large_image;
+    cv::resize(small_image, large_image, cv::Size(), 2.0, 2.0, cv::INTER_LINEAR);
+
+    EDWorkspace workspace;
+
+    for (const cv::Mat &image : { small_image, large_image, small_image })
+    {
+        ED without_workspace(image);
+        ED with_workspace(image, PREWITT_OPERATOR, 20, 0, 1, 10, 1.0, true, &workspace);
+
+        EXPECT_EQ(cv::countNonZero(with_workspace.getEdgeImage() !=
+                                   without_workspace.getEdgeImage()), 0) << image.size();
+        EXPECT_EQ(with_workspace.getSegmentNo(), without_workspace.getSegmentNo());
+
+        EDPF edpf_without_workspace(image);
+        EDPF edpf_with_workspace(image, &workspace);
+
+        EXPECT_EQ(cv::countNonZero(edpf_with_workspace.getEdgeImage() !=
+                                   edpf_without_workspace.getEdgeImage()), 0) << image.size();
+        EXPECT_EQ(edpf_with_workspace.getSegmentNo(), edpf_without_workspace.getSegmentNo());
+    }
+}
+}
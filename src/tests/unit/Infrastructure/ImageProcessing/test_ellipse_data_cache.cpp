@@ -0,0 +1,304 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <unordered_map>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/EllipseDetector/EllipseDataCache.h"
+#include "Infrastructure/ImageProcessing/EllipseDetector/EllipseDetectorYaed.h"
+
+// Every heap allocation in this test program is counted, so that the
+// benchmark can report how many each approach makes
+static std::atomic<size_t> allocation_count{ 0 };
+
+void *operator new(std::size_t size)
+{
+    allocation_count++;
+
+    void *p = std::malloc(size == 0 ? 1 : size);
+
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+namespace PiTrac
+{
+class EllipseDataCacheTest : public ::testing::Test
+{
+  protected:
+    // Same packing as CEllipseDetectorYaed::GenerateKey
+    static unsigned Key(unsigned pair, unsigned u, unsigned v)
+    {
+        return (pair << 30) + (u << 15) + v;
+    }
+
+    // Ball-like discs with some noise, similar to what the detector is used on
+    static std::vector<cv::Mat> MakeImages()
+    {
+        std::vector<cv::Mat> images;
+        cv::RNG rng(2468);
+
+        for (int i = 0; i < 4; i++)
+        {
+            cv::Mat image(480, 640, CV_8UC1, cv::Scalar(40));
+            cv::circle(image,
+                       cv::Point(200 + 60 * i, 240 - 20 * i),
+                       50 + 5 * i,
+                       cv::Scalar(200),
+                       cv::FILLED);
+            cv::Mat noise(image.size(), CV_8UC1);
+            rng.fill(noise, cv::RNG::NORMAL, 0, 8);
+            image += noise;
+            images.push_back(image);
+        }
+
+        return images;
+    }
+
+    // The project's test images, if PITRAC_TEST_IMAGE_DIR names a directory of
+    // them
+    static std::vector<cv::Mat> LoadTestImages()
+    {
+        std::vector<cv::Mat> images;
+        const char *directory = std::getenv("PITRAC_TEST_IMAGE_DIR");
+
+        if (directory == nullptr || !std::filesystem::is_directory(directory))
+        {
+            return images;
+        }
+
+        for (const auto &entry : std::filesystem::directory_iterator(directory))
+        {
+            cv::Mat image = cv::imread(entry.path().string(), cv::IMREAD_GRAYSCALE);
+
+            if (!image.empty())
+            {
+                images.push_back(image);
+            }
+        }
+
+        return images;
+    }
+};
+
+TEST_F(EllipseDataCacheTest, FindsWhatWasInserted) {
+    EllipseDataCache cache;
+
+    // More than the initial capacity, so that the table has to grow
+    const unsigned kArcs = 100;
+
+    for (unsigned u = 0; u < kArcs; u++)
+    {
+        for (unsigned v = 0; v < kArcs; v += 3)
+        {
+            EllipseData data{};
+            data.ta = (float)(u * 1000 + v);
+            data.Sa = cache.AllocateSlopes(u % 9);
+
+            for (size_t i = 0; i < data.Sa.size(); i++)
+            {
+                data.Sa[i] = (float)(u + v + i);
+            }
+
+            cache.Insert(Key(u % 4, u, v), data);
+        }
+    }
+
+    for (unsigned u = 0; u < kArcs; u++)
+    {
+        for (unsigned v = 0; v < kArcs; v++)
+        {
+            const EllipseData *data = cache.Find(Key(u % 4, u, v));
+
+            if (v % 3 != 0)
+            {
+                EXPECT_EQ(data, nullptr);
+                continue;
+            }
+
+            ASSERT_NE(data, nullptr);
+            EXPECT_EQ(data->ta, (float)(u * 1000 + v));
+            ASSERT_EQ(data->Sa.size(), (size_t)(u % 9));
+
+            for (size_t i = 0; i < data->Sa.size(); i++)
+            {
+                EXPECT_EQ(data->Sa[i], (float)(u + v + i));
+            }
+        }
+    }
+
+    // Nothing survives a reset, and refilling the cache does not allocate
+    size_t size_before_reset = cache.Size();
+    cache.Reset();
+    EXPECT_EQ(cache.Size(), 0u);
+    EXPECT_EQ(cache.Find(Key(0, 0, 0)), nullptr);
+
+    size_t allocations_before = allocation_count;
+
+    for (unsigned u = 0; u < kArcs; u++)
+    {
+        for (unsigned v = 0; v < kArcs; v += 3)
+        {
+            EllipseData data{};
+            data.Sa = cache.AllocateSlopes(u % 9);
+            cache.Insert(Key(u % 4, u, v), data);
+        }
+    }
+
+    EXPECT_EQ(cache.Size(), size_before_reset);
+    EXPECT_EQ(allocation_count - allocations_before, 0u);
+}
+
+// Micro-benchmark of the cache against the unordered_map (with a vector for
+// each slope array) that the detector used to use, and of the whole detector
+// on a sequence of frames
+TEST_F(EllipseDataCacheTest, EllipseDataCacheBenchmark) {
+    struct VectorEllipseData
+    {
+        bool isValid;
+        float ta;
+        float tb;
+        float ra;
+        float rb;
+        cv::Point2f Ma;
+        cv::Point2f Mb;
+        cv::Point2f Cab;
+        std::vector<float> Sa;
+        std::vector<float> Sb;
+    };
+
+    const int kFrames = 20;
+    const unsigned kArcs = 60;
+    const unsigned kSlopes = 8;   // _uNs / 2 for the default of 16
+
+    // Each frame inserts the data for every pair of arcs and then looks each
+    // one up again, as the next triplet pass would
+    auto start = std::chrono::steady_clock::now();
+    size_t allocations_start = allocation_count;
+    float checksum_map = 0.0f;
+
+    for (int frame = 0; frame < kFrames; frame++)
+    {
+        std::unordered_map<unsigned, VectorEllipseData> data;
+
+        for (unsigned u = 0; u < kArcs; u++)
+        {
+            for (unsigned v = 0; v < kArcs; v++)
+            {
+                VectorEllipseData d{};
+                d.Sa.assign(kSlopes, (float)u);
+                d.Sb.assign(kSlopes, (float)v);
+                data.insert(std::pair<unsigned, VectorEllipseData>(Key(0, u, v), d));
+            }
+        }
+
+        for (unsigned u = 0; u < kArcs; u++)
+        {
+            for (unsigned v = 0; v < kArcs; v++)
+            {
+                VectorEllipseData d = data.at(Key(0, u, v));
+                checksum_map += d.Sa[0] + d.Sb[0];
+            }
+        }
+    }
+
+    auto middle = std::chrono::steady_clock::now();
+    size_t allocations_middle = allocation_count;
+    float checksum_cache = 0.0f;
+    EllipseDataCache cache;
+
+    for (int frame = 0; frame < kFrames; frame++)
+    {
+        cache.Reset();
+
+        for (unsigned u = 0; u < kArcs; u++)
+        {
+            for (unsigned v = 0; v < kArcs; v++)
+            {
+                EllipseData d{};
+                d.Sa = cache.AllocateSlopes(kSlopes);
+                d.Sb = cache.AllocateSlopes(kSlopes);
+                std::fill(d.Sa.begin(), d.Sa.end(), (float)u);
+                std::fill(d.Sb.begin(), d.Sb.end(), (float)v);
+                cache.Insert(Key(0, u, v), d);
+            }
+        }
+
+        for (unsigned u = 0; u < kArcs; u++)
+        {
+            for (unsigned v = 0; v < kArcs; v++)
+            {
+                EllipseData d = *cache.Find(Key(0, u, v));
+                checksum_cache += d.Sa[0] + d.Sb[0];
+            }
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    size_t allocations_end = allocation_count;
+
+    EXPECT_EQ(checksum_map, checksum_cache);
+    EXPECT_LT(allocations_end - allocations_middle, allocations_middle - allocations_start);
+
+    double map_ms = std::chrono::duration<double, std::milli>(middle - start).count() / kFrames;
+    double cache_ms = std::chrono::duration<double, std::milli>(end - middle).count() / kFrames;
+
+    std::cout << std::fixed << std::setprecision(3)
+              << kArcs * kArcs << " arc pairs per frame: unordered_map " << map_ms << "ms and "
+              << (allocations_middle - allocations_start) / kFrames
+              << " allocations per frame, EllipseDataCache " << cache_ms << "ms and "
+              << (allocations_end - allocations_middle) / kFrames
+              << " allocations per frame.\n";
+
+    // The whole detector.  The first frame grows the per-thread cache, and
+    // the later ones reuse it.
+    std::vector<cv::Mat> images = LoadTestImages();
+
+    if (images.empty())
+    {
+        images = MakeImages();
+    }
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        size_t allocations_before = allocation_count;
+        auto detect_start = std::chrono::steady_clock::now();
+        size_t ellipse_count = 0;
+
+        for (const cv::Mat &image : images)
+        {
+            CEllipseDetectorYaed detector;
+            std::vector<Ellipse> ellipses;
+            cv::Mat working_image = image.clone();
+            detector.Detect(working_image, ellipses);
+            ellipse_count += ellipses.size();
+        }
+
+        double detect_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - detect_start).count() / images.size();
+
+        std::cout << "Detect over " << images.size() << " images (" <<
+            (pass == 0 ? "cold" : "warm") << "): " << detect_ms << "ms and " <<
+            (allocation_count - allocations_before) / images.size() <<
+            " allocations per image, " << ellipse_count << " ellipses.\n";
+    }
+}
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+#include <cmath>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/EllipseDetector/EllipseDetectorYaed.h"
+
+namespace PiTrac
+{
+class EllipseDetectorYaedTest : public ::testing::Test
+{
+  protected:
+    // Ball-like discs with some noise, similar to what the detector is used on
+    static std::vector<cv::Mat> MakeImages()
+    {
+        std::vector<cv::Mat> images;
+        cv::RNG rng(2468);
+
+        for (int i = 0; i < 4; i++)
+        {
+            cv::Mat image(480, 640, CV_8UC1, cv::Scalar(40));
+            cv::circle(image,
+                       cv::Point(200 + 60 * i, 240 - 20 * i),
+                       50 + 5 * i,
+                       cv::Scalar(200),
+                       cv::FILLED);
+            cv::Mat noise(image.size(), CV_8UC1);
+            rng.fill(noise, cv::RNG::NORMAL, 0, 8);
+            image += noise;
+            images.push_back(image);
+        }
+
+        return images;
+    }
+};
+
+// Each parallel triplet pass runs on its own copy of the detector.  The
+// result must not depend on thread timing, must still find the balls, and
+// must leave the detector itself as it was.
+TEST_F(EllipseDetectorYaedTest, ParallelTripletsAreRepeatable) {
+    auto same_ellipses = [](const std::vector<Ellipse> &a, const std::vector<Ellipse> &b)
+        {
+            if (a.size() != b.size())
+            {
+                return false;
+            }
+
+            for (size_t i = 0; i < a.size(); i++)
+            {
+                if (a[i]._xc != b[i]._xc || a[i]._yc != b[i]._yc || a[i]._a != b[i]._a ||
+                    a[i]._b != b[i]._b || a[i]._rad != b[i]._rad || a[i]._score != b[i]._score)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        };
+
+    auto has_ellipse_near = [](const std::vector<Ellipse> &ellipses, const cv::Point2f &center)
+        {
+            for (const Ellipse &e : ellipses)
+            {
+                if (std::hypot(e._xc - center.x, e._yc - center.y) < 5.0)
+                {
+                    return true;
+                }
+            }
+
+            return false;
+        };
+
+    std::vector<cv::Mat> images = MakeImages();
+
+    for (size_t i = 0; i < images.size(); i++)
+    {
+        // Same as in MakeImages
+        cv::Point2f center(200.0f + 60.0f * i, 240.0f - 20.0f * i);
+
+        CEllipseDetectorYaed serial_detector;
+        std::vector<Ellipse> serial_ellipses;
+        cv::Mat working_image = images[i].clone();
+        serial_detector.Detect(working_image, serial_ellipses);
+
+        CEllipseDetectorYaed detector;
+        detector.SetParallelTriplets(true);
+
+        std::vector<std::vector<Ellipse> > parallel_ellipses(3);
+
+        for (std::vector<Ellipse> &ellipses : parallel_ellipses)
+        {
+            working_image = images[i].clone();
+            detector.Detect(working_image, ellipses);
+        }
+
+        EXPECT_TRUE(same_ellipses(parallel_ellipses[0], parallel_ellipses[1])) << "image " << i;
+        EXPECT_TRUE(same_ellipses(parallel_ellipses[0], parallel_ellipses[2])) << "image " << i;
+
+        if (has_ellipse_near(serial_ellipses, center))
+        {
+            EXPECT_TRUE(has_ellipse_near(parallel_ellipses[0], center)) << "image " << i;
+        }
+
+        // The copies had their own accumulators, so the same detector still
+        // gives the sequential result
+        detector.SetParallelTriplets(false);
+        std::vector<Ellipse> ellipses;
+        working_image = images[i].clone();
+        detector.Detect(working_image, ellipses);
+
+        EXPECT_TRUE(same_ellipses(ellipses, serial_ellipses)) << "image " << i;
+    }
+}
+}
@@ -0,0 +1,93 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/HoughCircleAccumulator.h"
+
+namespace PiTrac
+{
+class HoughCircleAccumulatorTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        // A few filled, ball-like discs on a dark background
+        image = cv::Mat::zeros(480, 640, CV_8UC1);
+
+        for (const cv::Vec3f &ball : balls)
+        {
+            cv::circle(image,
+                       cv::Point((int)ball[0], (int)ball[1]),
+                       (int)ball[2],
+                       cv::Scalar(200),
+                       cv::FILLED);
+        }
+
+        cv::GaussianBlur(image, image, cv::Size(5, 5), 0);
+    }
+
+    // Returns true if circles has one that is close to ball
+    static bool HasCircleNear(const std::vector<cv::Vec3f> &circles, const cv::Vec3f &ball)
+    {
+        return std::any_of(circles.begin(), circles.end(), [&](const cv::Vec3f &c)
+            {
+                return std::abs(c[0] - ball[0]) <= 3.0f && std::abs(c[1] - ball[1]) <= 3.0f &&
+                       std::abs(c[2] - ball[2]) <= 3.0f;
+            });
+    }
+
+    cv::Mat image;
+    const std::vector<cv::Vec3f> balls = { cv::Vec3f(150, 150, 40),
+                                           cv::Vec3f(400, 200, 45),
+                                           cv::Vec3f(300, 360, 35) };
+};
+
+TEST_F(HoughCircleAccumulatorTest, FindsDrawnCircles) {
+    std::vector<HoughCircleCandidate> candidates;
+    HoughCircleAccumulator::Detect(image, cv::HOUGH_GRADIENT, 1.0, 100, 25, 60, 10, candidates);
+    ASSERT_FALSE(candidates.empty());
+
+    std::vector<cv::Vec3f> circles;
+    HoughCircleAccumulator::Select(candidates, cv::HOUGH_GRADIENT, 30, 30, circles);
+
+    for (const cv::Vec3f &ball : balls)
+    {
+        EXPECT_TRUE(HasCircleNear(circles, ball)) << "Missing ball at " << ball;
+    }
+
+    // The same candidates also work with a coverage threshold
+    HoughCircleAccumulator::Detect(image, cv::HOUGH_GRADIENT_ALT, 1.0, 300, 25, 60, 10,
+                                   candidates);
+    HoughCircleAccumulator::Select(candidates, cv::HOUGH_GRADIENT_ALT, 0.8, 30, circles);
+
+    for (const cv::Vec3f &ball : balls)
+    {
+        EXPECT_TRUE(HasCircleNear(circles, ball)) << "Missing ALT ball at " << ball;
+    }
+}
+
+// Tightening param2 over the same candidates can only remove circles, which
+// is what the GetBall param2 loop relies on
+TEST_F(HoughCircleAccumulatorTest, TighterThresholdGivesSubset) {
+    std::vector<HoughCircleCandidate> candidates;
+    HoughCircleAccumulator::Detect(image, cv::HOUGH_GRADIENT, 1.2, 100, 25, 60, 5, candidates);
+
+    std::vector<cv::Vec3f> previous_circles;
+    HoughCircleAccumulator::Select(candidates, cv::HOUGH_GRADIENT, 5, 20, previous_circles);
+
+    for (double param2 = 10; param2 <= 200; param2 += 10)
+    {
+        std::vector<cv::Vec3f> circles;
+        HoughCircleAccumulator::Select(candidates, cv::HOUGH_GRADIENT, param2, 20, circles);
+
+        EXPECT_LE(circles.size(), previous_circles.size());
+
+        for (const cv::Vec3f &c : circles)
+        {
+            EXPECT_NE(std::find(previous_circles.begin(), previous_circles.end(), c),
+                      previous_circles.end());
+        }
+
+        previous_circles = circles;
+    }
+}
+}
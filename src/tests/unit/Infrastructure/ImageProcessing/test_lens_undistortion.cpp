@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/CircleRefiner.h"
+#include "Infrastructure/ImageProcessing/LensUndistortion.h"
+#include "Infrastructure/ImageProcessing/UndistortionMapCache.h"
+
+namespace PiTrac
+{
+class LensUndistortionTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        calibration_matrix = (cv::Mat_<double>(3, 3) <<
+                              1000.0, 0.0, 728.0,
+                              0.0, 1000.0, 544.0,
+                              0.0, 0.0, 1.0);
+        distortion_vector = (cv::Mat_<double>(1, 5) << -0.5, 0.3, 0.0, 0.0, -0.1);
+    }
+
+    // Where the (undistorted) circle appears in the raw camera image
+    cv::Vec3f DistortCircle(const cv::Vec3f &circle) const
+    {
+        std::vector<cv::Point3f> rays;
+
+        for (int i = 0; i < 180; i++)
+        {
+            double angle = 2.0 * CV_PI * i / 180;
+            double x = circle[0] + circle[2] * std::cos(angle);
+            double y = circle[1] + circle[2] * std::sin(angle);
+            rays.emplace_back((float)((x - calibration_matrix.at<double>(0, 2)) /
+                                      calibration_matrix.at<double>(0, 0)),
+                              (float)((y - calibration_matrix.at<double>(1, 2)) /
+                                      calibration_matrix.at<double>(1, 1)),
+                              1.0f);
+        }
+
+        std::vector<cv::Point2f> distorted_points;
+        cv::projectPoints(rays, cv::Vec3d(0, 0, 0), cv::Vec3d(0, 0, 0), calibration_matrix,
+                          distortion_vector, distorted_points);
+
+        cv::Vec3f distorted_circle;
+        CircleRefiner::FitCircleAlgebraic(distorted_points, distorted_circle);
+        return distorted_circle;
+    }
+
+    cv::Mat calibration_matrix;
+    cv::Mat distortion_vector;
+};
+
+TEST_F(LensUndistortionTest, RecoversUndistortedCircle) {
+    const std::vector<cv::Vec3f> circles = { cv::Vec3f(728.0f, 544.0f, 40.0f),
+                                             cv::Vec3f(400.5f, 300.25f, 55.0f),
+                                             cv::Vec3f(1200.0f, 900.0f, 30.0f) };
+
+    for (const cv::Vec3f &circle : circles)
+    {
+        cv::Vec3f distorted = DistortCircle(circle);
+        cv::Vec3f undistorted;
+
+        ASSERT_TRUE(LensUndistortion::UndistortCircle(distorted,
+                                                      calibration_matrix,
+                                                      distortion_vector,
+                                                      undistorted));
+
+        EXPECT_NEAR(undistorted[0], circle[0], 0.25f) << circle;
+        EXPECT_NEAR(undistorted[1], circle[1], 0.25f) << circle;
+        EXPECT_NEAR(undistorted[2], circle[2], 0.25f) << circle;
+    }
+}
+
+TEST_F(LensUndistortionTest, RejectsEmptyCircle) {
+    cv::Vec3f undistorted;
+    EXPECT_FALSE(LensUndistortion::UndistortCircle(cv::Vec3f(100.0f, 100.0f, 0.0f),
+                                                   calibration_matrix,
+                                                   distortion_vector,
+                                                   undistorted));
+}
+
+// Not a pass/fail test - compares undistorting just the ball with
+// undistorting the whole frame
+TEST_F(LensUndistortionTest, CompareWithImageRemapBenchmark) {
+    const int iterations = 50;
+
+    cv::Mat image(1088, 1456, CV_8UC3, cv::Scalar(40, 40, 40));
+    UndistortionMapCache cache;
+    cv::Mat undistorted_image;
+    cache.Undistort(image, 1, calibration_matrix, distortion_vector, undistorted_image);
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        cache.Undistort(image, 1, calibration_matrix, distortion_vector, undistorted_image);
+    }
+
+    auto remap_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+    cv::Vec3f undistorted_circle;
+    start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        LensUndistortion::UndistortCircle(cv::Vec3f(400.0f, 300.0f, 50.0f),
+                                          calibration_matrix,
+                                          distortion_vector,
+                                          undistorted_circle);
+    }
+
+    auto circle_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+    std::cout << "Full-frame remap (cached maps): " << remap_ms << " ms" << std::endl;
+    std::cout << "Circle undistortion: " << circle_ms << " ms" << std::endl;
+}
+}
@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/ScopedBallSearchSettings.h"
+
+namespace PiTrac
+{
+// A sub-image search starts without a color mask and with its own radius
+// limits, and the searcher's own settings are back afterwards, even if the
+// search throws
+TEST(ScopedBallSearchSettingsTest, RestoresSearchSettings) {
+    cv::Mat color_mask_image(480, 640, CV_8UC1, cv::Scalar(255));
+    const uchar *color_mask_data = color_mask_image.data;
+    int min_ball_radius = 20;
+    int max_ball_radius = 60;
+
+    {
+        ScopedBallSearchSettings settings(color_mask_image, min_ball_radius, max_ball_radius,
+                                          8, 30);
+        EXPECT_TRUE(color_mask_image.empty());
+        EXPECT_EQ(min_ball_radius, 8);
+        EXPECT_EQ(max_ball_radius, 30);
+
+        // What GetBall does when it has no mask
+        color_mask_image = cv::Mat(100, 100, CV_8UC1, cv::Scalar(0));
+        min_ball_radius = 1;
+    }
+
+    EXPECT_EQ(color_mask_image.data, color_mask_data);
+    EXPECT_EQ(color_mask_image.size(), cv::Size(640, 480));
+    EXPECT_EQ(min_ball_radius, 20);
+    EXPECT_EQ(max_ball_radius, 60);
+
+    // Scaled-down limits stay usable
+    try {
+        ScopedBallSearchSettings settings(color_mask_image, min_ball_radius, max_ball_radius,
+                                          0, 0);
+        EXPECT_EQ(min_ball_radius, 1);
+        EXPECT_EQ(max_ball_radius, 2);
+        throw std::runtime_error("search failed");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    EXPECT_EQ(color_mask_image.data, color_mask_data);
+    EXPECT_EQ(min_ball_radius, 20);
+    EXPECT_EQ(max_ball_radius, 60);
+}
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/SearchImagePreprocessor.h"
+
+namespace PiTrac
+{
+class SearchImagePreprocessorTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        lut.Build(lower_hsv, upper_hsv, InRangeMask);
+    }
+
+    static cv::Mat InRangeMask(const cv::Mat &hsv_image)
+    {
+        cv::Mat mask;
+        cv::inRange(hsv_image, lower_hsv, upper_hsv, mask);
+        return mask;
+    }
+
+    // Smooth-ish color image with some structure, so that the blur matters
+    static cv::Mat MakeImage(int rows, int cols)
+    {
+        cv::Mat image(rows, cols, CV_8UC3);
+        cv::RNG rng(4321);
+        rng.fill(image, cv::RNG::UNIFORM, 0, 256);
+        cv::GaussianBlur(image, image, cv::Size(5, 5), 0);
+        return image;
+    }
+
+    // The whole-image chain that GetBall uses without the fused preprocessing.
+    // The color mask comes from color_mask_lut if it is not null (as with
+    // kUseColorMaskLut), and from the HSV image otherwise.
+    static void RunWholeImageChain(const cv::Mat &bgr_image,
+                                   int blur_size,
+                                   const ColorMaskLut *color_mask_lut,
+                                   cv::Mat &search_image)
+    {
+        cv::Mat blurred;
+
+        if (blur_size > 0)
+        {
+            cv::GaussianBlur(bgr_image, blurred, cv::Size(blur_size, blur_size), 0);
+        }
+        else
+        {
+            blurred = bgr_image.clone();
+        }
+
+        cv::Mat color_mask;
+
+        if (color_mask_lut != nullptr)
+        {
+            color_mask_lut->Apply(blurred, color_mask);
+        }
+        else
+        {
+            cv::Mat hsv_image;
+            cv::cvtColor(blurred, hsv_image, cv::COLOR_BGR2HSV);
+            color_mask = InRangeMask(hsv_image);
+        }
+
+        cv::Mat gray_image;
+        cv::cvtColor(blurred, gray_image, cv::COLOR_BGR2GRAY);
+
+        search_image = cv::Mat::zeros(gray_image.size(), gray_image.type());
+        cv::bitwise_and(gray_image, color_mask, search_image);
+    }
+
+    static inline const cv::Scalar lower_hsv = cv::Scalar(0, 30, 40);
+    static inline const cv::Scalar upper_hsv = cv::Scalar(90, 255, 255);
+
+    ColorMaskLut lut;
+};
+
+// Strips must give exactly the whole-image result, including for a number of
+// rows that is not a multiple of the strip size
+TEST_F(SearchImagePreprocessorTest, MatchesWholeImageOperations) {
+    cv::Mat bgr_image = MakeImage(203, 157);
+
+    for (int blur_size : { 0, 7 })
+    {
+        cv::Mat blurred = bgr_image.clone();
+
+        if (blur_size > 0)
+        {
+            cv::GaussianBlur(bgr_image, blurred, cv::Size(blur_size, blur_size), 0);
+        }
+
+        cv::Mat expected_mask;
+        lut.Apply(blurred, expected_mask);
+        cv::Mat expected_gray;
+        cv::cvtColor(blurred, expected_gray, cv::COLOR_BGR2GRAY);
+        cv::Mat expected_search_image;
+        cv::bitwise_and(expected_gray, expected_mask, expected_search_image);
+
+        cv::Mat search_image;
+        cv::Mat color_mask;
+        SearchImagePreprocessor::Process(bgr_image, blur_size, &lut, search_image, color_mask);
+
+        EXPECT_EQ(cv::countNonZero(color_mask != expected_mask), 0) << "blur " << blur_size;
+        EXPECT_EQ(cv::countNonZero(search_image != expected_search_image), 0) << "blur " <<
+            blur_size;
+
+        // Without a color mask, the search image is just the gray image
+        SearchImagePreprocessor::Process(bgr_image, blur_size, nullptr, search_image, color_mask);
+        EXPECT_EQ(cv::countNonZero(search_image != expected_gray), 0) << "blur " << blur_size;
+    }
+}
+
+// The exact HSV masking must give the whole-image HSV mask, which the table
+// lookup only approximates
+TEST_F(SearchImagePreprocessorTest, HsvMaskMatchesWholeImageOperations) {
+    cv::Mat bgr_image = MakeImage(203, 157);
+
+    for (int blur_size : { 0, 7 })
+    {
+        cv::Mat blurred = bgr_image.clone();
+
+        if (blur_size > 0)
+        {
+            cv::GaussianBlur(bgr_image, blurred, cv::Size(blur_size, blur_size), 0);
+        }
+
+        cv::Mat hsv_image;
+        cv::cvtColor(blurred, hsv_image, cv::COLOR_BGR2HSV);
+        cv::Mat expected_mask = InRangeMask(hsv_image);
+
+        cv::Mat expected_search_image;
+        RunWholeImageChain(bgr_image, blur_size, nullptr, expected_search_image);
+
+        cv::Mat search_image;
+        cv::Mat color_mask;
+        SearchImagePreprocessor::ProcessWithHsvMask(bgr_image, blur_size, InRangeMask,
+                                                    search_image, color_mask);
+
+        EXPECT_EQ(cv::countNonZero(color_mask != expected_mask), 0) << "blur " << blur_size;
+        EXPECT_EQ(cv::countNonZero(search_image != expected_search_image), 0) << "blur " <<
+            blur_size;
+    }
+}
+
+// Micro-benchmark of the fused preprocessing against the whole-image chains
+// for a full-size camera frame.  The default chain (HSV image, color mask,
+// then the whole-image ops) is timed against both fused paths - the color
+// mask table one, and the HSV one that is used when kUseColorMaskLut is off.
+TEST_F(SearchImagePreprocessorTest, FusedPreprocessingBenchmark) {
+    const int kIterations = 20;
+    const int kBlurSize = 7;
+    cv::Mat bgr_image = MakeImage(1088, 1456);
+
+    cv::Mat hsv_chain_search_image;
+    cv::Mat lut_chain_search_image;
+    cv::Mat hsv_fused_search_image;
+    cv::Mat lut_fused_search_image;
+    cv::Mat color_mask;
+
+    // Warm up every path (and the scratch buffers) before timing anything.
+    // Each fused result must be the same as its chain's, or the timing means
+    // nothing.
+    RunWholeImageChain(bgr_image, kBlurSize, nullptr, hsv_chain_search_image);
+    SearchImagePreprocessor::ProcessWithHsvMask(bgr_image, kBlurSize, InRangeMask,
+                                                hsv_fused_search_image, color_mask);
+    ASSERT_EQ(cv::countNonZero(hsv_fused_search_image != hsv_chain_search_image), 0);
+
+    RunWholeImageChain(bgr_image, kBlurSize, &lut, lut_chain_search_image);
+    SearchImagePreprocessor::Process(bgr_image, kBlurSize, &lut, lut_fused_search_image,
+                                     color_mask);
+    ASSERT_EQ(cv::countNonZero(lut_fused_search_image != lut_chain_search_image), 0);
+
+    auto time_ms = [&](const std::function<void()> &run) {
+        auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < kIterations; i++)
+        {
+            run();
+        }
+
+        return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count() / kIterations;
+    };
+
+    double hsv_chain_ms = time_ms([&] {
+        RunWholeImageChain(bgr_image, kBlurSize, nullptr, hsv_chain_search_image);
+    });
+    double hsv_fused_ms = time_ms([&] {
+        SearchImagePreprocessor::ProcessWithHsvMask(bgr_image, kBlurSize, InRangeMask,
+                                                    hsv_fused_search_image, color_mask);
+    });
+    double lut_fused_ms = time_ms([&] {
+        SearchImagePreprocessor::Process(bgr_image, kBlurSize, &lut, lut_fused_search_image,
+                                         color_mask);
+    });
+
+    auto speedup = [](double chain_ms, double fused_ms) {
+        return fused_ms > 0.0 ? chain_ms / fused_ms : 0.0;
+    };
+
+    std::cout << std::fixed << std::setprecision(3)
+              << "1456x1088 search image preprocessing: " << hsv_chain_ms
+              << "ms whole-image HSV chain, " << hsv_fused_ms << "ms fused with HSV mask ("
+              << speedup(hsv_chain_ms, hsv_fused_ms) << "x), " << lut_fused_ms
+              << "ms fused with color mask table ("
+              << speedup(hsv_chain_ms, lut_fused_ms) << "x).\n";
+
+    EXPECT_GT(hsv_chain_ms, 0.0);
+    EXPECT_GT(hsv_fused_ms, 0.0);
+    EXPECT_GT(lut_fused_ms, 0.0);
+}
+}
@@ -0,0 +1,722 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/ImageProcessor.h"
+
+namespace PiTrac
+{
+class SpinAnalysisTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        // Roughly what IsolateBall produces for a ball with a 60 pixel radius
+        ball.measured_radius_pixels_ = kBallRadius;
+        ball.ball_circle_[2] = (float)kBallRadius;
+        ball.set_x((float)kBallCenter);
+        ball.set_y((float)kBallCenter);
+
+        // Blurred noise thresholded to 0/255 looks enough like a Gabor-filtered
+        // dimple pattern for the purposes of these tests
+        cv::Mat noise(kImageSize, kImageSize, CV_8UC1);
+        cv::RNG rng(12345);
+        rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+        cv::GaussianBlur(noise, noise, cv::Size(7, 7), 0);
+        cv::threshold(noise, dimple_image, 127, 255, cv::THRESH_BINARY);
+
+        cv::Scalar ignoreColor(kPixelIgnoreValue, kPixelIgnoreValue, kPixelIgnoreValue);
+        dimple_image = BallImageProc::MaskAreaOutsideBall(dimple_image, ball, 0.92f, ignoreColor);
+
+        search_space.anglex_rotation_degrees_increment = 6;
+        search_space.anglex_rotation_degrees_start = -12;
+        search_space.anglex_rotation_degrees_end = 12;
+        search_space.angley_rotation_degrees_increment = 5;
+        search_space.angley_rotation_degrees_start = -10;
+        search_space.angley_rotation_degrees_end = 10;
+        search_space.anglez_rotation_degrees_increment = 6;
+        search_space.anglez_rotation_degrees_start = -12;
+        search_space.anglez_rotation_degrees_end = 12;
+    }
+
+    void TearDown() override
+    {
+        BallImageProc::kUseSphereProjectionCache = true;
+        BallImageProc::kSpinPyramidLevels = 1;
+        BallImageProc::kSpinPyramidLevelXIncrementDegrees.clear();
+        BallImageProc::kSpinPyramidLevelYIncrementDegrees.clear();
+        BallImageProc::kSpinPyramidLevelZIncrementDegrees.clear();
+        BallImageProc::kUseBranchAndBoundCandidateScoring = true;
+        BallImageProc::kSpinPriorDriverRange.clear();
+        BallImageProc::ClearSpinPriorHistory();
+    }
+
+    // Returns the wall time per candidate in milliseconds
+    double TimeCandidateImages(bool use_projection_cache,
+                               std::vector<RotationCandidate> &candidates)
+    {
+        BallImageProc::kUseSphereProjectionCache = use_projection_cache;
+
+        cv::Mat candidate_elements_mat;
+        cv::Vec3i candidate_elements_mat_size;
+        candidates.clear();
+
+        auto start = std::chrono::steady_clock::now();
+        BallImageProc::ComputeCandidateAngleImages(dimple_image,
+                                                   search_space,
+                                                   candidate_elements_mat,
+                                                   candidate_elements_mat_size,
+                                                   candidates,
+                                                   ball);
+        auto end = std::chrono::steady_clock::now();
+
+        double total_ms = std::chrono::duration<double, std::milli>(end - start).count();
+        return total_ms / (double)std::max<size_t>(1, candidates.size());
+    }
+
+    static constexpr int kImageSize = 126;
+    static constexpr int kBallCenter = 63;
+    static constexpr double kBallRadius = 60.0;
+
+    GolfBall ball;
+    cv::Mat dimple_image;
+    BallImageProc::RotationSearchSpace search_space;
+};
+
+// The table-driven projection skips the intermediate integer truncation of the
+// original per-pixel rotation, so a handful of pixels may land one position
+// over.  Otherwise the candidate images should be the same.
+TEST_F(SpinAnalysisTest, SphereProjectionCacheMatchesDirectProjection) {
+    std::vector<RotationCandidate> direct_candidates;
+    std::vector<RotationCandidate> cached_candidates;
+
+    TimeCandidateImages(false, direct_candidates);
+    TimeCandidateImages(true, cached_candidates);
+
+    ASSERT_EQ(direct_candidates.size(), cached_candidates.size());
+    ASSERT_FALSE(direct_candidates.empty());
+
+    for (size_t i = 0; i < direct_candidates.size(); i++)
+    {
+        const cv::Mat &direct = direct_candidates[i].img;
+        const cv::Mat &cached = cached_candidates[i].img;
+
+        int matching = 0;
+        for (int x = 0; x < kImageSize; x++)
+        {
+            for (int y = 0; y < kImageSize; y++)
+            {
+                if (direct.at<cv::Vec2i>(x, y)[1] == cached.at<cv::Vec2i>(x, y)[1])
+                {
+                    matching++;
+                }
+            }
+        }
+
+        double match_ratio = (double)matching / (double)(kImageSize * kImageSize);
+        EXPECT_GT(match_ratio, 0.97) << "Candidate #" << i << " Rot: (" <<
+            direct_candidates[i].x_rotation_degrees << ", " <<
+            direct_candidates[i].y_rotation_degrees << ", " <<
+            direct_candidates[i].z_rotation_degrees << ")";
+    }
+}
+
+// Micro-benchmark of the per-candidate projection time with and without the
+// cached sphere projection table.
+TEST_F(SpinAnalysisTest, SphereProjectionCacheBenchmark) {
+    const int kIterations = 5;
+    std::vector<RotationCandidate> candidates;
+
+    // Warm up both paths (and build the table) before timing anything
+    TimeCandidateImages(false, candidates);
+    TimeCandidateImages(true, candidates);
+
+    double direct_ms = 0.0;
+    double cached_ms = 0.0;
+
+    for (int i = 0; i < kIterations; i++)
+    {
+        direct_ms += TimeCandidateImages(false, candidates);
+        cached_ms += TimeCandidateImages(true, candidates);
+    }
+
+    direct_ms /= kIterations;
+    cached_ms /= kIterations;
+
+    std::cout << std::fixed << std::setprecision(4)
+              << "Per-candidate projection time (" << candidates.size() << " candidates): "
+              << direct_ms << "ms direct, " << cached_ms << "ms cached ("
+              << (cached_ms > 0.0 ? direct_ms / cached_ms : 0.0) << "x).\n";
+
+    EXPECT_GT(direct_ms, 0.0);
+    EXPECT_GT(cached_ms, 0.0);
+}
+
+// The packed comparison must give exactly the same counts as the byte-wise
+// comparison, including for widths that are not a multiple of 64 bits
+TEST_F(SpinAnalysisTest, BitplaneComparisonMatchesByteComparison) {
+    const uchar pixel_values[3] = { 0, kPixelIgnoreValue, 255 };
+    cv::RNG rng(54321);
+
+    for (int size : { 63, 64, 65, 126, 200 })
+    {
+        cv::Mat target(size, size, CV_8UC1);
+        int sizes[2] = { size, size };
+        cv::Mat candidate(2, sizes, CV_32SC2, cv::Scalar(0, kPixelIgnoreValue));
+
+        for (int x = 0; x < size; x++)
+        {
+            for (int y = 0; y < size; y++)
+            {
+                target.at<uchar>(x, y) = pixel_values[rng.uniform(0, 3)];
+                candidate.at<cv::Vec2i>(x, y)[1] = pixel_values[rng.uniform(0, 3)];
+            }
+        }
+
+        BitplaneImage packed_target;
+        BitplaneImage packed_candidate;
+        BitplaneImage::Pack(target, kPixelIgnoreValue, packed_target);
+        BitplaneImage::Pack(candidate, kPixelIgnoreValue, packed_candidate);
+
+        cv::Vec2i expected = BallImageProc::CompareRotationImage(target, candidate);
+        cv::Vec2i packed = BitplaneImage::Compare(packed_target, packed_candidate);
+        cv::Vec2i packed_scalar = BitplaneImage::CompareScalar(packed_target, packed_candidate);
+
+        EXPECT_EQ(packed, expected) << "Image size " << size;
+        EXPECT_EQ(packed_scalar, expected) << "Image size " << size;
+    }
+}
+
+// Both the streaming and the materialized-candidate searches should recover a
+// known (on-grid) rotation of the dimple image
+TEST_F(SpinAnalysisTest, StreamingScoringFindsKnownRotation) {
+    const cv::Vec3i known_rotation(6, 5, 12);
+
+    cv::Mat target_image;
+    BallImageProc::GetRotatedImage(dimple_image, ball, known_rotation, target_image);
+
+    cv::Mat candidate_elements_mat;
+    cv::Vec3i candidate_elements_mat_size;
+    std::vector<RotationCandidate> candidates;
+    std::vector<std::string> csv_data;
+
+    BallImageProc::ComputeCandidateAngleImages(dimple_image,
+                                               search_space,
+                                               candidate_elements_mat,
+                                               candidate_elements_mat_size,
+                                               candidates,
+                                               ball);
+    int materialized_index = BallImageProc::CompareCandidateAngleImages(&target_image,
+                                                                        &candidate_elements_mat,
+                                                                        &candidate_elements_mat_size,
+                                                                        &candidates,
+                                                                        csv_data);
+    ASSERT_GE(materialized_index, 0);
+
+    std::vector<RotationCandidate> streamed_candidates;
+    int streamed_index = BallImageProc::ScoreCandidateAngles(dimple_image,
+                                                             target_image,
+                                                             search_space,
+                                                             ball,
+                                                             streamed_candidates,
+                                                             csv_data);
+    ASSERT_GE(streamed_index, 0);
+
+    ASSERT_EQ(candidates.size(), streamed_candidates.size());
+    EXPECT_EQ(csv_data.size(), streamed_candidates.size());
+
+    const RotationCandidate &materialized = candidates[materialized_index];
+    const RotationCandidate &streamed = streamed_candidates[streamed_index];
+
+    EXPECT_EQ(cv::Vec3i(materialized.x_rotation_degrees,
+                        materialized.y_rotation_degrees,
+                        materialized.z_rotation_degrees), known_rotation);
+    EXPECT_EQ(cv::Vec3i(streamed.x_rotation_degrees,
+                        streamed.y_rotation_degrees,
+                        streamed.z_rotation_degrees), known_rotation);
+
+    // The streaming search never keeps the candidate images
+    EXPECT_TRUE(streamed.img.empty());
+    EXPECT_TRUE(streamed.packed_img.empty());
+}
+
+// Downsampling must keep the image to the three dimple-image values, and the
+// area outside the ball must stay ignored
+TEST_F(SpinAnalysisTest, DownsampledDimpleImageStaysTernary) {
+    for (int factor : { 2, 4 })
+    {
+        cv::Mat reduced = BallImageProc::DownsampleDimpleImage(dimple_image, factor);
+
+        ASSERT_EQ(reduced.rows, kImageSize / factor);
+        ASSERT_EQ(reduced.cols, kImageSize / factor);
+
+        int on_pixels = 0;
+        for (int x = 0; x < reduced.rows; x++)
+        {
+            for (int y = 0; y < reduced.cols; y++)
+            {
+                uchar p = reduced.at<uchar>(x, y);
+                EXPECT_TRUE(p == 0 || p == 255 || p == kPixelIgnoreValue);
+                on_pixels += (p == 255) ? 1 : 0;
+            }
+        }
+
+        EXPECT_GT(on_pixels, 0) << "Factor " << factor;
+        EXPECT_EQ(reduced.at<uchar>(0, 0), kPixelIgnoreValue) << "Factor " << factor;
+    }
+}
+
+// ApplyGaborFilterToBall as it was before the filter bank response was shared
+// between ratchet steps: every threshold that is tried re-filters the image
+// and counts the pixels that cv::threshold turns white.  The parameters are
+// those that ApplyGaborFilterToBall uses.
+static cv::Mat ReferenceGaborFilter(const cv::Mat &img_f32,
+                                    float binary_threshold,
+                                    int &white_percent)
+{
+    cv::Mat dest;
+    cv::Mat accum = cv::Mat::zeros(img_f32.rows, img_f32.cols, CV_32F);
+
+    for (double theta = 0; theta <= 360.0; theta += 11.25)
+    {
+        cv::Mat kernel = cv::getGaborKernel(cv::Size(21, 21), 1.0, theta * CV_PI / 180, 6.0, 0.2,
+                                            90.0 * CV_PI / 180, CV_32F);
+        cv::filter2D(img_f32, dest, CV_32F, kernel);
+        cv::max(accum, dest, accum);
+    }
+
+    cv::Mat accum_gray;
+    accum.convertTo(accum_gray, CV_8U, 255, 0);
+
+    cv::Mat dimple_edges;
+    cv::threshold(accum_gray, dimple_edges, (int)std::round(binary_threshold * 10.), 255,
+                  cv::THRESH_BINARY);
+
+    white_percent = (int)std::round(((double)cv::countNonZero(dimple_edges) * 100.) /
+                                    ((double)dimple_edges.rows * dimple_edges.cols));
+
+    return dimple_edges;
+}
+
+static cv::Mat ReferenceApplyGaborFilterToBall(const cv::Mat &image_gray,
+                                               float &calibrated_binary_threshold)
+{
+    cv::Mat img_f32;
+    image_gray.convertTo(img_f32, CV_32F, 1.0 / 255, 0);
+
+    float binary_threshold = 11.0f;
+    int white_percent = 0;
+    cv::Mat dimple_image = ReferenceGaborFilter(img_f32, binary_threshold, white_percent);
+
+    const int min_white = BallImageProc::kGaborMinWhitePercent;
+    const int max_white = BallImageProc::kGaborMaxWhitePercent;
+    bool ratcheting_down = (white_percent < min_white);
+
+    if (white_percent < min_white || white_percent >= max_white)
+    {
+        while (white_percent < min_white || white_percent >= max_white)
+        {
+            if (ratcheting_down)
+            {
+                binary_threshold -= (min_white - white_percent > 5) ? 1.0f : 0.5f;
+            }
+            else
+            {
+                binary_threshold += (white_percent - max_white > 5) ? 1.0f : 0.5f;
+            }
+
+            dimple_image = ReferenceGaborFilter(img_f32, binary_threshold, white_percent);
+
+            if (binary_threshold > 30 || binary_threshold < 2)
+            {
+                break;
+            }
+        }
+
+        calibrated_binary_threshold = binary_threshold;
+    }
+
+    return dimple_image;
+}
+
+// Reading the white percentages from a histogram of a single filter response
+// must ratchet to the same threshold, and give the same image, as re-filtering
+// at every step did
+TEST(GaborFilterTest, HistogramRatchetMatchesIterativeFiltering) {
+    const int image_size = 120;
+    const double ball_radius = 60.0;
+
+    GolfBall ball;
+    ball.measured_radius_pixels_ = ball_radius;
+    ball.ball_circle_[2] = (float)ball_radius;
+    ball.set_x((float)ball_radius);
+    ball.set_y((float)ball_radius);
+
+    int ratcheted_images = 0;
+
+    // From flat (far too little response) to high-contrast noise (far too
+    // much), so that the ratchet has to go both ways
+    for (double contrast : { 0.0, 0.05, 0.2, 0.5, 1.0 })
+    {
+        for (int blur_size : { 3, 7 })
+        {
+            cv::Mat noise(image_size, image_size, CV_8UC1);
+            cv::RNG rng(1000 + blur_size);
+            rng.fill(noise, cv::RNG::UNIFORM, 0, 256);
+            cv::GaussianBlur(noise, noise, cv::Size(blur_size, blur_size), 0);
+
+            cv::Mat image_gray;
+            noise.convertTo(image_gray, CV_8U, contrast, 128.0 * (1.0 - contrast));
+
+            float expected_threshold = -1.0f;
+            cv::Mat expected = ReferenceApplyGaborFilterToBall(image_gray, expected_threshold);
+
+            float threshold = -1.0f;
+            cv::Mat result = BallImageProc::ApplyGaborFilterToBall(image_gray, ball, threshold);
+
+            SCOPED_TRACE("contrast " + std::to_string(contrast) + ", blur " +
+                         std::to_string(blur_size));
+
+            EXPECT_EQ(threshold, expected_threshold);
+            ASSERT_EQ(result.size(), expected.size());
+            ASSERT_EQ(result.type(), expected.type());
+            EXPECT_EQ(cv::countNonZero(result != expected), 0);
+            EXPECT_EQ(cv::countNonZero(result), cv::countNonZero(expected));
+
+            if (expected_threshold > 0)
+            {
+                ratcheted_images++;
+            }
+        }
+    }
+
+    EXPECT_GT(ratcheted_images, 0);
+}
+
+// The pyramid search only refines around the best coarse survivors, but should
+// still end up at the same (full-resolution) answer as the flat search
+TEST_F(SpinAnalysisTest, PyramidSearchFindsKnownRotation) {
+    const cv::Vec3i known_rotation(6, 5, 12);
+
+    cv::Mat target_image;
+    BallImageProc::GetRotatedImage(dimple_image, ball, known_rotation, target_image);
+
+    BallImageProc::kSpinPyramidLevels = 2;
+    BallImageProc::kSpinPyramidTopK = 4;
+    BallImageProc::kSpinPyramidLevelXIncrementDegrees = { 6.0f, 3.0f };
+    BallImageProc::kSpinPyramidLevelYIncrementDegrees = { 10.0f, 5.0f };
+    BallImageProc::kSpinPyramidLevelZIncrementDegrees = { 6.0f, 3.0f };
+
+    std::vector<RotationCandidate> candidates;
+    std::vector<std::string> csv_data;
+    cv::Vec3i final_increments;
+
+    int best_index = BallImageProc::FindBestRotationCandidatePyramid(dimple_image,
+                                                                     target_image,
+                                                                     search_space,
+                                                                     ball,
+                                                                     candidates,
+                                                                     csv_data,
+                                                                     final_increments);
+    ASSERT_GE(best_index, 0);
+
+    const RotationCandidate &best = candidates[best_index];
+    EXPECT_EQ(cv::Vec3i(best.x_rotation_degrees,
+                        best.y_rotation_degrees,
+                        best.z_rotation_degrees), known_rotation);
+    EXPECT_EQ(final_increments, cv::Vec3i(3, 5, 3));
+
+    // Only the neighborhoods of the survivors are searched at full resolution
+    EXPECT_LE(candidates.size(), (size_t)(4 * 3 * 3 * 3));
+}
+
+// Each axis follows its own schedule, and an axis without one falls back to
+// its coarse increment scaled by the level's downsampling factor
+TEST_F(SpinAnalysisTest, PyramidSearchUsesPerAxisIncrements) {
+    cv::Mat target_image;
+    BallImageProc::GetRotatedImage(dimple_image, ball, cv::Vec3i(6, 5, 12), target_image);
+
+    BallImageProc::kSpinPyramidLevels = 2;
+    BallImageProc::kSpinPyramidTopK = 1;
+    BallImageProc::kSpinPyramidLevelYIncrementDegrees = { 10.0f, 5.0f };
+
+    std::vector<RotationCandidate> candidates;
+    std::vector<std::string> csv_data;
+    cv::Vec3i final_increments;
+
+    int best_index = BallImageProc::FindBestRotationCandidatePyramid(dimple_image,
+                                                                     target_image,
+                                                                     search_space,
+                                                                     ball,
+                                                                     candidates,
+                                                                     csv_data,
+                                                                     final_increments);
+    ASSERT_GE(best_index, 0);
+    EXPECT_EQ(final_increments, cv::Vec3i(6, 5, 6));
+}
+
+// Starting a little away from a known rotation, the optimizer should get to
+// within about a degree of it using far fewer evaluations than a 1-degree grid
+// over the same window would need
+TEST_F(SpinAnalysisTest, OptimizerRefinesToKnownRotation) {
+    const cv::Vec3i known_rotation(6, 5, 12);
+
+    cv::Mat target_image;
+    BallImageProc::GetRotatedImage(dimple_image, ball, known_rotation, target_image);
+
+    std::vector<std::string> csv_data;
+    cv::Vec3d best_rotation;
+
+    int evaluations = BallImageProc::OptimizeRotation(dimple_image,
+                                                      target_image,
+                                                      ball,
+                                                      cv::Vec3d(4.0, 3.0, 10.0),
+                                                      cv::Vec3d(3.0, 3.0, 3.0),
+                                                      0.0,
+                                                      best_rotation,
+                                                      csv_data);
+
+    EXPECT_EQ((size_t)evaluations, csv_data.size());
+    EXPECT_LE(evaluations, BallImageProc::kSpinOptimizerMaxEvaluations + 4);
+    EXPECT_LT(evaluations, 7 * 7 * 7);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        EXPECT_NEAR(best_rotation[axis], (double)known_rotation[axis], 1.5) << "Axis " << axis;
+    }
+}
+
+// Abandoning candidates part way through must not change the winner or its
+// score, and the abandoned candidates must never look better than the winner
+TEST_F(SpinAnalysisTest, BranchAndBoundKeepsSameWinner) {
+    const cv::Vec3i known_rotation(6, 5, 12);
+
+    cv::Mat target_image;
+    BallImageProc::GetRotatedImage(dimple_image, ball, known_rotation, target_image);
+
+    std::vector<RotationCandidate> full_candidates;
+    std::vector<RotationCandidate> bounded_candidates;
+    std::vector<std::string> csv_data;
+
+    BallImageProc::kUseBranchAndBoundCandidateScoring = false;
+    int full_index = BallImageProc::ScoreCandidateAngles(dimple_image,
+                                                         target_image,
+                                                         search_space,
+                                                         ball,
+                                                         full_candidates,
+                                                         csv_data);
+
+    BallImageProc::kUseBranchAndBoundCandidateScoring = true;
+    int bounded_index = BallImageProc::ScoreCandidateAngles(dimple_image,
+                                                            target_image,
+                                                            search_space,
+                                                            ball,
+                                                            bounded_candidates,
+                                                            csv_data);
+
+    ASSERT_GE(full_index, 0);
+    ASSERT_EQ(full_index, bounded_index);
+    ASSERT_EQ(full_candidates.size(), bounded_candidates.size());
+
+    EXPECT_EQ(bounded_candidates[bounded_index].pixels_matching,
+              full_candidates[full_index].pixels_matching);
+    EXPECT_EQ(bounded_candidates[bounded_index].pixels_examined,
+              full_candidates[full_index].pixels_examined);
+
+    int abandoned = 0;
+    for (size_t i = 0; i < full_candidates.size(); i++)
+    {
+        // The examined counts are always exact, and the matching counts are
+        // exact unless the candidate was abandoned, in which case they are an
+        // upper bound
+        EXPECT_EQ(bounded_candidates[i].pixels_examined, full_candidates[i].pixels_examined);
+        EXPECT_GE(bounded_candidates[i].pixels_matching, full_candidates[i].pixels_matching);
+        abandoned += (bounded_candidates[i].pixels_matching !=
+                      full_candidates[i].pixels_matching) ? 1 : 0;
+    }
+
+    std::cout << "Branch-and-bound abandoned (at least) " << abandoned << " of " <<
+        bounded_candidates.size() << " candidates.\n";
+}
+
+// The flat candidate table and the candidate records it is converted to must
+// agree, including on which candidate is best
+TEST_F(SpinAnalysisTest, CandidateTableMatchesCandidates) {
+    const cv::Vec3i known_rotation(-6, 5, 6);
+
+    cv::Mat target_image;
+    BallImageProc::GetRotatedImage(dimple_image, ball, known_rotation, target_image);
+
+    std::vector<RotationCandidate> candidates;
+    std::vector<std::string> csv_data;
+
+    BallImageProc::kUseBranchAndBoundCandidateScoring = false;
+    int best_index = BallImageProc::ScoreCandidateAngles(dimple_image,
+                                                         target_image,
+                                                         search_space,
+                                                         ball,
+                                                         candidates,
+                                                         csv_data);
+    ASSERT_GE(best_index, 0);
+
+    RotationCandidateTable table;
+    table.AppendCandidates(candidates);
+    ASSERT_EQ(table.size(), candidates.size());
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        RotationCandidate c = table.GetCandidate(i);
+        EXPECT_EQ(c.index, (int)i);
+        EXPECT_EQ(c.index, candidates[i].index);
+        EXPECT_EQ(c.x_rotation_degrees, candidates[i].x_rotation_degrees);
+        EXPECT_EQ(c.y_rotation_degrees, candidates[i].y_rotation_degrees);
+        EXPECT_EQ(c.z_rotation_degrees, candidates[i].z_rotation_degrees);
+        EXPECT_EQ(c.pixels_examined, candidates[i].pixels_examined);
+        EXPECT_EQ(c.pixels_matching, candidates[i].pixels_matching);
+        EXPECT_DOUBLE_EQ(c.score, candidates[i].score);
+    }
+
+    EXPECT_EQ(BallImageProc::SelectBestRotationCandidate(table), best_index);
+    EXPECT_EQ(BallImageProc::SelectBestRotationCandidate(candidates), best_index);
+
+    const RotationCandidate &best = candidates[best_index];
+    EXPECT_EQ(best.x_rotation_degrees, known_rotation[0]);
+    EXPECT_EQ(best.y_rotation_degrees, known_rotation[1]);
+    EXPECT_EQ(best.z_rotation_degrees, known_rotation[2]);
+}
+
+// Fine-grained search ranges can need more candidates than fit in a short
+TEST(RotationCandidateTableTest, IndexesBeyondShortRange) {
+    RotationCandidateTable table;
+
+    for (int i = 0; i < 40000; i++)
+    {
+        table.Append(i % 100, (i / 100) % 100, i / 10000);
+    }
+
+    RotationCandidate c = table.GetCandidate(39999);
+    EXPECT_EQ(c.index, 39999);
+    EXPECT_EQ(c.x_rotation_degrees, 99);
+    EXPECT_EQ(c.y_rotation_degrees, 99);
+    EXPECT_EQ(c.z_rotation_degrees, 3);
+}
+
+// The prior window comes from the club's configured band until there is
+// enough history for the club, and always stays on the full search grid
+TEST_F(SpinAnalysisTest, SpinPriorNarrowsSearchSpace) {
+    BallImageProc::RotationSearchSpace full;
+    full.anglex_rotation_degrees_increment = 4;
+    full.anglex_rotation_degrees_start = -36;
+    full.anglex_rotation_degrees_end = 36;
+    full.angley_rotation_degrees_increment = 5;
+    full.angley_rotation_degrees_start = -15;
+    full.angley_rotation_degrees_end = 15;
+    full.anglez_rotation_degrees_increment = 4;
+    full.anglez_rotation_degrees_start = -10;
+    full.anglez_rotation_degrees_end = 110;
+
+    BallImageProc::RotationSearchSpace prior;
+
+    // Nothing configured or remembered for the club
+    EXPECT_FALSE(BallImageProc::GetSpinPriorSearchSpace(full,
+                                                        GolfSimClubs::GsClubType::kDriver,
+                                                        prior));
+    EXPECT_EQ(prior.anglez_rotation_degrees_end, full.anglez_rotation_degrees_end);
+
+    BallImageProc::kSpinPriorDriverRange = { -36.f, 36.f, -15.f, 15.f, -10.f, 60.f };
+    ASSERT_TRUE(BallImageProc::GetSpinPriorSearchSpace(full,
+                                                       GolfSimClubs::GsClubType::kDriver,
+                                                       prior));
+    EXPECT_EQ(prior.anglex_rotation_degrees_start, -36);
+    EXPECT_EQ(prior.anglex_rotation_degrees_end, 36);
+    EXPECT_EQ(prior.anglez_rotation_degrees_start, -10);
+    EXPECT_EQ(prior.anglez_rotation_degrees_end, 62);
+
+    // Once there are enough recent shots, they re-center the window
+    for (int i = 0; i < BallImageProc::kSpinPriorMinHistoryShots; i++)
+    {
+        BallImageProc::RecordSpinPriorResult(GolfSimClubs::GsClubType::kDriver,
+                                             cv::Vec3d(-1.0 + i, 0.0, 39.0 + i));
+    }
+
+    double window = BallImageProc::kSpinPriorHistoryWindowDegrees;
+    ASSERT_TRUE(BallImageProc::GetSpinPriorSearchSpace(full,
+                                                       GolfSimClubs::GsClubType::kDriver,
+                                                       prior));
+    EXPECT_LE(prior.anglex_rotation_degrees_start, -window);
+    EXPECT_GE(prior.anglex_rotation_degrees_end, window);
+    EXPECT_LE(prior.anglez_rotation_degrees_start, 40.0 - window);
+    EXPECT_GE(prior.anglez_rotation_degrees_end, 40.0 + window);
+    EXPECT_EQ((prior.anglez_rotation_degrees_start - full.anglez_rotation_degrees_start) %
+              full.anglez_rotation_degrees_increment, 0);
+
+    // Other clubs are not affected
+    EXPECT_FALSE(BallImageProc::GetSpinPriorSearchSpace(full,
+                                                        GolfSimClubs::GsClubType::kIron,
+                                                        prior));
+}
+
+// A pair whose spin rate is far from the median of the pairs is dropped, and
+// the rest are averaged as rates over the mean interval of the pairs used
+TEST(SpinPairFusionTest, DropsOutlierPairs) {
+    // Degrees per uS, which is 500, -250 and 3000 RPM
+    const cv::Vec3d rate(0.003, -0.0015, 0.018);
+    const std::vector<double> intervals_uS = { 1000.0, 1500.0, 1200.0, 2000.0 };
+
+    std::vector<cv::Vec3d> rotations;
+
+    for (double interval_uS : intervals_uS)
+    {
+        rotations.push_back(rate * interval_uS);
+    }
+
+    // About 3700 RPM too fast on the Z axis
+    rotations[2][2] = 0.04 * intervals_uS[2];
+
+    cv::Vec3d fused_rotation;
+    double fused_interval_uS = 0.0;
+
+    ASSERT_TRUE(BallImageProc::FuseSpinPairRotations(rotations, intervals_uS, 1500.0, 2,
+                                                     fused_rotation, fused_interval_uS));
+
+    EXPECT_NEAR(fused_interval_uS, (1000.0 + 1500.0 + 2000.0) / 3.0, 1e-9);
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        EXPECT_NEAR(fused_rotation[axis], rate[axis] * fused_interval_uS, 1e-9) << "Axis " << axis;
+    }
+
+    // With the outlier dropped, there are too few pairs left for a minimum of
+    // four
+    EXPECT_FALSE(BallImageProc::FuseSpinPairRotations(rotations, intervals_uS, 1500.0, 4,
+                                                      fused_rotation, fused_interval_uS));
+}
+
+// Consistent pairs are weighted by the square of their interval, so the pair
+// measured over three times as long counts nine times as much
+TEST(SpinPairFusionTest, WeightsPairsByIntervalSquared) {
+    const std::vector<double> intervals_uS = { 1000.0, 3000.0 };
+    const std::vector<cv::Vec3d> rotations = { cv::Vec3d(0.0, 0.0, 0.018 * 1000.0),
+                                               cv::Vec3d(0.0, 0.0, 0.020 * 3000.0) };
+
+    cv::Vec3d fused_rotation;
+    double fused_interval_uS = 0.0;
+
+    // The two rates are about 330 RPM apart, so both are kept
+    ASSERT_TRUE(BallImageProc::FuseSpinPairRotations(rotations, intervals_uS, 1500.0, 2,
+                                                     fused_rotation, fused_interval_uS));
+
+    const double expected_rate = (0.018 * 1.0 + 0.020 * 9.0) / 10.0;
+
+    EXPECT_NEAR(fused_interval_uS, 2000.0, 1e-9);
+    EXPECT_NEAR(fused_rotation[0], 0.0, 1e-9);
+    EXPECT_NEAR(fused_rotation[1], 0.0, 1e-9);
+    EXPECT_NEAR(fused_rotation[2], expected_rate * 2000.0, 1e-9);
+
+    // A tighter tolerance drops both, as each is half the difference away
+    // from the median
+    EXPECT_FALSE(BallImageProc::FuseSpinPairRotations(rotations, intervals_uS, 100.0, 1,
+                                                      fused_rotation, fused_interval_uS));
+}
+}
@@ -0,0 +1,220 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "Infrastructure/ImageProcessing/UndistortionMapCache.h"
+
+namespace PiTrac
+{
+class UndistortionMapCacheTest : public ::testing::Test
+{
+  protected:
+    void SetUp() override
+    {
+        // Roughly the IMX296 camera with a 3.6mm lens
+        calibration_matrix = (cv::Mat_<double>(3, 3) <<
+                              1000.0, 0.0, 728.0,
+                              0.0, 1000.0, 544.0,
+                              0.0, 0.0, 1.0);
+        distortion_vector = (cv::Mat_<double>(1, 5) << -0.5, 0.3, 0.0, 0.0, -0.1);
+
+        image = cv::Mat(1088, 1456, CV_8UC1);
+        cv::randu(image, 0, 256);
+        cv::GaussianBlur(image, image, cv::Size(7, 7), 0);
+
+        directory = std::filesystem::temp_directory_path() / "pitrac_undistortion_map_test";
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(directory);
+    }
+
+    // What undistortion did before the maps were cached
+    cv::Mat UndistortWithFloatMaps() const
+    {
+        cv::Mat map1;
+        cv::Mat map2;
+        cv::initUndistortRectifyMap(calibration_matrix, distortion_vector, cv::Mat(),
+                                    calibration_matrix, image.size(), CV_32FC1, map1, map2);
+
+        cv::Mat result;
+        cv::remap(image, result, map1, map2, cv::INTER_LINEAR);
+        return result;
+    }
+
+    cv::Mat calibration_matrix;
+    cv::Mat distortion_vector;
+    cv::Mat image;
+    std::filesystem::path directory;
+};
+
+TEST_F(UndistortionMapCacheTest, BuildsMapsOnlyOnce) {
+    UndistortionMapCache cache;
+    cv::Mat map1;
+    cv::Mat map2;
+
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), map1, map2);
+    EXPECT_EQ(map1.type(), CV_16SC2);
+    EXPECT_EQ(map2.type(), CV_16UC1);
+
+    cv::Mat second_map1;
+    cv::Mat second_map2;
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), second_map1,
+                  second_map2);
+
+    EXPECT_EQ(cache.NumberOfBuilds(), 1);
+    EXPECT_EQ(map1.data, second_map1.data);
+
+    // The same values as floats are the same calibration
+    cv::Mat float_calibration_matrix;
+    calibration_matrix.convertTo(float_calibration_matrix, CV_32F);
+    cache.GetMaps(2, float_calibration_matrix, distortion_vector, image.size(), second_map1,
+                  second_map2);
+    EXPECT_EQ(cache.NumberOfBuilds(), 1);
+
+    // Another camera or resolution needs its own maps
+    cache.GetMaps(1, calibration_matrix, distortion_vector, image.size(), second_map1,
+                  second_map2);
+    cache.GetMaps(2, calibration_matrix, distortion_vector, cv::Size(728, 544), second_map1,
+                  second_map2);
+    EXPECT_EQ(cache.NumberOfBuilds(), 3);
+}
+
+TEST_F(UndistortionMapCacheTest, RebuildsWhenCalibrationChanges) {
+    UndistortionMapCache cache;
+    cv::Mat map1;
+    cv::Mat map2;
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), map1, map2);
+    cv::Mat original_map1 = map1.clone();
+
+    distortion_vector.at<double>(0, 0) = -0.4;
+
+    cv::Mat new_map1;
+    cv::Mat new_map2;
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), new_map1, new_map2);
+
+    EXPECT_EQ(cache.NumberOfBuilds(), 2);
+    EXPECT_GT(cv::norm(new_map1, map1, cv::NORM_INF), 0.0);
+
+    // Maps that were handed out earlier are left alone
+    EXPECT_EQ(cv::norm(map1, original_map1, cv::NORM_INF), 0.0);
+}
+
+TEST_F(UndistortionMapCacheTest, MatchesFloatMaps) {
+    UndistortionMapCache cache;
+    cv::Mat undistorted;
+    cache.Undistort(image, 2, calibration_matrix, distortion_vector, undistorted);
+
+    cv::Mat expected = UndistortWithFloatMaps();
+
+    // The fixed-point maps interpolate to 1/32 of a pixel
+    cv::Mat difference;
+    cv::absdiff(undistorted, expected, difference);
+    EXPECT_LE(cv::mean(difference)[0], 1.0);
+    EXPECT_LE(cv::norm(difference, cv::NORM_INF), 8.0);
+}
+
+TEST_F(UndistortionMapCacheTest, KeepsFloatMapsSeparately) {
+    UndistortionMapCache cache;
+    cv::Mat map1;
+    cv::Mat map2;
+
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), map1, map2);
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), map1, map2,
+                  CV_32FC1);
+    EXPECT_EQ(map1.type(), CV_32FC1);
+    EXPECT_EQ(map2.type(), CV_32FC1);
+    EXPECT_EQ(cache.NumberOfBuilds(), 2);
+
+    // Both kinds stay cached
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), map1, map2);
+    EXPECT_EQ(map1.type(), CV_16SC2);
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), map1, map2,
+                  CV_32FC1);
+    EXPECT_EQ(cache.NumberOfBuilds(), 2);
+
+    // Float maps give exactly what undistortion did before the maps were
+    // cached
+    cv::Mat undistorted;
+    cache.Undistort(image, 2, calibration_matrix, distortion_vector, undistorted, CV_32FC1);
+    EXPECT_EQ(cv::norm(undistorted, UndistortWithFloatMaps(), cv::NORM_INF), 0.0);
+}
+
+TEST_F(UndistortionMapCacheTest, ReadsPersistedMaps) {
+    cv::Mat map1;
+    cv::Mat map2;
+
+    {
+        UndistortionMapCache cache;
+        cache.SetPersistenceDirectory(directory.string());
+        cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), map1, map2);
+        EXPECT_EQ(cache.NumberOfBuilds(), 1);
+    }
+
+    // As after a restart
+    UndistortionMapCache cache;
+    cache.SetPersistenceDirectory(directory.string());
+
+    cv::Mat read_map1;
+    cv::Mat read_map2;
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), read_map1, read_map2);
+
+    EXPECT_EQ(cache.NumberOfBuilds(), 0);
+    EXPECT_EQ(cv::norm(read_map1, map1, cv::NORM_INF), 0.0);
+    EXPECT_EQ(cv::norm(read_map2, map2, cv::NORM_INF), 0.0);
+
+    // Float maps have their own file
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), read_map1, read_map2,
+                  CV_32FC1);
+    EXPECT_EQ(cache.NumberOfBuilds(), 1);
+
+    cache.Clear();
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), read_map1, read_map2,
+                  CV_32FC1);
+    EXPECT_EQ(cache.NumberOfBuilds(), 1);
+    EXPECT_EQ(read_map1.type(), CV_32FC1);
+
+    // A file from another calibration is not used
+    cache.Clear();
+    distortion_vector.at<double>(0, 1) = 0.2;
+    cache.GetMaps(2, calibration_matrix, distortion_vector, image.size(), read_map1, read_map2);
+    EXPECT_EQ(cache.NumberOfBuilds(), 2);
+}
+
+// Not a pass/fail test - compares per-frame undistortion before and after
+// the maps were cached
+TEST_F(UndistortionMapCacheTest, UndistortBenchmark) {
+    const int iterations = 20;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        UndistortWithFloatMaps();
+    }
+
+    auto float_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+    UndistortionMapCache cache;
+    cv::Mat undistorted;
+    cache.Undistort(image, 2, calibration_matrix, distortion_vector, undistorted);
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        cache.Undistort(image, 2, calibration_matrix, distortion_vector, undistorted);
+    }
+
+    auto cached_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / iterations;
+
+    std::cout << "Build float maps and remap: " << float_ms << " ms" << std::endl;
+    std::cout << "Cached fixed-point maps and remap: " << cached_ms << " ms" << std::endl;
+}
+}
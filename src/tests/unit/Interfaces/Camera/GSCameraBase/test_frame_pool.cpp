@@ -0,0 +1,136 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <opencv2/opencv.hpp>
+#include "Interfaces/Camera/GSCameraBase/FramePool.h"
+
+namespace PiTrac
+{
+TEST(FramePoolTest, ReusesReleasedFrames) {
+    FramePool pool;
+    pool.reset(2, 4, 10, 20, CV_8UC3);
+    EXPECT_EQ(pool.size(), 2u);
+    EXPECT_EQ(pool.allocationCount(), 2u);
+
+    uchar *first_data = nullptr;
+
+    {
+        cv::Mat frame = pool.acquire();
+        ASSERT_EQ(frame.rows, 10);
+        ASSERT_EQ(frame.cols, 20);
+        ASSERT_EQ(frame.type(), CV_8UC3);
+        first_data = frame.data;
+    }
+
+    // Frames are handed out in turn, so the other preallocated one is next,
+    // and then the first one again
+    cv::Mat second = pool.acquire();
+    EXPECT_NE(second.data, first_data);
+    second.release();
+
+    cv::Mat third = pool.acquire();
+    EXPECT_EQ(third.data, first_data);
+    EXPECT_EQ(pool.allocationCount(), 2u);
+}
+
+TEST(FramePoolTest, NeverHandsOutAFrameInUse) {
+    FramePool pool;
+    pool.reset(1, 3, 4, 4, CV_8UC1);
+
+    cv::Mat a = pool.acquire();
+    cv::Mat a_copy = a;  // A second holder, such as the frame buffer
+    a.release();
+
+    cv::Mat b = pool.acquire();
+    EXPECT_NE(b.data, a_copy.data);
+
+    cv::Mat c = pool.acquire();
+    EXPECT_NE(c.data, a_copy.data);
+    EXPECT_NE(c.data, b.data);
+    EXPECT_EQ(pool.size(), 3u);
+
+    // Full, so a frame that is not pooled is returned
+    cv::Mat d = pool.acquire();
+    EXPECT_FALSE(d.empty());
+    EXPECT_EQ(pool.size(), 3u);
+
+    // Frames stay valid after the pool is cleared
+    a_copy.setTo(7);
+    pool.clear();
+    EXPECT_EQ(a_copy.at<uchar>(0, 0), 7);
+}
+
+TEST(FramePoolTest, HeldFrameIsNotOverwritten) {
+    FramePool pool;
+    pool.reset(2, 4, 4, 4, CV_8UC1);
+
+    // As captureFrame() returns the latest frame to the caller without a copy
+    cv::Mat latest = pool.acquire();
+    latest.setTo(1);
+    cv::Mat returned = latest;
+
+    for (int i = 2; i < 10; i++)
+    {
+        latest = pool.acquire();
+        latest.setTo(i);
+    }
+
+    EXPECT_EQ(returned.at<uchar>(0, 0), 1);
+    EXPECT_EQ(latest.at<uchar>(0, 0), 9);
+    EXPECT_LE(pool.allocationCount(), 4u);
+}
+
+// Not a pass/fail test - a consumer that holds the last few frames, as the
+// frame buffer does, against a new (cloned) frame per camera frame
+TEST(FramePoolTest, SteadyStateBenchmark) {
+    const int frames = 300;
+    const size_t held_frames = 8;
+    cv::Mat camera_buffer(1088, 1456, CV_8UC3, cv::Scalar(1, 2, 3));
+
+    FramePool pool;
+    pool.reset(4, held_frames + 4, camera_buffer.rows, camera_buffer.cols, CV_8UC3);
+    std::deque<cv::Mat> held;
+
+    auto start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < frames; i++)
+    {
+        cv::Mat frame = pool.acquire();
+        camera_buffer.copyTo(frame);
+        held.push_back(frame);
+
+        if (held.size() > held_frames)
+        {
+            held.pop_front();
+        }
+    }
+
+    auto pool_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / frames;
+
+    EXPECT_LE(pool.allocationCount(), held_frames + 4);
+    held.clear();
+
+    start = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < frames; i++)
+    {
+        cv::Mat frame = camera_buffer.clone();
+        held.push_back(frame.clone());
+
+        if (held.size() > held_frames)
+        {
+            held.pop_front();
+        }
+    }
+
+    auto clone_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::high_resolution_clock::now() - start).count() / frames;
+
+    std::cout << "Pooled frame: " << pool_ms << " ms, " << pool.allocationCount()
+              << " allocations" << std::endl;
+    std::cout << "Cloned frames: " << clone_ms << " ms, " << 2 * frames << " allocations"
+              << std::endl;
+}
+}
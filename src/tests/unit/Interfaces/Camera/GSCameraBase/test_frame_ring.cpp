@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <opencv2/opencv.hpp>
+#include "Interfaces/Camera/GSCameraBase/FrameRing.h"
+
+namespace PiTrac
+{
+// A tiny frame that carries its frame number
+static cv::Mat MakeFrame(int number)
+{
+    return cv::Mat(1, 1, CV_32SC1, cv::Scalar(number));
+}
+
+static int FrameNumber(const cv::Mat &frame)
+{
+    return frame.at<int>(0, 0);
+}
+
+TEST(FrameRingTest, DrainsFramesOldestFirst) {
+    FrameRing ring(4);
+    EXPECT_TRUE(ring.empty());
+
+    for (int i = 0; i < 3; ++i)
+    {
+        ring.push(MakeFrame(i));
+    }
+    EXPECT_EQ(ring.size(), 3u);
+
+    std::vector<cv::Mat> frames;
+    EXPECT_EQ(ring.drain(frames), 3u);
+    ASSERT_EQ(frames.size(), 3u);
+    for (int i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ(FrameNumber(frames[i]), i);
+    }
+
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.drain(frames), 0u);
+}
+
+TEST(FrameRingTest, OverwritesOldestWhenFull) {
+    FrameRing ring(4);
+
+    for (int i = 0; i < 10; ++i)
+    {
+        ring.push(MakeFrame(i));
+    }
+    EXPECT_EQ(ring.size(), 4u);
+
+    // Overwriting a frame is not the same as dropping a new one
+    EXPECT_EQ(ring.droppedFrames(), 0u);
+
+    std::vector<cv::Mat> frames;
+    ASSERT_EQ(ring.drain(frames), 4u);
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(FrameNumber(frames[i]), 6 + i);
+    }
+}
+
+TEST(FrameRingTest, PopLatestDiscardsOlderFrames) {
+    FrameRing ring(8);
+    EXPECT_TRUE(ring.popLatest().empty());
+
+    for (int i = 0; i < 5; ++i)
+    {
+        ring.push(MakeFrame(i));
+    }
+
+    cv::Mat latest = ring.popLatest();
+    ASSERT_FALSE(latest.empty());
+    EXPECT_EQ(FrameNumber(latest), 4);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_TRUE(ring.popLatest().empty());
+
+    ring.push(MakeFrame(5));
+    EXPECT_EQ(FrameNumber(ring.popLatest()), 5);
+}
+
+TEST(FrameRingTest, ReleasesFramesItNoLongerHolds) {
+    FrameRing ring(2);
+    cv::Mat frame = MakeFrame(1);
+
+    ring.push(frame);
+    ring.push(MakeFrame(2));
+    ring.push(MakeFrame(3));  // Overwrites frame
+
+    // Only this Mat still refers to the data
+    EXPECT_EQ(frame.u->refcount, 1);
+
+    ring.push(frame);
+    ring.clear();
+    EXPECT_EQ(frame.u->refcount, 1);
+    EXPECT_TRUE(ring.empty());
+
+    ring.push(frame);
+    ring.push(MakeFrame(4));
+    ring.popLatest();
+    EXPECT_EQ(frame.u->refcount, 1);
+}
+
+TEST(FrameRingTest, ResetChangesCapacity) {
+    FrameRing ring(2);
+    ring.push(MakeFrame(0));
+
+    ring.reset(5);
+    EXPECT_EQ(ring.capacity(), 5u);
+    EXPECT_TRUE(ring.empty());
+
+    for (int i = 0; i < 5; ++i)
+    {
+        ring.push(MakeFrame(i));
+    }
+    EXPECT_EQ(ring.size(), 5u);
+}
+
+TEST(FrameRingTest, ConcurrentProducerAndConsumer) {
+    const int number_of_frames = 200000;
+    FrameRing ring(16);
+
+    std::thread producer([&]()
+        {
+            for (int i = 0; i < number_of_frames; ++i)
+            {
+                ring.push(MakeFrame(i));
+            }
+        });
+
+    // Frames may be dropped, but those received must be in order
+    int last = -1;
+    int received = 0;
+    std::vector<cv::Mat> frames;
+
+    while (last < number_of_frames - 1)
+    {
+        frames.clear();
+
+        if (received % 2 == 0)
+        {
+            ring.drain(frames);
+        }
+        else
+        {
+            cv::Mat latest = ring.popLatest();
+            if (!latest.empty())
+            {
+                frames.push_back(latest);
+            }
+        }
+
+        for (const cv::Mat &frame : frames)
+        {
+            ASSERT_GT(FrameNumber(frame), last);
+            last = FrameNumber(frame);
+        }
+        received += (int)frames.size();
+    }
+
+    producer.join();
+
+    EXPECT_GT(received, 0);
+    EXPECT_TRUE(ring.empty());
+    EXPECT_EQ(ring.droppedFrames(), 0u);
+}
+
+TEST(FrameRingTest, BenchmarkAgainstLockedQueue) {
+    const int number_of_frames = 200000;
+    const size_t capacity = 100;
+    cv::Mat frame = MakeFrame(0);
+
+    // The queue this replaced: a mutex-guarded std::queue, trimmed by the
+    // producer
+    std::mutex mutex;
+    std::queue<cv::Mat> queue;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < number_of_frames; ++i)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push(frame);
+        while (queue.size() > capacity)
+        {
+            queue.pop();
+        }
+    }
+    auto queue_ns = std::chrono::duration<double, std::nano>(
+        std::chrono::high_resolution_clock::now() - start).count() / number_of_frames;
+
+    FrameRing ring(capacity);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < number_of_frames; ++i)
+    {
+        ring.push(frame);
+    }
+    auto ring_ns = std::chrono::duration<double, std::nano>(
+        std::chrono::high_resolution_clock::now() - start).count() / number_of_frames;
+
+    std::cout << "Push: locked queue " << queue_ns << " ns, ring " << ring_ns << " ns"
+              << std::endl;
+
+    EXPECT_EQ(ring.size(), capacity);
+}
+} // namespace PiTrac
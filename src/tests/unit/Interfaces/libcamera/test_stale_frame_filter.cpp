@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include "Interfaces/libcamera/StaleFrameFilter.h"
+
+namespace PiTrac
+{
+// A warm still capture takes the first queued frame exposed at or after the
+// request, and skips the ones that were already waiting
+TEST(StaleFrameFilterTest, SkipsFramesFromBeforeTheRequest) {
+    const int64_t kRequestTimeNs = 5000000000LL;
+    const int64_t kFrameIntervalNs = 33000000LL;
+
+    // Frames waiting in the queue, oldest first, as the camera completes them
+    std::queue<int64_t> frame_timestamps;
+
+    for (int i = -3; i < 3; ++i)
+    {
+        frame_timestamps.push(kRequestTimeNs + i * kFrameIntervalNs + 1);
+    }
+
+    StaleFrameFilter filter(kRequestTimeNs);
+    std::optional<int64_t> used_timestamp;
+
+    while (!frame_timestamps.empty())
+    {
+        int64_t timestamp = frame_timestamps.front();
+        frame_timestamps.pop();
+
+        if (filter.Accept(timestamp))
+        {
+            used_timestamp = timestamp;
+            break;
+        }
+    }
+
+    ASSERT_TRUE(used_timestamp.has_value());
+    EXPECT_EQ(*used_timestamp, kRequestTimeNs + 1);
+    EXPECT_EQ(filter.SkippedFrames(), 3);
+    EXPECT_EQ(frame_timestamps.size(), 2u);
+}
+
+TEST(StaleFrameFilterTest, HandlesMissingTimestampsAndImages) {
+    const int64_t kRequestTimeNs = 1000;
+
+    StaleFrameFilter filter(kRequestTimeNs);
+
+    // A frame exposed exactly at the request is new enough
+    EXPECT_TRUE(filter.Accept(kRequestTimeNs));
+
+    // Without a timestamp, a frame cannot be shown to be stale
+    EXPECT_TRUE(filter.Accept(std::nullopt));
+
+    // A frame without the still image is no use, however new it is
+    EXPECT_FALSE(filter.Accept(kRequestTimeNs + 10, false));
+    EXPECT_FALSE(filter.Accept(kRequestTimeNs - 1));
+    EXPECT_EQ(filter.SkippedFrames(), 2);
+}
+}